@@ -0,0 +1,603 @@
+/**
+ * Batch conversion routines. These work on structure-of-arrays buffers
+ * (one contiguous array per component) instead of on individual
+ * coordinate objects, so the inner loops can be vectorized. Use as
+ * batch_converter<to_type>()(from arrays..., to arrays..., count)
+ *
+ * The kernels are kept out of line (FR_NOINLINE), so every caller runs
+ * the same machine code. With -ffast-math the vector and scalar
+ * versions of sin and friends can differ in the last bit, and the
+ * compiler is free to reorder arithmetic differently in each place a
+ * kernel is inlined, so an inlined copy could round differently from
+ * the serial one. parallel_converts.hpp counts on this to produce
+ * the same output as a serial run.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "coordinates.hpp"
+#include "fast_math.hpp"
+#include "instrumentation.hpp"
+#include <Eigen/Core>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#ifndef _HPP_BATCH_CONVERTS
+#define _HPP_BATCH_CONVERTS
+
+// Keeps a kernel out of line and, on gcc, uncloned. clang doesn't know
+// noclone and warns about it, so it only gets noinline.
+#if defined(__GNUC__) && !defined(__clang__)
+#define FR_NOINLINE __attribute__((noinline, noclone))
+#else
+#define FR_NOINLINE __attribute__((noinline))
+#endif
+
+namespace fr {
+
+  namespace coordinates {
+
+    template <typename convert_to>
+    struct batch_converter {
+
+    };
+
+    /***************************************************************
+     * Batch convert to lat_long bits here
+     */
+
+    template <>
+    struct batch_converter<lat_long> {
+
+      // ecef to latlong. Writes latitude and longitude in degrees and
+      // altitude in meters. Any solver from geodetic_solvers.hpp can be
+      // used. The default vermeille_solver and bowring_solver have no
+      // data dependent branches and vectorize the same way the ecef
+      // conversion does. iterative_solver works but won't vectorize.
+      // The arrays can be float instead of double, which gets twice as
+      // many points per vector instruction, with vermeille_solver or
+      // bowring_solver.
+      template <typename solver = vermeille_solver, typename scalar = double>
+      FR_NOINLINE typename std::enable_if<is_geodetic_solver<solver>::value>::type
+      operator()(const scalar * __restrict__ x, const scalar * __restrict__ y, const scalar * __restrict__ z, scalar * __restrict__ lat, scalar * __restrict__ lon, scalar * __restrict__ alt, size_t count, const ellipsoid_parameters &e = WGS84_ELLIPSOID, const solver &solve = solver())
+      {
+	FR_COORDINATES_BATCH(count);
+	kernel(x, y, z, lat, lon, alt, count, e, solve);
+      }
+
+      // Same thing on the kernel set simd_dispatch.hpp picked for this
+      // CPU, solved with basic_vermeille_solver<math>
+      template <typename math>
+      void operator()(const double *x, const double *y, const double *z, double *lat, double *lon, double *alt, size_t count, const ellipsoid_parameters &e, const dispatched<math> &)
+      {
+	FR_COORDINATES_BATCH(count);
+	dispatched<math>::kernels().ecef_to_lat_long(x, y, z, lat, lon, alt, count, e);
+      }
+
+      // The loop itself, inlined into operator() above and into each of
+      // the instruction set specific copies in simd_dispatch.hpp
+      template <typename scalar, typename solver>
+      __attribute__((always_inline)) static void kernel(const scalar * __restrict__ x, const scalar * __restrict__ y, const scalar * __restrict__ z, scalar * __restrict__ lat, scalar * __restrict__ lon, scalar * __restrict__ alt, size_t count, const ellipsoid_parameters &e, const solver &solve)
+      {
+	for (size_t i = 0; i < count; ++i) {
+	  solve(x[i], y[i], z[i], e, lat[i], lon[i], alt[i]);
+	}
+      }
+
+      // Same thing for positions given as offsets from a local origin,
+      // as written by the local origin ecef conversion. The solve is
+      // done in double, so the only precision lost is in storing the
+      // results.
+      template <typename in_scalar, typename out_scalar, typename solver = vermeille_solver>
+      FR_NOINLINE typename std::enable_if<is_geodetic_solver<solver>::value>::type
+      operator()(const in_scalar * __restrict__ x, const in_scalar * __restrict__ y, const in_scalar * __restrict__ z, out_scalar * __restrict__ lat, out_scalar * __restrict__ lon, out_scalar * __restrict__ alt, size_t count, const ecef_point &origin, const ellipsoid_parameters &e = WGS84_ELLIPSOID, const solver &solve = solver())
+      {
+	FR_COORDINATES_BATCH(count);
+	for (size_t i = 0; i < count; ++i) {
+	  double la, lo, al;
+	  solve(origin.x + (double) x[i], origin.y + (double) y[i], origin.z + (double) z[i], e, la, lo, al);
+	  lat[i] = (out_scalar) la;
+	  lon[i] = (out_scalar) lo;
+	  alt[i] = (out_scalar) al;
+	}
+      }
+
+      // enu_point or ned_point to latlong, using the frame's ellipsoid.
+      // Each point is rotated back to ECEF and solved in double.
+      template <typename frame, typename out_scalar, typename solver = vermeille_solver, typename in_scalar = double>
+      FR_NOINLINE typename std::enable_if<is_local_frame<frame>::value && is_geodetic_solver<solver>::value>::type
+      operator()(const xyz_point<frame, in_scalar> * __restrict__ in, out_scalar * __restrict__ lat, out_scalar * __restrict__ lon, out_scalar * __restrict__ alt, size_t count, const local_frame &f, const solver &solve = solver())
+      {
+	FR_COORDINATES_BATCH(count);
+	// Copied out so the stores through out can't force reloads
+	const Eigen::Matrix3d r = f.get_rotation(frame());
+	const ecef_point origin = f.get_origin();
+	const ellipsoid_parameters &e = f.get_ellipsoid();
+	for (size_t i = 0; i < count; ++i) {
+	  double x = origin.x + r(0,0) * in[i].x + r(1,0) * in[i].y + r(2,0) * in[i].z;
+	  double y = origin.y + r(0,1) * in[i].x + r(1,1) * in[i].y + r(2,1) * in[i].z;
+	  double z = origin.z + r(0,2) * in[i].x + r(1,2) * in[i].y + r(2,2) * in[i].z;
+	  double la, lo, al;
+	  solve(x, y, z, e, la, lo, al);
+	  lat[i] = (out_scalar) la;
+	  lon[i] = (out_scalar) lo;
+	  alt[i] = (out_scalar) al;
+	}
+      }
+
+    };
+
+    /*********************************************************
+     * Batch convert to ECEF bits here
+     */
+
+    template <>
+    struct batch_converter<ecef> {
+
+      // latlong to ecef. Latitude and longitude are in degrees, altitude
+      // in meters, same as lat_long. The loop body has no branches and
+      // no calls other than sin/sqrt, so with -O3 -ffast-math gcc will
+      // use the glibc vector math routines. Cosines are taken as
+      // sin(x + pi/2) because gcc fuses sin and cos of the same angle
+      // into a sincos call, which it can't vectorize. Works on float
+      // arrays too, good to a couple of meters, most of which is the
+      // rounding of a float latitude and longitude to begin with.
+      // Output arrays must not overlap the input arrays. Pass
+      // fast_math() as the last argument to get the trig vectorized
+      // without -ffast-math; see fast_math.hpp.
+      template <typename scalar, typename math = precise_math>
+      FR_NOINLINE void operator()(const scalar * __restrict__ lat, const scalar * __restrict__ lon, const scalar * __restrict__ alt, scalar * __restrict__ x, scalar * __restrict__ y, scalar * __restrict__ z, size_t count, const ellipsoid_parameters &e = WGS84_ELLIPSOID, const math & = math())
+      {
+	FR_COORDINATES_BATCH(count);
+	kernel<scalar, math>(lat, lon, alt, x, y, z, count, e);
+      }
+
+      // Same thing on the kernel set simd_dispatch.hpp picked for this
+      // CPU
+      template <typename math>
+      void operator()(const double *lat, const double *lon, const double *alt, double *x, double *y, double *z, size_t count, const ellipsoid_parameters &e, const dispatched<math> &)
+      {
+	FR_COORDINATES_BATCH(count);
+	dispatched<math>::kernels().lat_long_to_ecef(lat, lon, alt, x, y, z, count, e);
+      }
+
+      // The loop itself, inlined into operator() above and into each of
+      // the instruction set specific copies in simd_dispatch.hpp
+      template <typename scalar, typename math>
+      __attribute__((always_inline)) static void kernel(const scalar * __restrict__ lat, const scalar * __restrict__ lon, const scalar * __restrict__ alt, scalar * __restrict__ x, scalar * __restrict__ y, scalar * __restrict__ z, size_t count, const ellipsoid_parameters &e)
+      {
+	for (size_t i = 0; i < count; ++i) {
+	  geodetic_to_ecef<math>(lat[i], lon[i], alt[i], e, x[i], y[i], z[i]);
+	}
+      }
+
+      // latlong to ecef, written as offsets from a local origin. The
+      // conversion and the subtraction are done in double, so float
+      // offsets keep millimeter precision within a few kilometers of
+      // the origin, instead of the half meter an absolute float ECEF
+      // position gets.
+      template <typename in_scalar, typename out_scalar, typename math = precise_math>
+      FR_NOINLINE void operator()(const in_scalar * __restrict__ lat, const in_scalar * __restrict__ lon, const in_scalar * __restrict__ alt, out_scalar * __restrict__ x, out_scalar * __restrict__ y, out_scalar * __restrict__ z, size_t count, const ecef_point &origin, const ellipsoid_parameters &e = WGS84_ELLIPSOID, const math & = math())
+      {
+	FR_COORDINATES_BATCH(count);
+	const double ox = origin.x;
+	const double oy = origin.y;
+	const double oz = origin.z;
+	for (size_t i = 0; i < count; ++i) {
+	  double px, py, pz;
+	  geodetic_to_ecef<math>((double) lat[i], (double) lon[i], (double) alt[i], e, px, py, pz);
+	  x[i] = (out_scalar) (px - ox);
+	  y[i] = (out_scalar) (py - oy);
+	  z[i] = (out_scalar) (pz - oz);
+	}
+      }
+
+    };
+
+    /***************************************************************
+     * Batch rotations through the inertial_frames.hpp chain, from any of
+     * ecef_point, j2000_point and teme_point to any of those or to a true
+     * of date tod_eci_point. tod_eci_point isn't taken as input, for the
+     * reason given at is_chain_source_frame. With
+     * a frame_rotation for the whole batch it's one matrix product. With
+     * a time per point the rotations come from a frame_chain, so the
+     * nutation series is evaluated once per chain step rather than once
+     * per point, and runs of equal times share one rotation.
+     */
+
+    template <typename to_frame>
+    struct inertial_batch_converter {
+      typedef xyz_point<to_frame> point_type;
+
+      template <typename from_frame, typename scalar>
+      FR_NOINLINE typename std::enable_if<is_chain_source_frame<from_frame>::value>::type
+      operator()(const xyz_point<from_frame, scalar> *in, xyz_point<to_frame, scalar> *out, size_t count, const frame_rotation &r)
+      {
+	FR_COORDINATES_BATCH(count);
+	typedef Eigen::Map<const Eigen::Matrix<scalar,3,Eigen::Dynamic> > const_positions;
+	typedef Eigen::Map<Eigen::Matrix<scalar,3,Eigen::Dynamic> > positions;
+	const Eigen::Matrix3d rot = r.template get<from_frame,to_frame>();
+	const_positions from(&in->x, 3, count);
+	positions to(&out->x, 3, count);
+	to.noalias() = rot.lazyProduct(from.template cast<double>()).template cast<scalar>();
+      }
+
+      template <typename from_frame, typename scalar>
+      FR_NOINLINE typename std::enable_if<is_chain_source_frame<from_frame>::value>::type
+      operator()(const xyz_point<from_frame, scalar> *in, const double *times, xyz_point<to_frame, scalar> *out, size_t count, frame_chain &chain)
+      {
+	FR_COORDINATES_BATCH(count);
+	typedef Eigen::Matrix<scalar,3,1> vector;
+	Eigen::Matrix3d rot;
+	for (size_t i = 0; i < count; ++i) {
+	  if (i == 0 || times[i] != times[i - 1]) {
+	    rot = chain(times[i]).template get<from_frame,to_frame>();
+	  }
+	  Eigen::Map<const vector> from(&in[i].x);
+	  Eigen::Map<vector> to(&out[i].x);
+	  to.noalias() = (rot * from.template cast<double>()).template cast<scalar>();
+	}
+      }
+
+    };
+
+    template <>
+    struct batch_converter<j2000_point> : public inertial_batch_converter<j2000_frame> {
+    };
+
+    template <>
+    struct batch_converter<teme_point> : public inertial_batch_converter<teme_frame> {
+    };
+
+    /***************************************************************
+     * Batch ECI/ECEF rotations. These work on arrays of the value types
+     * from xyz_point.hpp, which are laid out as plain rows of scalars,
+     * so the whole batch goes through one rotation as a single matrix
+     * product. Pass a time or an eci_ecef_rotation for the epoch shared
+     * by every point. Output arrays must not overlap the input arrays.
+     * The points can be the float typedefs (ecef_point_f and so on);
+     * the rotation is still done in double and only the stores round.
+     */
+
+    template <>
+    struct batch_converter<ecef_point> {
+
+      // tod_eci_point to ecef_point
+      template <typename scalar>
+      FR_NOINLINE void operator()(const xyz_point<tod_eci_frame, scalar> *in, xyz_point<ecef_frame, scalar> *out, size_t count, const eci_ecef_rotation &r)
+      {
+	FR_COORDINATES_BATCH(count);
+	typedef Eigen::Map<const Eigen::Matrix<scalar,3,Eigen::Dynamic> > const_positions;
+	typedef Eigen::Map<Eigen::Matrix<scalar,3,Eigen::Dynamic> > positions;
+	const_positions from(&in->x, 3, count);
+	positions to(&out->x, 3, count);
+	to.noalias() = r.get().lazyProduct(from.template cast<double>()).template cast<scalar>();
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_point<tod_eci_frame, scalar> *in, xyz_point<ecef_frame, scalar> *out, size_t count, const double &at_time)
+      {
+	(*this)(in, out, count, eci_ecef_rotation(at_time));
+      }
+
+      // tod_eci_point to ecef_point where every point has its own time.
+      // Hour angles come from a gha_interpolator, a chunk at a time, then
+      // the z-axis rotations are applied in a loop with no calls but sin,
+      // which vectorizes the same way the lat_long conversion does.
+      template <typename scalar>
+      void operator()(const xyz_point<tod_eci_frame, scalar> *in, const double *times, xyz_point<ecef_frame, scalar> *out, size_t count)
+      {
+	gha_interpolator gha;
+	(*this)(in, times, out, count, gha);
+      }
+
+      // Same thing, reusing a gha_interpolator across calls
+      template <typename scalar>
+      FR_NOINLINE void operator()(const xyz_point<tod_eci_frame, scalar> *in, const double *times, xyz_point<ecef_frame, scalar> *out, size_t count, gha_interpolator &gha)
+      {
+	FR_COORDINATES_BATCH(count);
+	const double half_pi = fr::constants::pi / 2.0;
+	double angle[chunk_size];
+	for (size_t start = 0; start < count; start += chunk_size) {
+	  size_t n = (count - start < chunk_size) ? count - start : (size_t) chunk_size;
+	  for (size_t i = 0; i < n; ++i) {
+	    angle[i] = gha(times[start + i]);
+	  }
+	  const xyz_point<tod_eci_frame, scalar> * __restrict__ from = in + start;
+	  xyz_point<ecef_frame, scalar> * __restrict__ to = out + start;
+	  for (size_t i = 0; i < n; ++i) {
+	    double st = sin(angle[i]);
+	    double ct = sin(angle[i] + half_pi);
+	    double x = from[i].x;
+	    double y = from[i].y;
+	    to[i].x = (scalar) (ct * x + st * y);
+	    to[i].y = (scalar) (ct * y - st * x);
+	    to[i].z = from[i].z;
+	  }
+	}
+      }
+
+      // j2000_point or teme_point to ecef_point, through the full chain
+      template <typename frame, typename scalar>
+      typename std::enable_if<is_chain_source_frame<frame>::value>::type
+      operator()(const xyz_point<frame, scalar> *in, xyz_point<ecef_frame, scalar> *out, size_t count, const frame_rotation &r)
+      {
+	inertial_batch_converter<ecef_frame>()(in, out, count, r);
+      }
+
+      template <typename frame, typename scalar>
+      typename std::enable_if<is_chain_source_frame<frame>::value>::type
+      operator()(const xyz_point<frame, scalar> *in, const double *times, xyz_point<ecef_frame, scalar> *out, size_t count, frame_chain &chain)
+      {
+	inertial_batch_converter<ecef_frame>()(in, times, out, count, chain);
+      }
+
+      // enu_point or ned_point to ecef_point
+      template <typename frame, typename scalar>
+      FR_NOINLINE typename std::enable_if<is_local_frame<frame>::value>::type
+      operator()(const xyz_point<frame, scalar> * __restrict__ in, xyz_point<ecef_frame, scalar> * __restrict__ out, size_t count, const local_frame &f)
+      {
+	FR_COORDINATES_BATCH(count);
+	const Eigen::Matrix3d r = f.get_rotation(frame());
+	const ecef_point origin = f.get_origin();
+	for (size_t i = 0; i < count; ++i) {
+	  double x = in[i].x;
+	  double y = in[i].y;
+	  double z = in[i].z;
+	  out[i].x = (scalar) (origin.x + r(0,0) * x + r(1,0) * y + r(2,0) * z);
+	  out[i].y = (scalar) (origin.y + r(0,1) * x + r(1,1) * y + r(2,1) * z);
+	  out[i].z = (scalar) (origin.z + r(0,2) * x + r(1,2) * y + r(2,2) * z);
+	}
+      }
+
+      enum { chunk_size = 256 };
+
+    };
+
+    template <>
+    struct batch_converter<tod_eci_point> {
+
+      // ecef_point to tod_eci_point
+      template <typename scalar>
+      FR_NOINLINE void operator()(const xyz_point<ecef_frame, scalar> *in, xyz_point<tod_eci_frame, scalar> *out, size_t count, const eci_ecef_rotation &r)
+      {
+	FR_COORDINATES_BATCH(count);
+	typedef Eigen::Map<const Eigen::Matrix<scalar,3,Eigen::Dynamic> > const_positions;
+	typedef Eigen::Map<Eigen::Matrix<scalar,3,Eigen::Dynamic> > positions;
+	const_positions from(&in->x, 3, count);
+	positions to(&out->x, 3, count);
+	to.noalias() = r.get_inverse().lazyProduct(from.template cast<double>()).template cast<scalar>();
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_point<ecef_frame, scalar> *in, xyz_point<tod_eci_frame, scalar> *out, size_t count, const double &time_at)
+      {
+	(*this)(in, out, count, eci_ecef_rotation(time_at));
+      }
+
+      // ecef_point, j2000_point or teme_point to true of date
+      template <typename frame, typename scalar>
+      typename std::enable_if<is_chain_source_frame<frame>::value>::type
+      operator()(const xyz_point<frame, scalar> *in, xyz_point<tod_eci_frame, scalar> *out, size_t count, const frame_rotation &r)
+      {
+	inertial_batch_converter<tod_eci_frame>()(in, out, count, r);
+      }
+
+      template <typename frame, typename scalar>
+      typename std::enable_if<is_chain_source_frame<frame>::value>::type
+      operator()(const xyz_point<frame, scalar> *in, const double *times, xyz_point<tod_eci_frame, scalar> *out, size_t count, frame_chain &chain)
+      {
+	inertial_batch_converter<tod_eci_frame>()(in, times, out, count, chain);
+      }
+
+    };
+
+    // State vectors. The 6x6 state matrix is [R 0; R' R], so rather than
+    // doing a full 6x6 multiply per point each one gets pos = R r and
+    // vel = R' r + R v, in a single pass over the batch.
+
+    template <>
+    struct batch_converter<ecef_vel_point> {
+
+      // tod_eci_vel_point to ecef_vel_point
+      template <typename scalar>
+      FR_NOINLINE void operator()(const xyz_state<tod_eci_frame, scalar> *in, xyz_state<ecef_frame, scalar> *out, size_t count, const eci_ecef_rotation &r)
+      {
+	FR_COORDINATES_BATCH(count);
+	typedef Eigen::Matrix<scalar,3,1> vector;
+	const Eigen::Matrix3d rot = r.get();
+	const Eigen::Matrix3d rot_dot = r.get_dot();
+	for (size_t i = 0; i < count; ++i) {
+	  const Eigen::Vector3d pos = Eigen::Map<const vector>(&in[i].x).template cast<double>();
+	  const Eigen::Vector3d vel = Eigen::Map<const vector>(&in[i].dx).template cast<double>();
+	  Eigen::Map<vector>(&out[i].x).noalias() = (rot * pos).template cast<scalar>();
+	  Eigen::Map<vector>(&out[i].dx).noalias() = (rot_dot * pos + rot * vel).template cast<scalar>();
+	}
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_state<tod_eci_frame, scalar> *in, xyz_state<ecef_frame, scalar> *out, size_t count, const double &time_at)
+      {
+	(*this)(in, out, count, eci_ecef_rotation(time_at));
+      }
+
+      // tod_eci_vel_point to ecef_vel_point where every point has its own
+      // time. Works the same way as the ecef_point version.
+      template <typename scalar>
+      void operator()(const xyz_state<tod_eci_frame, scalar> *in, const double *times, xyz_state<ecef_frame, scalar> *out, size_t count)
+      {
+	gha_interpolator gha;
+	(*this)(in, times, out, count, gha);
+      }
+
+      // Same thing, reusing a gha_interpolator across calls
+      template <typename scalar>
+      FR_NOINLINE void operator()(const xyz_state<tod_eci_frame, scalar> *in, const double *times, xyz_state<ecef_frame, scalar> *out, size_t count, gha_interpolator &gha)
+      {
+	FR_COORDINATES_BATCH(count);
+	const double half_pi = fr::constants::pi / 2.0;
+	const double we = fr::constants::ut1_sideral_day_ratio * 2.0 * fr::constants::pi / fr::constants::secs_per_ut1_day;
+	double angle[chunk_size];
+	for (size_t start = 0; start < count; start += chunk_size) {
+	  size_t n = (count - start < chunk_size) ? count - start : (size_t) chunk_size;
+	  for (size_t i = 0; i < n; ++i) {
+	    angle[i] = gha(times[start + i]);
+	  }
+	  const xyz_state<tod_eci_frame, scalar> * __restrict__ from = in + start;
+	  xyz_state<ecef_frame, scalar> * __restrict__ to = out + start;
+	  for (size_t i = 0; i < n; ++i) {
+	    double st = sin(angle[i]);
+	    double ct = sin(angle[i] + half_pi);
+	    double x = from[i].x;
+	    double y = from[i].y;
+	    double dx = from[i].dx;
+	    double dy = from[i].dy;
+	    double rx = ct * x + st * y;
+	    double ry = ct * y - st * x;
+	    to[i].x = (scalar) rx;
+	    to[i].y = (scalar) ry;
+	    to[i].z = from[i].z;
+	    // R' r is we times R r rotated a further 90 degrees
+	    to[i].dx = (scalar) (ct * dx + st * dy + we * ry);
+	    to[i].dy = (scalar) (ct * dy - st * dx - we * rx);
+	    to[i].dz = from[i].dz;
+	  }
+	}
+      }
+
+      enum { chunk_size = 256 };
+
+    };
+
+    template <>
+    struct batch_converter<tod_eci_vel_point> {
+
+      // ecef_vel_point to tod_eci_vel_point
+      template <typename scalar>
+      FR_NOINLINE void operator()(const xyz_state<ecef_frame, scalar> *in, xyz_state<tod_eci_frame, scalar> *out, size_t count, const eci_ecef_rotation &r)
+      {
+	FR_COORDINATES_BATCH(count);
+	typedef Eigen::Matrix<scalar,3,1> vector;
+	const Eigen::Matrix3d rot = r.get_inverse();
+	const Eigen::Matrix3d rot_dot = r.get_inverse_dot();
+	for (size_t i = 0; i < count; ++i) {
+	  const Eigen::Vector3d pos = Eigen::Map<const vector>(&in[i].x).template cast<double>();
+	  const Eigen::Vector3d vel = Eigen::Map<const vector>(&in[i].dx).template cast<double>();
+	  Eigen::Map<vector>(&out[i].x).noalias() = (rot * pos).template cast<scalar>();
+	  Eigen::Map<vector>(&out[i].dx).noalias() = (rot_dot * pos + rot * vel).template cast<scalar>();
+	}
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_state<ecef_frame, scalar> *in, xyz_state<tod_eci_frame, scalar> *out, size_t count, const double &t)
+      {
+	(*this)(in, out, count, eci_ecef_rotation(t));
+      }
+
+    };
+
+    // The float point types convert with the same kernels
+    template <>
+    struct batch_converter<ecef_point_f> : public batch_converter<ecef_point> {
+    };
+
+    template <>
+    struct batch_converter<tod_eci_point_f> : public batch_converter<tod_eci_point> {
+    };
+
+    template <>
+    struct batch_converter<ecef_vel_point_f> : public batch_converter<ecef_vel_point> {
+    };
+
+    template <>
+    struct batch_converter<tod_eci_vel_point_f> : public batch_converter<tod_eci_vel_point> {
+    };
+
+    /*********************************************************
+     * Batch convert to enu_point and ned_point bits here. Same kernels
+     * for both, the frame tag just picks the rotation. The points can be
+     * enu_point_f or ned_point_f; the math is done in double either way.
+     */
+
+    template <typename frame>
+    struct local_batch_converter {
+      typedef xyz_point<frame> point_type;
+
+      // ecef_point to local. Output must not overlap the input.
+      template <typename scalar>
+      FR_NOINLINE void operator()(const xyz_point<ecef_frame, scalar> * __restrict__ in, xyz_point<frame, scalar> * __restrict__ out, size_t count, const local_frame &f)
+      {
+	FR_COORDINATES_BATCH(count);
+	const Eigen::Matrix3d r = f.get_rotation(frame());
+	const ecef_point origin = f.get_origin();
+	for (size_t i = 0; i < count; ++i) {
+	  double x = in[i].x - origin.x;
+	  double y = in[i].y - origin.y;
+	  double z = in[i].z - origin.z;
+	  out[i].x = (scalar) (r(0,0) * x + r(0,1) * y + r(0,2) * z);
+	  out[i].y = (scalar) (r(1,0) * x + r(1,1) * y + r(1,2) * z);
+	  out[i].z = (scalar) (r(2,0) * x + r(2,1) * y + r(2,2) * z);
+	}
+      }
+
+      // latlong to local, using the frame's ellipsoid. Latitude and
+      // longitude in degrees, altitude in meters. ECEF is computed with
+      // geodetic_to_ecef, as batch_converter<ecef> does it, then
+      // rotated, all in one pass. The arrays can be float; the math is
+      // done in double.
+      template <typename scalar, typename math = precise_math, typename out_scalar = double>
+      FR_NOINLINE void operator()(const scalar * __restrict__ lat, const scalar * __restrict__ lon, const scalar * __restrict__ alt, xyz_point<frame, out_scalar> * __restrict__ out, size_t count, const local_frame &f, const math & = math())
+      {
+	FR_COORDINATES_BATCH(count);
+	const ellipsoid_parameters &e = f.get_ellipsoid();
+	const Eigen::Matrix3d r = f.get_rotation(frame());
+	const ecef_point origin = f.get_origin();
+	for (size_t i = 0; i < count; ++i) {
+	  double x, y, z;
+	  geodetic_to_ecef<math>((double) lat[i], (double) lon[i], (double) alt[i], e, x, y, z);
+	  x -= origin.x;
+	  y -= origin.y;
+	  z -= origin.z;
+	  out[i].x = (out_scalar) (r(0,0) * x + r(0,1) * y + r(0,2) * z);
+	  out[i].y = (out_scalar) (r(1,0) * x + r(1,1) * y + r(1,2) * z);
+	  out[i].z = (out_scalar) (r(2,0) * x + r(2,1) * y + r(2,2) * z);
+	}
+      }
+
+    };
+
+    template <>
+    struct batch_converter<enu_point> : public local_batch_converter<enu_frame> {
+    };
+
+    template <>
+    struct batch_converter<ned_point> : public local_batch_converter<ned_frame> {
+    };
+
+    template <>
+    struct batch_converter<enu_point_f> : public local_batch_converter<enu_frame> {
+    };
+
+    template <>
+    struct batch_converter<ned_point_f> : public local_batch_converter<ned_frame> {
+    };
+
+  }
+
+}
+
+#endif
@@ -21,7 +21,9 @@
 
 #include "lat_long.hpp"
 #include "constants.hpp"
+#include "fast_math.hpp"
 #include <cmath>
+#include <cstddef>
 
 namespace fr {
 
@@ -46,6 +48,61 @@ namespace fr {
 	return bearing;
       }
 
+      /**
+       * One to many. Bearings from one point to count points given as
+       * latitude and longitude arrays (degrees.) The reference point's
+       * trig is done once, outside the loop. See also
+       * haversine_distance::distances_and_bearings if you need the
+       * distances too, and fast_math.hpp for the last argument.
+       */
+
+      template <typename math = precise_math>
+      void operator()(const lat_long &from, const double * __restrict__ lat, const double * __restrict__ lon, double * __restrict__ out, size_t count, const math & = math())
+      {
+	kernel<math>(from, lat, lon, out, count);
+      }
+
+      // Same thing on the kernel set simd_dispatch.hpp picked for this CPU
+      template <typename math>
+      void operator()(const lat_long &from, const double *lat, const double *lon, double *out, size_t count, const dispatched<math> &)
+      {
+	dispatched<math>::kernels().bearings(from, lat, lon, out, count);
+      }
+
+      // The loop itself, inlined into operator() and into each of the
+      // instruction set specific copies in simd_dispatch.hpp
+      template <typename math>
+      __attribute__((always_inline)) static void kernel(const lat_long &from, const double * __restrict__ lat, const double * __restrict__ lon, double * __restrict__ out, size_t count)
+      {
+	const double to_rad = fr::constants::pi / 180.0;
+	const double p1r = from.get_lat() * to_rad;
+	const double l1r = from.get_long() * to_rad;
+	const double sp1 = sin(p1r);
+	const double cp1 = cos(p1r);
+	for (size_t i = 0; i < count; ++i) {
+	  double p2r = lat[i] * to_rad;
+	  double dlon = lon[i] * to_rad - l1r;
+	  double sp2, cp2, sdlon, cdlon;
+	  math::sincos(p2r, sp2, cp2);
+	  math::sincos(dlon, sdlon, cdlon);
+	  double y = -sdlon * cp2;
+	  double x = cp1 * sp2 - sp1 * cp2 * cdlon;
+	  // Same as the single point fmod, without the call
+	  double b = math::atan2(y, x) * 180.0 / fr::constants::pi + 360.0;
+	  out[i] = (b >= 360.0) ? b - 360.0 : b;
+	}
+      }
+
+      // Many to many. n1 rows of n2 bearings, row i from point i of the
+      // first set to every point of the second.
+      template <typename math = precise_math>
+      void operator()(const double *lat1, const double *lon1, size_t n1, const double *lat2, const double *lon2, size_t n2, double *out, const math &m = math())
+      {
+	for (size_t i = 0; i < n1; ++i) {
+	  (*this)(lat_long(lat1[i], lon1[i]), lat2, lon2, out + i * n2, n2, m);
+	}
+      }
+
     };
 
   }
@@ -0,0 +1,132 @@
+/**
+ * Counts heap allocations in the single point conversion paths. The
+ * converters only use fixed size Eigen types and write their results
+ * through maps over the output point, so allocations_per_point should
+ * be 0 for all of them. Run with --benchmark_perf_counters=INSTRUCTIONS
+ * (libbenchmark built with libpfm) to compare instructions per point
+ * with the older 6x6 matrix path.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "bench_common.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace fr::coordinates;
+
+// Counting replacements for the global allocation functions. These
+// apply to the whole executable, so this file is linked into its own,
+// run_allocation_benchmarks, rather than into run_benchmarks.
+//
+// They're kept out of line. Otherwise GCC inlines the free() into
+// delete expressions on memory from the standard operator new it
+// knows about, and warns that the two don't match.
+
+static std::atomic<size_t> allocations(0);
+
+__attribute__((noinline)) void *operator new(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+__attribute__((noinline)) void *operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void *p) noexcept
+{
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+namespace {
+
+  void set_allocation_counters(benchmark::State &state, size_t count, size_t allocated)
+  {
+    bench::set_counters(state, count);
+    state.counters["allocations_per_point"] = (double) allocated / ((double) state.iterations() * (double) count);
+  }
+
+}
+
+// converter<> with a precomputed rotation context, one point per call
+template <typename convert_to, typename convert_from, typename context>
+static void allocations_each(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<convert_from> in = bench::make_points<convert_from>(count);
+  std::vector<convert_to> out(count);
+  context r(bench::epoch);
+  converter<convert_to> convert;
+  size_t start = allocations.load();
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = convert(in[i], r);
+    }
+    benchmark::ClobberMemory();
+  }
+  set_allocation_counters(state, count, allocations.load() - start);
+}
+
+// The old state vector path, through the 6x6 from eci_to_ecef and a
+// copied out 6 vector
+static void allocations_6x6_matrix(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<tod_eci_vel_point> in;
+  bench::fill_states(count, in);
+  std::vector<ecef_vel_point> out(count);
+  eci_to_ecef m(bench::epoch);
+  size_t start = allocations.load();
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      Eigen::Matrix<double,6,1> v = m.get_xyz_vel() * in[i].get_vector();
+      out[i] = ecef_vel_point(v(0), v(1), v(2), v(3), v(4), v(5));
+    }
+    benchmark::ClobberMemory();
+  }
+  set_allocation_counters(state, count, allocations.load() - start);
+}
+
+BENCHMARK_TEMPLATE(allocations_each, ecef_point, tod_eci_point, eci_ecef_rotation)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(allocations_each, tod_eci_point, ecef_point, eci_ecef_rotation)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(allocations_each, ecef_vel_point, tod_eci_vel_point, eci_ecef_rotation)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(allocations_each, tod_eci_vel_point, ecef_vel_point, eci_ecef_rotation)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(allocations_each, ecef_point, tod_eci, eci_ecef_rotation)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(allocations_each, ecef_point, j2000_point, frame_rotation)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(allocations_each, j2000_point, ecef_point, frame_rotation)->Apply(bench::batch_sizes);
+BENCHMARK(allocations_6x6_matrix)->Apply(bench::batch_sizes);
@@ -0,0 +1,424 @@
+/**
+ * Compares the batch conversions against calling the single point
+ * converters in a loop.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "bench_common.hpp"
+#include "coordinate_file.hpp"
+#include "stream_converter.hpp"
+#include <cstdio>
+#include <unistd.h>
+
+using bench::fill_lat_long;
+using bench::fill_states;
+
+static void scalar_lat_long_to_ecef(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  fill_lat_long(count, lat, lon, alt);
+  std::vector<fr::coordinates::lat_long> points;
+  points.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    points.push_back(fr::coordinates::lat_long(lat[i], lon[i], alt[i]));
+  }
+  fr::coordinates::converter<fr::coordinates::ecef> convert;
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      fr::coordinates::ecef result = convert(points[i]);
+      benchmark::DoNotOptimize(result);
+    }
+  }
+  bench::set_counters(state, count);
+}
+
+template <typename math>
+static void batch_lat_long_to_ecef(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  fill_lat_long(count, lat, lon, alt);
+  std::vector<double> x(count), y(count), z(count);
+  fr::coordinates::batch_converter<fr::coordinates::ecef> convert;
+  for (auto _ : state) {
+    convert(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count, fr::coordinates::WGS84_ELLIPSOID, math());
+    benchmark::DoNotOptimize(x.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void scalar_ecef_to_lat_long(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  fill_lat_long(count, lat, lon, alt);
+  std::vector<double> x(count), y(count), z(count);
+  fr::coordinates::batch_converter<fr::coordinates::ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count);
+  std::vector<fr::coordinates::ecef> points;
+  points.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    points.push_back(fr::coordinates::ecef(x[i], y[i], z[i]));
+  }
+  fr::coordinates::converter<fr::coordinates::lat_long> convert;
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      fr::coordinates::lat_long result = convert(points[i]);
+      benchmark::DoNotOptimize(result);
+    }
+  }
+  bench::set_counters(state, count);
+}
+
+template <typename solver>
+static void batch_ecef_to_lat_long(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  fill_lat_long(count, lat, lon, alt);
+  std::vector<double> x(count), y(count), z(count);
+  fr::coordinates::batch_converter<fr::coordinates::ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count);
+  fr::coordinates::batch_converter<fr::coordinates::lat_long> convert;
+  for (auto _ : state) {
+    convert(x.data(), y.data(), z.data(), lat.data(), lon.data(), alt.data(), count, fr::coordinates::WGS84_ELLIPSOID, solver());
+    benchmark::DoNotOptimize(lat.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+// Single precision versions of the batch conversions, twice as many
+// points per vector and half the memory traffic
+static void batch_lat_long_to_ecef_float(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  fill_lat_long(count, lat, lon, alt);
+  std::vector<float> latf(lat.begin(), lat.end()), lonf(lon.begin(), lon.end()), altf(alt.begin(), alt.end());
+  std::vector<float> x(count), y(count), z(count);
+  fr::coordinates::batch_converter<fr::coordinates::ecef> convert;
+  for (auto _ : state) {
+    convert(latf.data(), lonf.data(), altf.data(), x.data(), y.data(), z.data(), count);
+    benchmark::DoNotOptimize(x.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void batch_ecef_to_lat_long_float(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  fill_lat_long(count, lat, lon, alt);
+  std::vector<float> latf(lat.begin(), lat.end()), lonf(lon.begin(), lon.end()), altf(alt.begin(), alt.end());
+  std::vector<float> x(count), y(count), z(count);
+  fr::coordinates::batch_converter<fr::coordinates::ecef>()(latf.data(), lonf.data(), altf.data(), x.data(), y.data(), z.data(), count);
+  fr::coordinates::batch_converter<fr::coordinates::lat_long> convert;
+  for (auto _ : state) {
+    convert(x.data(), y.data(), z.data(), latf.data(), lonf.data(), altf.data(), count);
+    benchmark::DoNotOptimize(latf.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+// Double lat/long in, float offsets from a local origin out
+static void batch_lat_long_to_local_ecef_float(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  fill_lat_long(count, lat, lon, alt);
+  std::vector<float> x(count), y(count), z(count);
+  fr::coordinates::ecef_point origin(-1288000.0, -4720000.0, 4080000.0);
+  fr::coordinates::batch_converter<fr::coordinates::ecef> convert;
+  for (auto _ : state) {
+    convert(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count, origin);
+    benchmark::DoNotOptimize(x.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+// Radar site in the middle of the fill_lat_long points
+static fr::coordinates::local_frame bench_site()
+{
+  return fr::coordinates::local_frame(fr::coordinates::lat_long(39.75, -104.87, 1609.0));
+}
+
+static void scalar_ecef_to_enu(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  fill_lat_long(count, lat, lon, alt);
+  std::vector<fr::coordinates::ecef_point> in(count);
+  for (size_t i = 0; i < count; ++i) {
+    in[i] = fr::coordinates::converter<fr::coordinates::ecef_point>()(fr::coordinates::lat_long(lat[i], lon[i], alt[i]));
+  }
+  std::vector<fr::coordinates::enu_point> out(count);
+  fr::coordinates::local_frame site = bench_site();
+  fr::coordinates::converter<fr::coordinates::enu_point> convert;
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = convert(in[i], site);
+    }
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void batch_ecef_to_enu(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  fill_lat_long(count, lat, lon, alt);
+  std::vector<fr::coordinates::ecef_point> in(count);
+  for (size_t i = 0; i < count; ++i) {
+    in[i] = fr::coordinates::converter<fr::coordinates::ecef_point>()(fr::coordinates::lat_long(lat[i], lon[i], alt[i]));
+  }
+  std::vector<fr::coordinates::enu_point> out(count);
+  fr::coordinates::local_frame site = bench_site();
+  fr::coordinates::batch_converter<fr::coordinates::enu_point> convert;
+  for (auto _ : state) {
+    convert(in.data(), out.data(), count, site);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void batch_lat_long_to_enu(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  fill_lat_long(count, lat, lon, alt);
+  std::vector<fr::coordinates::enu_point> out(count);
+  fr::coordinates::local_frame site = bench_site();
+  fr::coordinates::batch_converter<fr::coordinates::enu_point> convert;
+  for (auto _ : state) {
+    convert(lat.data(), lon.data(), alt.data(), out.data(), count, site);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void scalar_tod_eci_vel_to_ecef_vel(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<fr::coordinates::tod_eci_vel_point> points;
+  fill_states(count, points);
+  std::vector<fr::coordinates::tod_eci_vel> states;
+  states.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    states.push_back(fr::coordinates::converter<fr::coordinates::tod_eci_vel>()(points[i]));
+  }
+  std::vector<fr::coordinates::ecef_vel> out(count);
+  fr::coordinates::converter<fr::coordinates::ecef_vel> convert;
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = convert(states[i], bench::epoch);
+    }
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void batch_tod_eci_vel_to_ecef_vel(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<fr::coordinates::tod_eci_vel_point> in;
+  fill_states(count, in);
+  std::vector<fr::coordinates::ecef_vel_point> out(count);
+  fr::coordinates::batch_converter<fr::coordinates::ecef_vel_point> convert;
+  for (auto _ : state) {
+    convert(in.data(), out.data(), count, bench::epoch);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void scalar_timestamped_tod_eci_to_ecef(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<fr::coordinates::tod_eci_vel_point> points;
+  fill_states(count, points);
+  std::vector<fr::coordinates::tod_eci_point> in(count);
+  std::vector<double> times(count);
+  for (size_t i = 0; i < count; ++i) {
+    in[i] = fr::coordinates::tod_eci_point(points[i].x, points[i].y, points[i].z);
+    times[i] = bench::epoch + (double) i * 0.01;
+  }
+  std::vector<fr::coordinates::ecef_point> out(count);
+  fr::coordinates::converter<fr::coordinates::ecef_point> convert;
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = convert(in[i], times[i]);
+    }
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void batch_timestamped_tod_eci_to_ecef(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<fr::coordinates::tod_eci_vel_point> points;
+  fill_states(count, points);
+  std::vector<fr::coordinates::tod_eci_point> in(count);
+  std::vector<double> times(count);
+  for (size_t i = 0; i < count; ++i) {
+    in[i] = fr::coordinates::tod_eci_point(points[i].x, points[i].y, points[i].z);
+    times[i] = bench::epoch + (double) i * 0.01;
+  }
+  std::vector<fr::coordinates::ecef_point> out(count);
+  fr::coordinates::batch_converter<fr::coordinates::ecef_point> convert;
+  for (auto _ : state) {
+    convert(in.data(), times.data(), out.data(), count);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+// Catalog positions in J2000, each with its own time. The scalar
+// version evaluates precession and nutation for every point; the batch
+// one gets its rotations from a frame_chain.
+static void scalar_timestamped_j2000_to_ecef(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<fr::coordinates::tod_eci_vel_point> points;
+  fill_states(count, points);
+  std::vector<fr::coordinates::j2000_point> in(count);
+  std::vector<double> times(count);
+  for (size_t i = 0; i < count; ++i) {
+    in[i] = fr::coordinates::j2000_point(points[i].x, points[i].y, points[i].z);
+    times[i] = bench::epoch + (double) i * 0.01;
+  }
+  std::vector<fr::coordinates::ecef_point> out(count);
+  fr::coordinates::converter<fr::coordinates::ecef_point> convert;
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = convert(in[i], times[i]);
+    }
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void batch_timestamped_j2000_to_ecef(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<fr::coordinates::tod_eci_vel_point> points;
+  fill_states(count, points);
+  std::vector<fr::coordinates::j2000_point> in(count);
+  std::vector<double> times(count);
+  for (size_t i = 0; i < count; ++i) {
+    in[i] = fr::coordinates::j2000_point(points[i].x, points[i].y, points[i].z);
+    times[i] = bench::epoch + (double) i * 0.01;
+  }
+  std::vector<fr::coordinates::ecef_point> out(count);
+  fr::coordinates::batch_converter<fr::coordinates::ecef_point> convert;
+  fr::coordinates::frame_chain chain;
+  for (auto _ : state) {
+    convert(in.data(), times.data(), out.data(), count, chain);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+// Maps a lat_long coordinate file and converts its columns straight
+// into a mapped ecef file, which is what a reprocessing job looks like
+// with no parse step. The files live in TMPDIR (or /tmp.)
+static void file_lat_long_to_ecef(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  const char *tmp = getenv("TMPDIR");
+  std::string base = std::string(tmp ? tmp : "/tmp") + "/coordinates_bench." + std::to_string(getpid());
+  std::string in_path = base + ".lla";
+  std::string out_path = base + ".ecef";
+  {
+    std::vector<double> lat, lon, alt;
+    fill_lat_long(count, lat, lon, alt);
+    fr::coordinates::coordinate_file_writer writer(in_path, fr::coordinates::coordinate_file::lat_long_frame, count);
+    std::copy(lat.begin(), lat.end(), writer.get_column(fr::coordinates::coordinate_file::lat));
+    std::copy(lon.begin(), lon.end(), writer.get_column(fr::coordinates::coordinate_file::lon));
+    std::copy(alt.begin(), alt.end(), writer.get_column(fr::coordinates::coordinate_file::alt));
+  }
+  fr::coordinates::batch_converter<fr::coordinates::ecef> convert;
+  for (auto _ : state) {
+    fr::coordinates::coordinate_file_reader reader(in_path);
+    fr::coordinates::coordinate_file_writer writer(out_path, fr::coordinates::coordinate_file::ecef_position_frame, reader.size());
+    convert(reader.get_column(fr::coordinates::coordinate_file::lat).data, reader.get_column(fr::coordinates::coordinate_file::lon).data, reader.get_column(fr::coordinates::coordinate_file::alt).data,
+            writer.get_column(fr::coordinates::coordinate_file::x), writer.get_column(fr::coordinates::coordinate_file::y), writer.get_column(fr::coordinates::coordinate_file::z), reader.size(), reader.get_ellipsoid());
+  }
+  remove(in_path.c_str());
+  remove(out_path.c_str());
+  bench::set_counters(state, count);
+}
+
+// Streams count ecef points through to lat_long in 64K point chunks,
+// with the source copying out of memory and the sink dropping them, so
+// this is the pipeline overhead on top of the conversions
+static void stream_ecef_to_lat_long(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<fr::coordinates::ecef_point> points = bench::make_points<fr::coordinates::ecef_point>(count);
+  fr::coordinates::stream_converter<fr::coordinates::ecef_point, fr::coordinates::lat_long> stream(65536);
+  for (auto _ : state) {
+    size_t next = 0;
+    stream.run([&](fr::coordinates::ecef_point *buffer, size_t max) {
+        size_t n = std::min(max, count - next);
+        std::copy(points.begin() + next, points.begin() + next + n, buffer);
+        next += n;
+        return n;
+      }, [](const fr::coordinates::lat_long *chunk, size_t) {
+        benchmark::DoNotOptimize(chunk);
+      });
+  }
+  bench::set_counters(state, count);
+}
+
+BENCHMARK(scalar_lat_long_to_ecef)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(batch_lat_long_to_ecef, fr::coordinates::precise_math)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(batch_lat_long_to_ecef, fr::coordinates::fast_math)->Apply(bench::batch_sizes);
+BENCHMARK(scalar_ecef_to_lat_long)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(batch_ecef_to_lat_long, fr::coordinates::iterative_solver)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(batch_ecef_to_lat_long, fr::coordinates::bowring_solver<1>)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(batch_ecef_to_lat_long, fr::coordinates::bowring_solver<2>)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(batch_ecef_to_lat_long, fr::coordinates::vermeille_solver)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(batch_ecef_to_lat_long, fr::coordinates::fast_vermeille_solver)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(batch_ecef_to_lat_long, fr::coordinates::bowring_solver<1, fr::coordinates::fast_math>)->Apply(bench::batch_sizes);
+BENCHMARK(batch_lat_long_to_ecef_float)->Apply(bench::batch_sizes);
+BENCHMARK(batch_ecef_to_lat_long_float)->Apply(bench::batch_sizes);
+BENCHMARK(batch_lat_long_to_local_ecef_float)->Apply(bench::batch_sizes);
+BENCHMARK(scalar_ecef_to_enu)->Apply(bench::batch_sizes);
+BENCHMARK(batch_ecef_to_enu)->Apply(bench::batch_sizes);
+BENCHMARK(batch_lat_long_to_enu)->Apply(bench::batch_sizes);
+BENCHMARK(scalar_tod_eci_vel_to_ecef_vel)->Apply(bench::batch_sizes);
+BENCHMARK(batch_tod_eci_vel_to_ecef_vel)->Apply(bench::batch_sizes);
+BENCHMARK(scalar_timestamped_tod_eci_to_ecef)->Apply(bench::batch_sizes);
+BENCHMARK(batch_timestamped_tod_eci_to_ecef)->Apply(bench::batch_sizes);
+BENCHMARK(scalar_timestamped_j2000_to_ecef)->Apply(bench::batch_sizes);
+BENCHMARK(batch_timestamped_j2000_to_ecef)->Apply(bench::batch_sizes);
+BENCHMARK(file_lat_long_to_ecef)->Apply(bench::batch_sizes);
+BENCHMARK(stream_ecef_to_lat_long)->Apply(bench::batch_sizes)->UseRealTime();
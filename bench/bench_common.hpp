@@ -0,0 +1,136 @@
+/**
+ * Test data and reporting shared by the benchmarks.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_BENCH_COMMON
+#define _HPP_BENCH_COMMON
+
+#include <benchmark/benchmark.h>
+#include "coordinates.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace bench {
+
+  const double epoch = 1381968000.0;
+
+  // Single points and batches of 1K and 1M. Set COORDINATES_BENCH_LARGE
+  // in the environment to add 100M point batches, which need several
+  // gigabytes of memory for some of the coordinate types.
+  inline void batch_sizes(benchmark::internal::Benchmark *b)
+  {
+    b->Arg(1)->Arg(1 << 10)->Arg(1 << 20);
+    if (getenv("COORDINATES_BENCH_LARGE") != NULL) {
+      b->Arg(100000000);
+    }
+  }
+
+  // Reports points/sec as items_per_second and the time per point
+  // (in seconds in the json output) as time_per_point
+  inline void set_counters(benchmark::State &state, size_t count)
+  {
+    double points = (double) state.iterations() * (double) count;
+    state.SetItemsProcessed(state.iterations() * count);
+    state.counters["time_per_point"] = benchmark::Counter(points, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  }
+
+  // Deterministic spread of points, so runs are comparable
+  inline void fill_lat_long(size_t count, std::vector<double> &lat, std::vector<double> &lon, std::vector<double> &alt)
+  {
+    lat.resize(count);
+    lon.resize(count);
+    alt.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      lat[i] = -89.0 + 178.0 * (double) ((i * 7919) % count) / (double) count;
+      lon[i] = -180.0 + 360.0 * (double) ((i * 104729) % count) / (double) count;
+      alt[i] = (double) (i % 10000);
+    }
+  }
+
+  // Roughly circular low earth orbit states
+  inline void fill_states(size_t count, std::vector<fr::coordinates::tod_eci_vel_point> &states)
+  {
+    states.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      double phase = (double) i * 0.001;
+      states[i] = fr::coordinates::tod_eci_vel_point(7000000.0 * cos(phase), 7000000.0 * sin(phase), 1000.0 * (double) (i % 1000),
+                                                     -7500.0 * sin(phase), 7500.0 * cos(phase), (double) (i % 100));
+    }
+  }
+
+  // Builds any of the coordinate types from a state vector, so the
+  // converter benchmarks can be written once as templates
+
+  template <typename T>
+  T make(const fr::coordinates::tod_eci_vel_point &s)
+  {
+    return T(s.x, s.y, s.z, s.dx, s.dy, s.dz);
+  }
+
+  template <>
+  inline fr::coordinates::lat_long make<fr::coordinates::lat_long>(const fr::coordinates::tod_eci_vel_point &s)
+  {
+    return fr::coordinates::converter<fr::coordinates::lat_long>()(fr::coordinates::ecef_point(s.x, s.y, s.z));
+  }
+
+  template <>
+  inline fr::coordinates::ecef make<fr::coordinates::ecef>(const fr::coordinates::tod_eci_vel_point &s)
+  {
+    return fr::coordinates::ecef(s.x, s.y, s.z);
+  }
+
+  template <>
+  inline fr::coordinates::ecef_point make<fr::coordinates::ecef_point>(const fr::coordinates::tod_eci_vel_point &s)
+  {
+    return fr::coordinates::ecef_point(s.x, s.y, s.z);
+  }
+
+  template <>
+  inline fr::coordinates::tod_eci make<fr::coordinates::tod_eci>(const fr::coordinates::tod_eci_vel_point &s)
+  {
+    return fr::coordinates::tod_eci(s.x, s.y, s.z);
+  }
+
+  template <>
+  inline fr::coordinates::tod_eci_point make<fr::coordinates::tod_eci_point>(const fr::coordinates::tod_eci_vel_point &s)
+  {
+    return fr::coordinates::tod_eci_point(s.x, s.y, s.z);
+  }
+
+  template <>
+  inline fr::coordinates::j2000_point make<fr::coordinates::j2000_point>(const fr::coordinates::tod_eci_vel_point &s)
+  {
+    return fr::coordinates::j2000_point(s.x, s.y, s.z);
+  }
+
+  template <typename T>
+  std::vector<T> make_points(size_t count)
+  {
+    std::vector<fr::coordinates::tod_eci_vel_point> states;
+    fill_states(count, states);
+    std::vector<T> retval;
+    retval.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      retval.push_back(make<T>(states[i]));
+    }
+    return retval;
+  }
+
+}
+
+#endif
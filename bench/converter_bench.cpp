@@ -0,0 +1,140 @@
+/**
+ * Times every converter<> path, one point per call, over single points
+ * and batches. Names are convert_each<to, from, extra arguments>.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "bench_common.hpp"
+
+using namespace fr::coordinates;
+
+namespace {
+
+  // Extra arguments the converters take after the point
+
+  struct no_args {
+    template <typename convert, typename from>
+    auto operator()(convert &c, const from &f) -> decltype(c(f))
+    {
+      return c(f);
+    }
+  };
+
+  struct at_time {
+    template <typename convert, typename from>
+    auto operator()(convert &c, const from &f) -> decltype(c(f, bench::epoch))
+    {
+      return c(f, bench::epoch);
+    }
+  };
+
+  struct with_rotation {
+    eci_ecef_rotation r;
+
+    with_rotation() : r(bench::epoch)
+    {
+    }
+
+    template <typename convert, typename from>
+    auto operator()(convert &c, const from &f) -> decltype(c(f, r))
+    {
+      return c(f, r);
+    }
+  };
+
+  template <typename solver>
+  struct with_solver {
+    template <typename convert, typename from>
+    auto operator()(convert &c, const from &f) -> decltype(c(f, WGS84_ELLIPSOID, solver()))
+    {
+      return c(f, WGS84_ELLIPSOID, solver());
+    }
+  };
+
+}
+
+template <typename convert_to, typename convert_from, typename args, typename datum = void>
+static void convert_each(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<convert_from> in = bench::make_points<convert_from>(count);
+  converter<convert_to, datum> convert;
+  args call;
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      convert_to result = call(convert, in[i]);
+      benchmark::DoNotOptimize(result);
+    }
+  }
+  bench::set_counters(state, count);
+}
+
+// converter<lat_long>
+BENCHMARK_TEMPLATE(convert_each, lat_long, lat_long, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, lat_long, ecef, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, lat_long, ecef_point, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, lat_long, ecef, with_solver<bowring_solver<1> >)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, lat_long, ecef, with_solver<bowring_solver<2> >)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, lat_long, ecef, with_solver<vermeille_solver>)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, lat_long, ecef_vel, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, lat_long, ecef_vel_point, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, lat_long, tod_eci_vel, at_time)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, lat_long, tod_eci_vel, with_rotation)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, lat_long, ecef, no_args, wgs84)->Apply(bench::batch_sizes);
+
+// converter<ecef>
+BENCHMARK_TEMPLATE(convert_each, ecef, ecef, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef, ecef_point, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef, lat_long, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef, lat_long, no_args, wgs84)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef, ecef_vel, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef, tod_eci, at_time)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef, tod_eci, with_rotation)->Apply(bench::batch_sizes);
+
+// converter<tod_eci>
+BENCHMARK_TEMPLATE(convert_each, tod_eci, tod_eci, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, tod_eci, tod_eci_point, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, tod_eci, ecef, at_time)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, tod_eci, ecef, with_rotation)->Apply(bench::batch_sizes);
+
+// converter<ecef_vel>
+BENCHMARK_TEMPLATE(convert_each, ecef_vel, ecef_vel, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef_vel, ecef_vel_point, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef_vel, tod_eci_vel, at_time)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef_vel, tod_eci_vel, with_rotation)->Apply(bench::batch_sizes);
+
+// converter<tod_eci_vel>
+BENCHMARK_TEMPLATE(convert_each, tod_eci_vel, tod_eci_vel, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, tod_eci_vel, tod_eci_vel_point, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, tod_eci_vel, ecef_vel, at_time)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, tod_eci_vel, ecef_vel, with_rotation)->Apply(bench::batch_sizes);
+
+// Value type converters
+BENCHMARK_TEMPLATE(convert_each, ecef_point, ecef, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef_point, lat_long, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef_point, lat_long, no_args, wgs84)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef_point, ecef_vel_point, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef_point, tod_eci_point, at_time)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef_point, tod_eci_point, with_rotation)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, tod_eci_point, tod_eci, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, tod_eci_point, ecef_point, at_time)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, tod_eci_point, ecef_point, with_rotation)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef_vel_point, ecef_vel, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef_vel_point, tod_eci_vel_point, at_time)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, ecef_vel_point, tod_eci_vel_point, with_rotation)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, tod_eci_vel_point, tod_eci_vel, no_args)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, tod_eci_vel_point, ecef_vel_point, at_time)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(convert_each, tod_eci_vel_point, ecef_vel_point, with_rotation)->Apply(bench::batch_sizes);
@@ -0,0 +1,401 @@
+/**
+ * Times haversine_distance, bearing and the tod_eci/tod_eci_vel
+ * interpolation, over single points and batches.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "bench_common.hpp"
+#include "bearing.hpp"
+#include "ephemeris.hpp"
+#include "geodesic.hpp"
+#include "geofence.hpp"
+#include "haversine_distance.hpp"
+#include "interpolator.hpp"
+#include "spatial_index.hpp"
+
+using namespace fr::coordinates;
+
+static void haversine_each(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<lat_long> points = bench::make_points<lat_long>(count + 1);
+  haversine_distance haversine;
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(haversine.distance(points[i], points[i + 1]));
+    }
+  }
+  bench::set_counters(state, count);
+}
+
+// Same pairs as haversine_each, on the ellipsoid
+static void geodesic_each(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<lat_long> points = bench::make_points<lat_long>(count + 1);
+  geodesic g;
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(g.distance(points[i], points[i + 1]));
+    }
+  }
+  bench::set_counters(state, count);
+}
+
+static void bearing_each(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<lat_long> points = bench::make_points<lat_long>(count + 1);
+  bearing bear;
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(bear(points[i], points[i + 1]));
+    }
+  }
+  bench::set_counters(state, count);
+}
+
+// One reference point to count points, the proximity check case
+template <typename math>
+static void haversine_one_to_many(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  std::vector<double> out(count);
+  lat_long from(39.75, -104.87);
+  haversine_distance haversine;
+  for (auto _ : state) {
+    haversine.distances(from, lat.data(), lon.data(), out.data(), count, math());
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void geodesic_one_to_many(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  std::vector<double> out(count);
+  lat_long from(39.75, -104.87);
+  geodesic g;
+  for (auto _ : state) {
+    g.distances(from, lat.data(), lon.data(), out.data(), count);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+// count points along one geodesic, sharing the line setup
+static void geodesic_direct_line(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> s12(count), lat(count), lon(count);
+  for (size_t i = 0; i < count; ++i) {
+    s12[i] = 20000000.0 * i / count;
+  }
+  lat_long from(39.75, -104.87);
+  geodesic g;
+  for (auto _ : state) {
+    g.direct(from, 30.0, s12.data(), lat.data(), lon.data(), nullptr, count);
+    benchmark::DoNotOptimize(lat.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void bearing_one_to_many(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  std::vector<double> out(count);
+  lat_long from(39.75, -104.87);
+  bearing bear;
+  for (auto _ : state) {
+    bear(from, lat.data(), lon.data(), out.data(), count);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+template <typename math>
+static void distance_and_bearing_one_to_many(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  std::vector<double> dist(count), bearings(count);
+  lat_long from(39.75, -104.87);
+  haversine_distance haversine;
+  for (auto _ : state) {
+    haversine.distances_and_bearings(from, lat.data(), lon.data(), dist.data(), bearings.data(), count, math());
+    benchmark::DoNotOptimize(dist.data());
+    benchmark::DoNotOptimize(bearings.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+// Interpolates halfway between consecutive points, 60 seconds apart
+template <typename coordinate>
+static void interpolate_each(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<coordinate> points = bench::make_points<coordinate>(count + 1);
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      coordinate result = points[i].interpolate(0.0, points[i + 1], 60.0, 30.0);
+      benchmark::DoNotOptimize(result);
+    }
+  }
+  bench::set_counters(state, count);
+}
+
+// Resamples one 60 second segment at count times, with the segment
+// set up once
+template <typename segment, typename coordinate, typename point>
+static void interpolate_segment(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<coordinate> ends = bench::make_points<coordinate>(2);
+  std::vector<double> times(count);
+  for (size_t i = 0; i < count; ++i) {
+    times[i] = 60.0 * (double) i / (double) count;
+  }
+  std::vector<point> out(count);
+  for (auto _ : state) {
+    segment interp(ends[0], 0.0, ends[1], 60.0);
+    interp.interpolate(times.data(), out.data(), count);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+// A day of one minute samples, looked up at count times spread over
+// the day in order, or scattered
+static void fill_ephemeris(ephemeris &eph)
+{
+  std::vector<tod_eci_vel_point> states;
+  bench::fill_states(1441, states);
+  for (size_t i = 0; i < states.size(); ++i) {
+    eph.push_back(bench::epoch + 60.0 * (double) i, states[i]);
+  }
+}
+
+static std::vector<double> query_times(size_t count, bool sorted)
+{
+  std::vector<double> times(count);
+  for (size_t i = 0; i < count; ++i) {
+    size_t slot = sorted ? i : (i * 104729) % count;
+    times[i] = bench::epoch + 86400.0 * (double) slot / (double) count;
+  }
+  return times;
+}
+
+static void ephemeris_lookup_each(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  ephemeris eph;
+  fill_ephemeris(eph);
+  std::vector<double> times = query_times(count, false);
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(eph.interpolate(times[i]));
+    }
+  }
+  bench::set_counters(state, count);
+}
+
+static void ephemeris_cursor(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  ephemeris eph;
+  fill_ephemeris(eph);
+  std::vector<double> times = query_times(count, true);
+  for (auto _ : state) {
+    ephemeris::cursor c(eph);
+    for (size_t i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(c(times[i]));
+    }
+  }
+  bench::set_counters(state, count);
+}
+
+static void ephemeris_batch(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  ephemeris eph;
+  fill_ephemeris(eph);
+  std::vector<double> times = query_times(count, true);
+  std::vector<tod_eci_vel_point> out(count);
+  for (auto _ : state) {
+    eph.interpolate(times.data(), out.data(), count);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+// 100km radius around one point, brute force scan vs the spatial index
+static void radius_scan(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  std::vector<double> dist(count);
+  std::vector<size_t> found;
+  lat_long from(39.75, -104.87);
+  haversine_distance haversine;
+  for (auto _ : state) {
+    found.clear();
+    haversine.distances(from, lat.data(), lon.data(), dist.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      if (dist[i] <= 100000.0) {
+        found.push_back(i);
+      }
+    }
+    benchmark::DoNotOptimize(found.data());
+  }
+  bench::set_counters(state, count);
+}
+
+static void radius_index(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  lat_long_index index;
+  index.build(lat.data(), lon.data(), count);
+  std::vector<lat_long_index::neighbor> found;
+  lat_long from(39.75, -104.87);
+  for (auto _ : state) {
+    found.clear();
+    index.within(from, 100000.0, found);
+    benchmark::DoNotOptimize(found.data());
+  }
+  bench::set_counters(state, count);
+}
+
+static void nearest_index(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  lat_long_index index;
+  index.build(lat.data(), lon.data(), count);
+  lat_long from(39.75, -104.87);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(index.nearest(from, 10));
+  }
+  bench::set_counters(state, count);
+}
+
+static void build_index(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  for (auto _ : state) {
+    lat_long_index index;
+    index.build(lat.data(), lon.data(), count);
+    benchmark::DoNotOptimize(index.size());
+  }
+  bench::set_counters(state, count);
+}
+
+// A ring of count vertices radius meters around center
+static lat_long_polygon make_fence(const lat_long &center, double radius, size_t count)
+{
+  std::vector<lat_long> v;
+  double d = radius / WGS84_ELLIPSOID.ae;
+  double lat1 = center.get_lat() * M_PI / 180.0;
+  for (size_t i = 0; i < count; ++i) {
+    double b = 2.0 * M_PI * i / count;
+    double lat2 = asin(sin(lat1) * cos(d) + cos(lat1) * sin(d) * cos(b));
+    double lon2 = atan2(sin(b) * sin(d) * cos(lat1), cos(d) - sin(lat1) * sin(lat2));
+    v.push_back(lat_long(lat2 * 180.0 / M_PI, center.get_long() + lon2 * 180.0 / M_PI));
+  }
+  return lat_long_polygon(v);
+}
+
+// count points against one fence with 1000 vertices, most of them
+// thrown out by the bounding box
+static void fence_contains(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  lat_long_polygon fence = make_fence(lat_long(0.0, 0.0), 5000000.0, 1000);
+  std::vector<char> out(count);
+  for (auto _ : state) {
+    fence.contains(lat.data(), lon.data(), (bool *) out.data(), count);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+// count points against 100K small fences spread over the earth
+static void fence_index(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  std::vector<double> flat, flon, falt;
+  bench::fill_lat_long(100000, flat, flon, falt);
+  geofence_index index;
+  for (size_t i = 0; i < flat.size(); ++i) {
+    index.insert(make_fence(lat_long(flat[i], flon[i]), 20000.0, 16));
+  }
+  std::vector<geofence_index::hit> hits;
+  for (auto _ : state) {
+    hits.clear();
+    index.containing(lat.data(), lon.data(), count, hits);
+    benchmark::DoNotOptimize(hits.data());
+  }
+  bench::set_counters(state, count);
+}
+
+BENCHMARK(haversine_each)->Apply(bench::batch_sizes);
+BENCHMARK(geodesic_each)->Apply(bench::batch_sizes);
+BENCHMARK(bearing_each)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(haversine_one_to_many, precise_math)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(haversine_one_to_many, fast_math)->Apply(bench::batch_sizes);
+BENCHMARK(geodesic_one_to_many)->Apply(bench::batch_sizes);
+BENCHMARK(geodesic_direct_line)->Apply(bench::batch_sizes);
+BENCHMARK(bearing_one_to_many)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(distance_and_bearing_one_to_many, precise_math)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(distance_and_bearing_one_to_many, fast_math)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(interpolate_each, tod_eci)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(interpolate_each, tod_eci_vel)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(interpolate_segment, tod_eci_segment, tod_eci, tod_eci_point)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(interpolate_segment, tod_eci_vel_segment, tod_eci_vel, tod_eci_vel_point)->Apply(bench::batch_sizes);
+BENCHMARK_TEMPLATE(interpolate_segment, tod_eci_vel_hermite_segment, tod_eci_vel, tod_eci_vel_point)->Apply(bench::batch_sizes);
+BENCHMARK(ephemeris_lookup_each)->Apply(bench::batch_sizes);
+BENCHMARK(ephemeris_cursor)->Apply(bench::batch_sizes);
+BENCHMARK(ephemeris_batch)->Apply(bench::batch_sizes);
+BENCHMARK(radius_scan)->Apply(bench::batch_sizes);
+BENCHMARK(radius_index)->Apply(bench::batch_sizes);
+BENCHMARK(nearest_index)->Apply(bench::batch_sizes);
+BENCHMARK(build_index)->Apply(bench::batch_sizes);
+BENCHMARK(fence_contains)->Apply(bench::batch_sizes);
+BENCHMARK(fence_index)->Apply(bench::batch_sizes);
@@ -0,0 +1,121 @@
+/**
+ * Parallel converters at different thread counts. Wall clock time, so
+ * points per second reflects the whole pool. Compare against the
+ * batch_ benchmarks in batch_bench.cpp for the single thread numbers.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "bench_common.hpp"
+#include "parallel_converts.hpp"
+#include <memory>
+
+using namespace fr::coordinates;
+
+// 1M points (and 100M with COORDINATES_BENCH_LARGE) on 1, 2, 4... up
+// to the hardware thread count
+static void thread_counts(benchmark::internal::Benchmark *b)
+{
+  std::vector<long> sizes(1, 1 << 20);
+  if (getenv("COORDINATES_BENCH_LARGE") != NULL) {
+    sizes.push_back(100000000);
+  }
+  unsigned hardware = std::thread::hardware_concurrency();
+  for (size_t s = 0; s < sizes.size(); ++s) {
+    for (unsigned threads = 1; threads < hardware; threads *= 2) {
+      b->Args({ sizes[s], (long) threads });
+    }
+    b->Args({ sizes[s], (long) hardware });
+  }
+  b->UseRealTime();
+}
+
+static void parallel_lat_long_to_ecef(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  thread_pool pool(state.range(1));
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  // Left uninitialized so the workers get first touch
+  std::unique_ptr<double[]> x(new double[count]), y(new double[count]), z(new double[count]);
+  parallel_converter<ecef> convert(pool);
+  for (auto _ : state) {
+    convert(lat.data(), lon.data(), alt.data(), x.get(), y.get(), z.get(), count);
+    benchmark::DoNotOptimize(x.get());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void parallel_ecef_to_lat_long(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  thread_pool pool(state.range(1));
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  std::vector<double> x(count), y(count), z(count);
+  batch_converter<ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count);
+  parallel_converter<lat_long> convert(pool);
+  for (auto _ : state) {
+    convert(x.data(), y.data(), z.data(), lat.data(), lon.data(), alt.data(), count);
+    benchmark::DoNotOptimize(lat.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void parallel_tod_eci_vel_to_ecef_vel(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  thread_pool pool(state.range(1));
+  std::vector<tod_eci_vel_point> in;
+  bench::fill_states(count, in);
+  std::unique_ptr<ecef_vel_point[]> out(new ecef_vel_point[count]);
+  eci_ecef_rotation r(bench::epoch);
+  parallel_converter<ecef_vel_point> convert(pool);
+  for (auto _ : state) {
+    convert(in.data(), out.get(), count, r);
+    benchmark::DoNotOptimize(out.get());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+static void parallel_timestamped_tod_eci_to_ecef(benchmark::State &state)
+{
+  size_t count = state.range(0);
+  thread_pool pool(state.range(1));
+  std::vector<tod_eci_vel_point> states;
+  bench::fill_states(count, states);
+  std::vector<tod_eci_point> in(count);
+  std::vector<double> times(count);
+  for (size_t i = 0; i < count; ++i) {
+    in[i] = tod_eci_point(states[i].x, states[i].y, states[i].z);
+    times[i] = bench::epoch + (double) i * 0.01;
+  }
+  std::unique_ptr<ecef_point[]> out(new ecef_point[count]);
+  parallel_converter<ecef_point> convert(pool);
+  for (auto _ : state) {
+    convert(in.data(), times.data(), out.get(), count);
+    benchmark::DoNotOptimize(out.get());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+}
+
+BENCHMARK(parallel_lat_long_to_ecef)->Apply(thread_counts);
+BENCHMARK(parallel_ecef_to_lat_long)->Apply(thread_counts);
+BENCHMARK(parallel_tod_eci_vel_to_ecef_vel)->Apply(thread_counts);
+BENCHMARK(parallel_timestamped_tod_eci_to_ecef)->Apply(thread_counts);
@@ -0,0 +1,8 @@
+/**
+ * Benchmark runner. Pass --benchmark_format=json (or --benchmark_out=file
+ * --benchmark_out_format=json) for machine readable output.
+ */
+
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
@@ -0,0 +1,144 @@
+/**
+ * Runs the dispatched batch kernels on each SIMD backend, on 1K and 1M
+ * points. Backends this CPU can't run are skipped. Names end in
+ * /points/backend, with the backend numbered as in simd_backend (0
+ * scalar, 1 sse2, 2 avx2, 3 avx512) and named in the label.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "bench_common.hpp"
+#include "simd_dispatch.hpp"
+
+using namespace fr::coordinates;
+
+static void backends(benchmark::internal::Benchmark *b)
+{
+  long sizes[] = { 1 << 10, 1 << 20 };
+  for (size_t s = 0; s < 2; ++s) {
+    for (int backend = simd_scalar; backend < simd_backend_count; ++backend) {
+      b->Args({ sizes[s], (long) backend });
+    }
+  }
+}
+
+// Switches to the benchmark's backend, false if the CPU can't run it
+static bool use_backend(benchmark::State &state)
+{
+  simd_backend b = (simd_backend) state.range(1);
+  if (!simd_dispatch::supported(b)) {
+    state.SkipWithError("backend not supported on this CPU");
+    return false;
+  }
+  simd_dispatch::force(b);
+  state.SetLabel(simd_dispatch::name(b));
+  return true;
+}
+
+template <typename math>
+static void dispatched_lat_long_to_ecef(benchmark::State &state)
+{
+  simd_backend was = simd_dispatch::active();
+  if (!use_backend(state)) {
+    return;
+  }
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  std::vector<double> x(count), y(count), z(count);
+  batch_converter<ecef> convert;
+  for (auto _ : state) {
+    convert(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count, WGS84_ELLIPSOID, dispatched<math>());
+    benchmark::DoNotOptimize(x.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+  simd_dispatch::force(was);
+}
+
+template <typename math>
+static void dispatched_ecef_to_lat_long(benchmark::State &state)
+{
+  simd_backend was = simd_dispatch::active();
+  if (!use_backend(state)) {
+    return;
+  }
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  std::vector<double> x(count), y(count), z(count);
+  batch_converter<ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count);
+  batch_converter<lat_long> convert;
+  for (auto _ : state) {
+    convert(x.data(), y.data(), z.data(), lat.data(), lon.data(), alt.data(), count, WGS84_ELLIPSOID, dispatched<math>());
+    benchmark::DoNotOptimize(lat.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+  simd_dispatch::force(was);
+}
+
+template <typename math>
+static void dispatched_haversine_one_to_many(benchmark::State &state)
+{
+  simd_backend was = simd_dispatch::active();
+  if (!use_backend(state)) {
+    return;
+  }
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  std::vector<double> out(count);
+  haversine_distance h;
+  lat_long from(39.75, -104.87);
+  for (auto _ : state) {
+    h.distances(from, lat.data(), lon.data(), out.data(), count, dispatched<math>());
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+  simd_dispatch::force(was);
+}
+
+template <typename math>
+static void dispatched_bearing_one_to_many(benchmark::State &state)
+{
+  simd_backend was = simd_dispatch::active();
+  if (!use_backend(state)) {
+    return;
+  }
+  size_t count = state.range(0);
+  std::vector<double> lat, lon, alt;
+  bench::fill_lat_long(count, lat, lon, alt);
+  std::vector<double> out(count);
+  bearing b;
+  lat_long from(39.75, -104.87);
+  for (auto _ : state) {
+    b(from, lat.data(), lon.data(), out.data(), count, dispatched<math>());
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  bench::set_counters(state, count);
+  simd_dispatch::force(was);
+}
+
+BENCHMARK_TEMPLATE(dispatched_lat_long_to_ecef, precise_math)->Apply(backends);
+BENCHMARK_TEMPLATE(dispatched_lat_long_to_ecef, fast_math)->Apply(backends);
+BENCHMARK_TEMPLATE(dispatched_ecef_to_lat_long, precise_math)->Apply(backends);
+BENCHMARK_TEMPLATE(dispatched_ecef_to_lat_long, fast_math)->Apply(backends);
+BENCHMARK_TEMPLATE(dispatched_haversine_one_to_many, precise_math)->Apply(backends);
+BENCHMARK_TEMPLATE(dispatched_haversine_one_to_many, fast_math)->Apply(backends);
+BENCHMARK_TEMPLATE(dispatched_bearing_one_to_many, precise_math)->Apply(backends);
+BENCHMARK_TEMPLATE(dispatched_bearing_one_to_many, fast_math)->Apply(backends);
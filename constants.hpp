@@ -24,9 +24,10 @@
 namespace fr {
 
   namespace constants {
-    const double pi = atan2(1.0, 1.0) * 4.0;
-    const double secs_per_ut1_day = 86400.0;
-    const double ut1_sideral_day_ratio = 1.002737811906;
+    // Same value atan2(1.0, 1.0) * 4.0 gives, but known at compile time
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double secs_per_ut1_day = 86400.0;
+    constexpr double ut1_sideral_day_ratio = 1.002737811906;
   };
 
 };
@@ -17,7 +17,11 @@
  */
 
 #include <Eigen/Core>
+#include <cmath>
+#include <stdexcept>
+#include "constants.hpp"
 #include "gmst.hpp"
+#include "instrumentation.hpp"
 
 #ifndef _HPP_CONVERSION_MATRICES
 #define _HPP_CONVERSION_MATRICES
@@ -39,18 +43,11 @@ namespace fr {
 
       virtual Eigen::Matrix<double,6,6> get_xyz_vel()
       {
-	Eigen::Matrix3d mat = get();
-	Eigen::Matrix3d mat_dot = get_dot();
 	Eigen::Matrix<double,6,6> retval;
-	
-	for (register int i = 0; i < 3; ++i) {
-	  for (register int j = 0; j < 3; ++j) {
-	    retval(i,j) = mat(i,j);
-	    retval(i,j+3) = 0;
-	    retval(i+3,j) = mat_dot(i,j);
-	    retval(i+3,j+3) = mat(i,j);
-	  }
-	}
+	retval.topLeftCorner<3,3>() = get();
+	retval.topRightCorner<3,3>().setZero();
+	retval.bottomLeftCorner<3,3>() = get_dot();
+	retval.bottomRightCorner<3,3>() = retval.topLeftCorner<3,3>();
 	return retval;
       }
     };
@@ -68,6 +65,8 @@ namespace fr {
     public:
       eci_to_ecef(const double &at_time) : at_time(at_time)
       {
+	FR_COORDINATES_COUNT(instrument_eci_to_ecef_built);
+	FR_COORDINATES_COUNT(instrument_gmst_evaluations);
 	fr::time::gmst time_gmst(at_time);
 	gha_rad = time_gmst.get_gmst() * 2.0 * fr::constants::pi / fr::constants::secs_per_ut1_day;
 	st = sin(gha_rad);
@@ -128,6 +127,115 @@ namespace fr {
       
     };
 
+    /**
+     * Rotation context for converting lots of points observed at the
+     * same time. Evaluates GMST and builds the rotation matrices once,
+     * instead of once per conversion like eci_to_ecef does. Pass one
+     * to the converters in place of the time. Nothing in here is
+     * virtual and the accessors return references, so reusing one
+     * costs nothing but the matrix multiply.
+     */
+
+    class eci_ecef_rotation {
+      double at_time;
+      Eigen::Matrix3d to_ecef;
+      Eigen::Matrix3d to_ecef_dot;
+      Eigen::Matrix3d to_eci;
+      Eigen::Matrix3d to_eci_dot;
+
+    public:
+      explicit eci_ecef_rotation(const double &at_time) : at_time(at_time)
+      {
+	FR_COORDINATES_COUNT(instrument_eci_ecef_rotation_built);
+	eci_to_ecef worker(at_time);
+	to_ecef = worker.get();
+	to_ecef_dot = worker.get_dot();
+	to_eci = to_ecef.transpose();
+	to_eci_dot = to_ecef_dot.transpose();
+      }
+
+      double get_time() const
+      {
+	return at_time;
+      }
+
+      // ECI to ECEF rotation and its time derivative
+      const Eigen::Matrix3d &get() const
+      {
+	return to_ecef;
+      }
+
+      const Eigen::Matrix3d &get_dot() const
+      {
+	return to_ecef_dot;
+      }
+
+      // ECEF to ECI rotation and its time derivative
+      const Eigen::Matrix3d &get_inverse() const
+      {
+	return to_eci;
+      }
+
+      const Eigen::Matrix3d &get_inverse_dot() const
+      {
+	return to_eci_dot;
+      }
+
+    };
+
+    /**
+     * Greenwich hour angle for lots of times that are close together.
+     * Evaluates GMST at anchor times every step seconds and interpolates
+     * the angle linearly in between, since it advances at a (very
+     * nearly) constant rate. The GMST polynomial's curvature over an
+     * hour amounts to around 1e-14 seconds, so the default step costs
+     * nothing in accuracy. Keeps the last segment it used, so sorted
+     * or clustered times evaluate GMST twice per step rather than once
+     * per point. A NaN or infinite time throws std::invalid_argument.
+     */
+
+    class gha_interpolator {
+      double step;
+      double t0;
+      double gha0;
+      double rate;
+      bool valid;
+
+      static double gha(const double &at_time)
+      {
+	FR_COORDINATES_COUNT(instrument_gmst_evaluations);
+	fr::time::gmst time_gmst(at_time);
+	return time_gmst.get_gmst() * 2.0 * fr::constants::pi / fr::constants::secs_per_ut1_day;
+      }
+
+    public:
+      gha_interpolator(double step = 3600.0) : step(step), t0(0.0), gha0(0.0), rate(0.0), valid(false)
+      {
+      }
+
+      // Hour angle in radians
+      double operator()(const double &at_time)
+      {
+	FR_COORDINATES_COUNT(instrument_gha_interpolations);
+	// Written so a NaN falls through to the check below
+	if (!valid || !(at_time >= t0 && at_time < t0 + step)) {
+	  if (!std::isfinite(at_time)) {
+	    throw std::invalid_argument("gha_interpolator time must be finite");
+	  }
+	  t0 = floor(at_time / step) * step;
+	  gha0 = gha(t0);
+	  double advance = gha(t0 + step) - gha0;
+	  if (advance < 0.0) {
+	    advance += 2.0 * fr::constants::pi;
+	  }
+	  rate = advance / step;
+	  valid = true;
+	}
+	return gha0 + rate * (at_time - t0);
+      }
+
+    };
+
   }
 
 }
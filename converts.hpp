@@ -19,6 +19,11 @@
  */
 
 #include "coordinates.hpp"
+#include "geodetic_solvers.hpp"
+#include "instrumentation.hpp"
+#include "inertial_frames.hpp"
+#include "local_frame.hpp"
+#include "xyz_point.hpp"
 #include <Eigen/Core>
 #include <type_traits>
 
@@ -29,7 +34,63 @@ namespace fr {
 
   namespace coordinates {
 
-    template <typename convert_to>
+    // The converters take either the coordinate classes or the plain
+    // value types from xyz_point.hpp as input.
+
+    template <typename T>
+    struct is_ecef_position : std::integral_constant<bool, std::is_same<T,ecef>::value || std::is_same<T,ecef_point>::value> {
+    };
+
+    template <typename T>
+    struct is_tod_eci_position : std::integral_constant<bool, std::is_same<T,tod_eci>::value || std::is_same<T,tod_eci_point>::value> {
+    };
+
+    template <typename T>
+    struct is_ecef_state : std::integral_constant<bool, std::is_same<T,ecef_vel>::value || std::is_same<T,ecef_vel_point>::value> {
+    };
+
+    template <typename T>
+    struct is_tod_eci_state : std::integral_constant<bool, std::is_same<T,tod_eci_vel>::value || std::is_same<T,tod_eci_vel_point>::value> {
+    };
+
+    // Frame tag of a position, or void for anything a frame_rotation
+    // can't take
+    template <typename T>
+    struct position_frame {
+      typedef void type;
+    };
+
+    template <>
+    struct position_frame<ecef> {
+      typedef ecef_frame type;
+    };
+
+    template <typename frame>
+    struct position_frame<xyz_point<frame> > {
+      typedef frame type;
+    };
+
+    // tod_eci and tod_eci_point are left out; see is_chain_source_frame
+    template <typename T>
+    struct is_chain_position : is_chain_source_frame<typename position_frame<T>::type> {
+    };
+
+    // The positions only a frame_rotation converts
+    template <typename T>
+    struct is_j2000_teme_position : std::integral_constant<bool, std::is_same<T,j2000_point>::value || std::is_same<T,teme_point>::value> {
+    };
+
+    // Lat/long to xyz math, shared by converter<ecef> and
+    // converter<ecef_point>
+
+    inline void lat_long_to_xyz(const lat_long &c, const ellipsoid_parameters &e, double &x, double &y, double &z)
+    {
+      geodetic_to_ecef(c.get_lat(), c.get_long(), c.get_alt(), e, x, y, z);
+    }
+
+    // datum is one of the tags from ellipsoid.hpp. Leave it off to pass
+    // the ellipsoid as a function argument instead.
+    template <typename convert_to, typename datum = void>
     struct converter {
 
     };
@@ -47,36 +108,28 @@ namespace fr {
       typename std::enable_if<std::is_same<convert_from,lat_long>::value,lat_long>::type
 	operator()(const convert_from &c)
       {
+	FR_COORDINATES_COUNT(instrument_to_lat_long);
 	return c;
       }
 
       // ECEF to Latlong
       template <typename convert_from>
-      typename std::enable_if<std::is_same<convert_from,ecef>::value,lat_long>::type 
+      typename std::enable_if<is_ecef_position<convert_from>::value,lat_long>::type 
       operator()(const convert_from &xyz, const ellipsoid_parameters &e = WGS84_ELLIPSOID, double tolerance = 0.0000000001 )
       {
-	double diff = 2 * tolerance;
-	double t = e.ee * xyz.get_z();
-	double n = 0.0;
-	double nph = 0.0;
-	double sinPhi = 0.0;
+	return (*this)(xyz, e, iterative_solver(tolerance));
+      }
+
+      // ECEF to Latlong with a specific solver from geodetic_solvers.hpp
+      template <typename convert_from, typename solver>
+      typename std::enable_if<is_ecef_position<convert_from>::value && is_geodetic_solver<solver>::value,lat_long>::type
+      operator()(const convert_from &xyz, const ellipsoid_parameters &e, const solver &solve)
+      {
+	FR_COORDINATES_COUNT(instrument_to_lat_long);
 	double lat;
 	double longitude;
 	double alt;
-
-	longitude = atan2(xyz.get_y(), xyz.get_x()) * 180 / fr::constants::pi;
-	while(diff > tolerance) {
-	  double zT = xyz.get_z() + t;
-	  nph = sqrt(pow(xyz.get_x(), 2) + pow(xyz.get_y(), 2) + pow(zT, 2));
-	  sinPhi = zT / nph;
-	  n = e.ae / sqrt(1 - e.ee * sinPhi * sinPhi);
-	  double told = t;
-	  t = n * e.ee * sinPhi;
-	  diff = fabs(t - told);
-	}
-	
-	lat = asin(sinPhi) * 180 / fr::constants::pi;
-	alt = nph - n;
+	solve(xyz.get_x(), xyz.get_y(), xyz.get_z(), e, lat, longitude, alt);
 	lat_long retval(lat, longitude, alt);
 	return retval;
       }
@@ -84,7 +137,7 @@ namespace fr {
       // ecef_vel to lat_long (Loses velocity information)
       
       template <typename convert_from>
-      typename std::enable_if<std::is_same<convert_from,ecef_vel>::value,lat_long>::type
+      typename std::enable_if<is_ecef_state<convert_from>::value,lat_long>::type
       operator()(const convert_from &c, const ellipsoid_parameters &e = WGS84_ELLIPSOID)
       {
 	ecef interim = converter<ecef>()(c);
@@ -94,7 +147,7 @@ namespace fr {
 
       // tod_eci_vel to latlong (Loses velocity information)
       template <typename convert_from>
-      typename std::enable_if<std::is_same<convert_from,tod_eci_vel>::value,lat_long>::type
+      typename std::enable_if<is_tod_eci_state<convert_from>::value,lat_long>::type
       operator()(const convert_from &c, const double &t, const ellipsoid_parameters e = WGS84_ELLIPSOID)
       {
 	// Convert from tod_eci to ecef_vel
@@ -103,6 +156,26 @@ namespace fr {
 	lat_long retval = converter<lat_long>()(interim, e);
 	return retval;
       }
+
+      // tod_eci_vel to latlong with a precomputed rotation context
+      template <typename convert_from>
+      typename std::enable_if<is_tod_eci_state<convert_from>::value,lat_long>::type
+      operator()(const convert_from &c, const eci_ecef_rotation &r, const ellipsoid_parameters e = WGS84_ELLIPSOID)
+      {
+	// Velocity doesn't affect position, so just rotate the position
+	ecef_point interim;
+	interim.map_xyz().noalias() = r.get() * c.map_xyz();
+	lat_long retval = converter<lat_long>()(interim, e);
+	return retval;
+      }
+
+      // enu_point or ned_point to latlong, using the frame's ellipsoid
+      template <typename convert_from>
+      typename std::enable_if<is_local_position<convert_from>::value,lat_long>::type
+      operator()(const convert_from &c, const local_frame &f, double tolerance = 0.0000000001)
+      {
+	return (*this)(f.to_ecef(c), f.get_ellipsoid(), tolerance);
+      }
       
     };
 
@@ -118,49 +191,71 @@ namespace fr {
       typename std::enable_if<std::is_same<convert_from,ecef>::value,ecef>::type
       operator()(const convert_from &c)
       {
+	FR_COORDINATES_COUNT(instrument_to_ecef);
 	return c;
       }
 
+      // ecef_point to ecef
+      template <typename convert_from>
+      typename std::enable_if<std::is_same<convert_from,ecef_point>::value,ecef>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef);
+	ecef retval(c.x, c.y, c.z);
+	return retval;
+      }
+
       // latlong to ecef
       template <typename convert_from>
       typename std::enable_if<std::is_same<convert_from,lat_long>::value,ecef>::type
       operator()(const convert_from &c, const ellipsoid_parameters &e = WGS84_ELLIPSOID)
       {
+	FR_COORDINATES_COUNT(instrument_to_ecef);
 	double x,y,z;
-	const double &pi = fr::constants::pi;
-	double slat = sin(c.get_lat() * pi / 180);
-	double clat = cos(c.get_lat() * pi / 180);
-	double slon = sin(c.get_long() * pi / 180);
-	double clon = cos(c.get_long() * pi / 180);
-	double n = e.ae / sqrt(1.0 - e.ee * pow(slat, 2));
-	x = (n + c.get_alt()) * clat * clon;
-	y = (n + c.get_alt()) * clat * slon;
-	z = (n * (1.0 - e.ee) + c.get_alt()) * slat;
+	lat_long_to_xyz(c, e, x, y, z);
 	ecef retval(x,y,z);
 	return retval;
       }
 
       // ecef_vel to ecef (loses velocity information)
       template <typename convert_from>
-      typename std::enable_if<std::is_same<convert_from,ecef_vel>::value,ecef>::type
+      typename std::enable_if<is_ecef_state<convert_from>::value,ecef>::type
       operator()(const convert_from &c)
       {
+	FR_COORDINATES_COUNT(instrument_to_ecef);
 	ecef retval(c.get_x(), c.get_y(), c.get_z());
 	return retval;
       }
 
       // tod_eci to ecef (Requires time coordinate was measured)
       template <typename convert_from>
-      typename std::enable_if<std::is_same<convert_from,tod_eci>::value,ecef>::type
+      typename std::enable_if<is_tod_eci_position<convert_from>::value,ecef>::type
       operator()(const convert_from &c, const double &at_time)
       {
-	eci_to_ecef conversion_matrix(at_time);
-	Eigen::Vector3d c_vec = c.get_xyz();
-	Eigen::Matrix3d c_mat = conversion_matrix.get();
-	Eigen::Vector3d interim = c_mat * c_vec;
+	return (*this)(c, eci_ecef_rotation(at_time));
+      }
+
+      // tod_eci to ecef with a precomputed rotation context
+      template <typename convert_from>
+      typename std::enable_if<is_tod_eci_position<convert_from>::value,ecef>::type
+      operator()(const convert_from &c, const eci_ecef_rotation &r)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef);
+	Eigen::Vector3d interim = r.get() * c.map_xyz();
 	ecef retval(interim(0), interim(1), interim(2));
 	return retval;
       }
+
+      // enu_point or ned_point to ecef
+      template <typename convert_from>
+      typename std::enable_if<is_local_position<convert_from>::value,ecef>::type
+      operator()(const convert_from &c, const local_frame &f)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef);
+	ecef_point interim = f.to_ecef(c);
+	ecef retval(interim.x, interim.y, interim.z);
+	return retval;
+      }
       
     };
 
@@ -178,18 +273,35 @@ namespace fr {
       typename std::enable_if<std::is_same<convert_from,tod_eci>::value,tod_eci>::type
       operator()(const convert_from &c)
       {
+	FR_COORDINATES_COUNT(instrument_to_tod_eci);
 	return c;
       }
 
+      // tod_eci_point to tod_eci
+      template <typename convert_from>
+      typename std::enable_if<std::is_same<convert_from,tod_eci_point>::value,tod_eci>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_tod_eci);
+	tod_eci retval(c.x, c.y, c.z);
+	return retval;
+      }
+
       // ecef to tod_eci (Requires time coordinate was measured)
       template <typename convert_from>
-      typename std::enable_if<std::is_same<convert_from,ecef>::value,tod_eci>::type
+      typename std::enable_if<is_ecef_position<convert_from>::value,tod_eci>::type
       operator()(const convert_from &c, const double &time_at)
       {
-	ecef_to_eci conversion_matrix(time_at);
-	Eigen::Vector3d c_vec = c.get_xyz();
-	Eigen::Matrix3d c_mat = conversion_matrix.get();
-	Eigen::Vector3d interim = c_mat * c_vec;
+	return (*this)(c, eci_ecef_rotation(time_at));
+      }
+
+      // ecef to tod_eci with a precomputed rotation context
+      template <typename convert_from>
+      typename std::enable_if<is_ecef_position<convert_from>::value,tod_eci>::type
+      operator()(const convert_from &c, const eci_ecef_rotation &r)
+      {
+	FR_COORDINATES_COUNT(instrument_to_tod_eci);
+	Eigen::Vector3d interim = r.get_inverse() * c.map_xyz();
 	tod_eci retval(interim(0), interim(1), interim(2));
 	return retval;
       }
@@ -207,21 +319,41 @@ namespace fr {
       typename std::enable_if<std::is_same<convert_from,ecef_vel>::value,ecef_vel>::type
       operator()(const convert_from &c)
       {
+	FR_COORDINATES_COUNT(instrument_to_ecef_vel);
 	return c;
       }
 
+      // ecef_vel_point to ecef_vel
+      template <typename convert_from>
+      typename std::enable_if<std::is_same<convert_from,ecef_vel_point>::value,ecef_vel>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef_vel);
+	ecef_vel retval(c.x, c.y, c.z, c.dx, c.dy, c.dz);
+	return retval;
+      }
+
       // tod_eci_vel to ecef_vel (requires time component)
       template <typename convert_from>
-      typename std::enable_if<std::is_same<convert_from,tod_eci_vel>::value,ecef_vel>::type
+      typename std::enable_if<is_tod_eci_state<convert_from>::value,ecef_vel>::type
       operator()(const convert_from &c, const double &time_at)
       {
-	Eigen::Matrix<double,6,1> vec = c.get_vector();
-	eci_to_ecef cm(time_at);
-	Eigen::Matrix<double,6,6> c_mat = cm.get_xyz_vel();
-	Eigen::Matrix<double,6,1> interim = c_mat * vec;
-	ecef_vel retval(interim(0), interim(1), interim(2), interim(3), interim(4), interim(5));
+	return (*this)(c, eci_ecef_rotation(time_at));
+      }
+
+      // tod_eci_vel to ecef_vel with a precomputed rotation context.
+      // The 6x6 state matrix is [R 0; R' R], so only the blocks that
+      // aren't zero get multiplied.
+      template <typename convert_from>
+      typename std::enable_if<is_tod_eci_state<convert_from>::value,ecef_vel>::type
+      operator()(const convert_from &c, const eci_ecef_rotation &r)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef_vel);
+	Eigen::Vector3d pos = r.get() * c.map_xyz();
+	Eigen::Vector3d vel = r.get_dot() * c.map_xyz() + r.get() * c.map_deltas();
+	ecef_vel retval(pos(0), pos(1), pos(2), vel(0), vel(1), vel(2));
 	return retval;
-      }      
+      }
 
     };
 
@@ -237,20 +369,420 @@ namespace fr {
       typename std::enable_if<std::is_same<convert_from,tod_eci_vel>::value,tod_eci_vel>::type
       operator()(const convert_from &c)
       {
+	FR_COORDINATES_COUNT(instrument_to_tod_eci_vel);
 	return c;
       }
 
+      // from tod_eci_vel_point to tod_eci_vel
+      template <typename convert_from>
+      typename std::enable_if<std::is_same<convert_from,tod_eci_vel_point>::value,tod_eci_vel>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_tod_eci_vel);
+	tod_eci_vel retval(c.x, c.y, c.z, c.dx, c.dy, c.dz);
+	return retval;
+      }
+
       // from ecef_vel to tod_eci_vel
       template <typename convert_from>
-      typename std::enable_if<std::is_same<convert_from,ecef_vel>::value,tod_eci_vel>::type
+      typename std::enable_if<is_ecef_state<convert_from>::value,tod_eci_vel>::type
       operator()(const convert_from &c, const double &t)
       {
-	ecef_to_eci cm(t);
-	Eigen::Matrix<double,6,1> vec = c.get_vector();
-	Eigen::Matrix<double,6,6> c_mat = cm.get_xyz_vel();
-	Eigen::Matrix<double,6,1> interim = c_mat * vec;
-	tod_eci_vel retval(interim(0), interim(1), interim(2), interim(3), interim(4), interim(5));
-	return retval;			   
+	return (*this)(c, eci_ecef_rotation(t));
+      }
+
+      // from ecef_vel to tod_eci_vel with a precomputed rotation context
+      template <typename convert_from>
+      typename std::enable_if<is_ecef_state<convert_from>::value,tod_eci_vel>::type
+      operator()(const convert_from &c, const eci_ecef_rotation &r)
+      {
+	FR_COORDINATES_COUNT(instrument_to_tod_eci_vel);
+	Eigen::Vector3d pos = r.get_inverse() * c.map_xyz();
+	Eigen::Vector3d vel = r.get_inverse_dot() * c.map_xyz() + r.get_inverse() * c.map_deltas();
+	tod_eci_vel retval(pos(0), pos(1), pos(2), vel(0), vel(1), vel(2));
+	return retval;
+      }
+
+    };
+
+    /********************************************************************
+     * Put ecef_point stuff here
+     */
+
+    template<>
+    struct converter<ecef_point> {
+
+      // From ecef or ecef_point
+      template <typename convert_from>
+      typename std::enable_if<is_ecef_position<convert_from>::value,ecef_point>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef_point);
+	return ecef_point(c.get_x(), c.get_y(), c.get_z());
+      }
+
+      // From lat_long
+      template <typename convert_from>
+      typename std::enable_if<std::is_same<convert_from,lat_long>::value,ecef_point>::type
+      operator()(const convert_from &c, const ellipsoid_parameters &e = WGS84_ELLIPSOID)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef_point);
+	ecef_point retval;
+	lat_long_to_xyz(c, e, retval.x, retval.y, retval.z);
+	return retval;
+      }
+
+      // From ecef_vel or ecef_vel_point (loses velocity information)
+      template <typename convert_from>
+      typename std::enable_if<is_ecef_state<convert_from>::value,ecef_point>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef_point);
+	return ecef_point(c.get_x(), c.get_y(), c.get_z());
+      }
+
+      // From tod_eci or tod_eci_point (Requires time coordinate was measured)
+      template <typename convert_from>
+      typename std::enable_if<is_tod_eci_position<convert_from>::value,ecef_point>::type
+      operator()(const convert_from &c, const double &at_time)
+      {
+	return (*this)(c, eci_ecef_rotation(at_time));
+      }
+
+      // From tod_eci or tod_eci_point with a precomputed rotation context
+      template <typename convert_from>
+      typename std::enable_if<is_tod_eci_position<convert_from>::value,ecef_point>::type
+      operator()(const convert_from &c, const eci_ecef_rotation &r)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef_point);
+	ecef_point retval;
+	retval.map_xyz().noalias() = r.get() * c.map_xyz();
+	return retval;
+      }
+
+      // From enu_point or ned_point
+      template <typename convert_from>
+      typename std::enable_if<is_local_position<convert_from>::value,ecef_point>::type
+      operator()(const convert_from &c, const local_frame &f)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef_point);
+	return f.to_ecef(c);
+      }
+
+      // From j2000_point or teme_point through the full chain
+      template <typename convert_from>
+      typename std::enable_if<is_chain_position<convert_from>::value,ecef_point>::type
+      operator()(const convert_from &c, const frame_rotation &r)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef_point);
+	ecef_point retval;
+	r.template rotate<typename position_frame<convert_from>::type, ecef_frame>(c.map_xyz(), retval.map_xyz());
+	return retval;
+      }
+
+      // From j2000_point or teme_point (Requires time coordinate was measured)
+      template <typename convert_from>
+      typename std::enable_if<is_j2000_teme_position<convert_from>::value,ecef_point>::type
+      operator()(const convert_from &c, const double &at_time)
+      {
+	return (*this)(c, frame_rotation(at_time));
+      }
+
+    };
+
+    /********************************************************************
+     * Put tod_eci_point stuff here
+     */
+
+    template<>
+    struct converter<tod_eci_point> {
+
+      // From tod_eci or tod_eci_point
+      template <typename convert_from>
+      typename std::enable_if<is_tod_eci_position<convert_from>::value,tod_eci_point>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_tod_eci_point);
+	return tod_eci_point(c.get_x(), c.get_y(), c.get_z());
+      }
+
+      // From ecef or ecef_point (Requires time coordinate was measured)
+      template <typename convert_from>
+      typename std::enable_if<is_ecef_position<convert_from>::value,tod_eci_point>::type
+      operator()(const convert_from &c, const double &time_at)
+      {
+	return (*this)(c, eci_ecef_rotation(time_at));
+      }
+
+      // From ecef or ecef_point with a precomputed rotation context
+      template <typename convert_from>
+      typename std::enable_if<is_ecef_position<convert_from>::value,tod_eci_point>::type
+      operator()(const convert_from &c, const eci_ecef_rotation &r)
+      {
+	FR_COORDINATES_COUNT(instrument_to_tod_eci_point);
+	tod_eci_point retval;
+	retval.map_xyz().noalias() = r.get_inverse() * c.map_xyz();
+	return retval;
+      }
+
+      // From j2000_point, teme_point or ecef through the full chain. This
+      // is true of date, which eci_ecef_rotation's tod_eci is not quite;
+      // see inertial_frames.hpp.
+      template <typename convert_from>
+      typename std::enable_if<is_chain_position<convert_from>::value,tod_eci_point>::type
+      operator()(const convert_from &c, const frame_rotation &r)
+      {
+	FR_COORDINATES_COUNT(instrument_to_tod_eci_point);
+	tod_eci_point retval;
+	r.template rotate<typename position_frame<convert_from>::type, tod_eci_frame>(c.map_xyz(), retval.map_xyz());
+	return retval;
+      }
+
+      // From j2000_point or teme_point (Requires time coordinate was measured)
+      template <typename convert_from>
+      typename std::enable_if<is_j2000_teme_position<convert_from>::value,tod_eci_point>::type
+      operator()(const convert_from &c, const double &time_at)
+      {
+	return (*this)(c, frame_rotation(time_at));
+      }
+
+    };
+
+    /********************************************************************
+     * Put ecef_vel_point stuff here
+     */
+
+    template<>
+    struct converter<ecef_vel_point> {
+
+      // From ecef_vel or ecef_vel_point
+      template <typename convert_from>
+      typename std::enable_if<is_ecef_state<convert_from>::value,ecef_vel_point>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef_vel_point);
+	return ecef_vel_point(c.get_x(), c.get_y(), c.get_z(), c.get_dx(), c.get_dy(), c.get_dz());
+      }
+
+      // From tod_eci_vel or tod_eci_vel_point (requires time component)
+      template <typename convert_from>
+      typename std::enable_if<is_tod_eci_state<convert_from>::value,ecef_vel_point>::type
+      operator()(const convert_from &c, const double &time_at)
+      {
+	return (*this)(c, eci_ecef_rotation(time_at));
+      }
+
+      // From tod_eci_vel or tod_eci_vel_point with a precomputed rotation context
+      template <typename convert_from>
+      typename std::enable_if<is_tod_eci_state<convert_from>::value,ecef_vel_point>::type
+      operator()(const convert_from &c, const eci_ecef_rotation &r)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef_vel_point);
+	ecef_vel_point retval;
+	retval.map_xyz().noalias() = r.get() * c.map_xyz();
+	retval.map_deltas().noalias() = r.get_dot() * c.map_xyz() + r.get() * c.map_deltas();
+	return retval;
+      }
+
+    };
+
+    /********************************************************************
+     * Put tod_eci_vel_point stuff here
+     */
+
+    template<>
+    struct converter<tod_eci_vel_point> {
+
+      // From tod_eci_vel or tod_eci_vel_point
+      template <typename convert_from>
+      typename std::enable_if<is_tod_eci_state<convert_from>::value,tod_eci_vel_point>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_tod_eci_vel_point);
+	return tod_eci_vel_point(c.get_x(), c.get_y(), c.get_z(), c.get_dx(), c.get_dy(), c.get_dz());
+      }
+
+      // From ecef_vel or ecef_vel_point (requires time component)
+      template <typename convert_from>
+      typename std::enable_if<is_ecef_state<convert_from>::value,tod_eci_vel_point>::type
+      operator()(const convert_from &c, const double &t)
+      {
+	return (*this)(c, eci_ecef_rotation(t));
+      }
+
+      // From ecef_vel or ecef_vel_point with a precomputed rotation context
+      template <typename convert_from>
+      typename std::enable_if<is_ecef_state<convert_from>::value,tod_eci_vel_point>::type
+      operator()(const convert_from &c, const eci_ecef_rotation &r)
+      {
+	FR_COORDINATES_COUNT(instrument_to_tod_eci_vel_point);
+	tod_eci_vel_point retval;
+	retval.map_xyz().noalias() = r.get_inverse() * c.map_xyz();
+	retval.map_deltas().noalias() = r.get_inverse_dot() * c.map_xyz() + r.get_inverse() * c.map_deltas();
+	return retval;
+      }
+
+    };
+
+    /********************************************************************
+     * Put enu_point and ned_point stuff here
+     */
+
+    template <typename frame>
+    struct local_point_converter {
+      typedef xyz_point<frame> point_type;
+
+      // From ecef or ecef_point
+      template <typename convert_from>
+      typename std::enable_if<is_ecef_position<convert_from>::value,point_type>::type
+      operator()(const convert_from &c, const local_frame &f)
+      {
+	FR_COORDINATES_COUNT(instrument_to_local_point);
+	return f.template to_local<frame>(c.map_xyz());
+      }
+
+      // From lat_long, using the frame's ellipsoid
+      template <typename convert_from>
+      typename std::enable_if<std::is_same<convert_from,lat_long>::value,point_type>::type
+      operator()(const convert_from &c, const local_frame &f)
+      {
+	FR_COORDINATES_COUNT(instrument_to_local_point);
+	Eigen::Vector3d xyz;
+	lat_long_to_xyz(c, f.get_ellipsoid(), xyz(0), xyz(1), xyz(2));
+	return f.template to_local<frame>(xyz);
+      }
+
+      // From the same local frame
+      template <typename convert_from>
+      typename std::enable_if<std::is_same<convert_from,point_type>::value,point_type>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_local_point);
+	return c;
+      }
+
+      // From the other local frame at the same origin. Going either way
+      // between ENU and NED swaps the first two axes and flips the third.
+      template <typename convert_from>
+      typename std::enable_if<is_local_position<convert_from>::value && !std::is_same<convert_from,point_type>::value,point_type>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_local_point);
+	return point_type(c.y, c.x, -c.z);
+      }
+
+    };
+
+    template<>
+    struct converter<enu_point> : public local_point_converter<enu_frame> {
+    };
+
+    template<>
+    struct converter<ned_point> : public local_point_converter<ned_frame> {
+    };
+
+    /********************************************************************
+     * Put j2000_point and teme_point stuff here
+     */
+
+    template <typename frame>
+    struct inertial_point_converter {
+      typedef xyz_point<frame> point_type;
+
+      // From ecef, j2000_point or teme_point, with the chain for the
+      // epoch
+      template <typename convert_from>
+      typename std::enable_if<is_chain_position<convert_from>::value,point_type>::type
+      operator()(const convert_from &c, const frame_rotation &r)
+      {
+	FR_COORDINATES_COUNT(instrument_to_inertial_point);
+	point_type retval;
+	r.template rotate<typename position_frame<convert_from>::type, frame>(c.map_xyz(), retval.map_xyz());
+	return retval;
+      }
+
+      // Same, building the chain for the time coordinate was measured,
+      // without polar motion or nutation corrections
+      template <typename convert_from>
+      typename std::enable_if<is_chain_position<convert_from>::value,point_type>::type
+      operator()(const convert_from &c, const double &at_time)
+      {
+	return (*this)(c, frame_rotation(at_time));
+      }
+
+    };
+
+    template<>
+    struct converter<j2000_point> : public inertial_point_converter<j2000_frame> {
+    };
+
+    template<>
+    struct converter<teme_point> : public inertial_point_converter<teme_frame> {
+    };
+
+    /********************************************************************
+     * Datum specific converters. These take the ellipsoid as a template
+     * parameter, e.g. converter<ecef, wgs84>()(some_lat_long), so its
+     * constants fold into the conversion at compile time.
+     */
+
+    template <typename datum>
+    struct converter<lat_long, datum> {
+
+      // Defaults to the closed form solver, since the iterative one's
+      // loop would get in the way of any constant folding
+      template <typename convert_from>
+      typename std::enable_if<is_ecef_position<convert_from>::value || is_ecef_state<convert_from>::value,lat_long>::type
+      operator()(const convert_from &c)
+      {
+	return (*this)(c, vermeille_solver());
+      }
+
+      template <typename convert_from, typename solver>
+      typename std::enable_if<(is_ecef_position<convert_from>::value || is_ecef_state<convert_from>::value) && is_geodetic_solver<solver>::value,lat_long>::type
+      operator()(const convert_from &c, const solver &solve)
+      {
+	FR_COORDINATES_COUNT(instrument_to_lat_long);
+	constexpr ellipsoid_parameters e = datum::ellipsoid();
+	double lat;
+	double longitude;
+	double alt;
+	solve(c.get_x(), c.get_y(), c.get_z(), e, lat, longitude, alt);
+	lat_long retval(lat, longitude, alt);
+	return retval;
+      }
+
+    };
+
+    template <typename datum>
+    struct converter<ecef, datum> {
+
+      template <typename convert_from>
+      typename std::enable_if<std::is_same<convert_from,lat_long>::value,ecef>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef);
+	constexpr ellipsoid_parameters e = datum::ellipsoid();
+	double x,y,z;
+	lat_long_to_xyz(c, e, x, y, z);
+	ecef retval(x,y,z);
+	return retval;
+      }
+
+    };
+
+    template <typename datum>
+    struct converter<ecef_point, datum> {
+
+      template <typename convert_from>
+      typename std::enable_if<std::is_same<convert_from,lat_long>::value,ecef_point>::type
+      operator()(const convert_from &c)
+      {
+	FR_COORDINATES_COUNT(instrument_to_ecef_point);
+	constexpr ellipsoid_parameters e = datum::ellipsoid();
+	ecef_point retval;
+	lat_long_to_xyz(c, e, retval.x, retval.y, retval.z);
+	return retval;
       }
 
     };
@@ -0,0 +1,336 @@
+/**
+ * Binary columnar file format for large sets of coordinates, with
+ * memory mapped readers and writers. The columns in the file are plain
+ * arrays of doubles, so they can be handed straight to the structure of
+ * arrays batch converters without parsing or copying anything.
+ *
+ * Layout, all in the byte order of the machine that wrote it:
+ *
+ *   header          128 bytes, see coordinate_file::header
+ *   column 0        count doubles, padded to a multiple of 64 bytes
+ *   column 1        ...
+ *   timestamps      optional, count doubles
+ *
+ * The columns depend on the frame. lat_long files have lat, lon (in
+ * degrees) and alt (meters). ecef and tod_eci files have x, y, z, and
+ * the velocity frames add dx, dy, dz. Timestamps are seconds since the
+ * Unix epoch, same as everywhere else in this library. The header
+ * epoch is the time shared by every point in files that don't have a
+ * timestamp column, and just informational in ones that do.
+ *
+ * Readers and writers throw std::runtime_error if the file can't be
+ * opened, mapped or isn't a valid coordinate file. POSIX only.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_COORDINATE_FILE
+#define _HPP_COORDINATE_FILE
+
+#include "ellipsoid.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fr {
+
+  namespace coordinates {
+
+    // Read only view of one column
+    struct column_span {
+      const double *data;
+      size_t size;
+
+      const double *begin() const { return data; }
+      const double *end() const { return data + size; }
+      const double &operator[](size_t i) const { return data[i]; }
+    };
+
+    struct coordinate_file {
+
+      enum frame_type {
+	lat_long_frame = 0,
+	ecef_position_frame = 1,
+	tod_eci_position_frame = 2,
+	ecef_vel_frame = 3,
+	tod_eci_vel_frame = 4
+      };
+
+      // Column numbers
+      enum { lat = 0, lon = 1, alt = 2 };
+      enum { x = 0, y = 1, z = 2, dx = 3, dy = 4, dz = 5 };
+
+      enum { header_size = 128, alignment = 64, version = 1 };
+
+      struct header {
+	char magic[8];
+	uint32_t byte_order;
+	uint32_t file_version;
+	uint32_t frame;
+	uint32_t has_times;
+	uint64_t count;
+	double epoch;
+	double ae;
+	double ee;
+	char reserved[header_size - 56];
+      };
+
+      static const char *magic() { return "FRCOORD"; }
+      static uint32_t byte_order_mark() { return 0x01020304; }
+
+      static unsigned columns(uint32_t frame)
+      {
+	return (frame == ecef_vel_frame || frame == tod_eci_vel_frame) ? 6 : 3;
+      }
+
+      // Bytes from the start of one column to the next
+      static size_t column_stride(uint64_t count)
+      {
+	size_t bytes = count * sizeof(double);
+	return (bytes + alignment - 1) / alignment * alignment;
+      }
+
+      static size_t file_size(uint32_t frame, uint64_t count, bool has_times)
+      {
+	return header_size + column_stride(count) * (columns(frame) + (has_times ? 1 : 0));
+      }
+
+      static std::runtime_error error(const std::string &what, const std::string &path)
+      {
+	std::string message = what + " " + path;
+	if (errno != 0) {
+	  message += ": ";
+	  message += strerror(errno);
+	}
+	return std::runtime_error(message);
+      }
+
+    };
+
+    static_assert(sizeof(coordinate_file::header) == coordinate_file::header_size, "coordinate_file::header should be 128 bytes");
+
+    /**
+     * Maps an existing coordinate file read only. The columns stay
+     * valid as long as the reader does.
+     */
+
+    class coordinate_file_reader {
+      void *mapped;
+      size_t mapped_size;
+      const coordinate_file::header *head;
+
+      // Timestamps are the column after the last coordinate column
+      column_span column_at(unsigned column) const
+      {
+	const char *start = static_cast<const char *>(mapped) + coordinate_file::header_size + column * coordinate_file::column_stride(head->count);
+	column_span retval = { reinterpret_cast<const double *>(start), (size_t) head->count };
+	return retval;
+      }
+
+    public:
+
+      explicit coordinate_file_reader(const std::string &path) : mapped(MAP_FAILED), mapped_size(0), head(nullptr)
+      {
+	errno = 0;
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+	  throw coordinate_file::error("Can't open", path);
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+	  close(fd);
+	  throw coordinate_file::error("Can't stat", path);
+	}
+	mapped_size = info.st_size;
+	if (mapped_size < coordinate_file::header_size) {
+	  close(fd);
+	  errno = 0;
+	  throw coordinate_file::error("Too short to be a coordinate file:", path);
+	}
+	mapped = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+	  throw coordinate_file::error("Can't map", path);
+	}
+	head = static_cast<const coordinate_file::header *>(mapped);
+	errno = 0;
+	if (memcmp(head->magic, coordinate_file::magic(), sizeof(head->magic)) != 0) {
+	  munmap(mapped, mapped_size);
+	  throw coordinate_file::error("Not a coordinate file:", path);
+	}
+	if (head->byte_order != coordinate_file::byte_order_mark()) {
+	  munmap(mapped, mapped_size);
+	  throw coordinate_file::error("Coordinate file has the wrong byte order:", path);
+	}
+	if (head->file_version != coordinate_file::version || head->frame > coordinate_file::tod_eci_vel_frame) {
+	  munmap(mapped, mapped_size);
+	  throw coordinate_file::error("Unsupported coordinate file version or frame:", path);
+	}
+	// Check the count against the file before using it in any size,
+	// or a big enough one wraps the column stride around
+	uint64_t per_point = sizeof(double) * (coordinate_file::columns(head->frame) + (head->has_times ? 1 : 0));
+	if (head->count > (mapped_size - coordinate_file::header_size) / per_point ||
+	    mapped_size < coordinate_file::file_size(head->frame, head->count, head->has_times != 0)) {
+	  munmap(mapped, mapped_size);
+	  throw coordinate_file::error("Coordinate file is truncated:", path);
+	}
+      }
+
+      ~coordinate_file_reader()
+      {
+	munmap(mapped, mapped_size);
+      }
+
+      coordinate_file_reader(const coordinate_file_reader &) = delete;
+      coordinate_file_reader &operator=(const coordinate_file_reader &) = delete;
+
+      coordinate_file::frame_type get_frame() const { return (coordinate_file::frame_type) head->frame; }
+      size_t size() const { return head->count; }
+      double get_epoch() const { return head->epoch; }
+      bool has_times() const { return head->has_times != 0; }
+      unsigned columns() const { return coordinate_file::columns(head->frame); }
+
+      ellipsoid_parameters get_ellipsoid() const
+      {
+	return ellipsoid_parameters(head->ae, head->ee);
+      }
+
+      // Throws std::out_of_range past the last column
+      column_span get_column(unsigned column) const
+      {
+	if (column >= columns()) {
+	  throw std::out_of_range("coordinate_file_reader::get_column: no such column");
+	}
+	return column_at(column);
+      }
+
+      // Empty if the file has no timestamps
+      column_span get_times() const
+      {
+	if (!has_times()) {
+	  column_span none = { nullptr, 0 };
+	  return none;
+	}
+	return column_at(columns());
+      }
+
+      // Tells the kernel the file will be read front to back
+      void advise_sequential() const
+      {
+	madvise(mapped, mapped_size, MADV_SEQUENTIAL);
+      }
+
+    };
+
+    /**
+     * Creates (or replaces) a coordinate file big enough for count
+     * points and maps it for writing. Fill the columns in place, for
+     * example by pointing a batch converter's outputs at them. Writes
+     * go straight to the file's pages; flush() waits for them to reach
+     * the disk.
+     */
+
+    class coordinate_file_writer {
+      void *mapped;
+      size_t mapped_size;
+      coordinate_file::header *head;
+      std::string path;
+
+      double *column_at(unsigned column)
+      {
+	char *start = static_cast<char *>(mapped) + coordinate_file::header_size + column * coordinate_file::column_stride(head->count);
+	return reinterpret_cast<double *>(start);
+      }
+
+    public:
+
+      coordinate_file_writer(const std::string &path, coordinate_file::frame_type frame, size_t count, bool has_times = false, double epoch = 0.0, const ellipsoid_parameters &e = WGS84_ELLIPSOID) : mapped(MAP_FAILED), mapped_size(coordinate_file::file_size(frame, count, has_times)), head(nullptr), path(path)
+      {
+	errno = 0;
+	int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+	  throw coordinate_file::error("Can't create", path);
+	}
+	if (ftruncate(fd, mapped_size) != 0) {
+	  close(fd);
+	  throw coordinate_file::error("Can't size", path);
+	}
+	mapped = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+	  throw coordinate_file::error("Can't map", path);
+	}
+	head = static_cast<coordinate_file::header *>(mapped);
+	memset(head, 0, sizeof(*head));
+	memcpy(head->magic, coordinate_file::magic(), sizeof(head->magic));
+	head->byte_order = coordinate_file::byte_order_mark();
+	head->file_version = coordinate_file::version;
+	head->frame = frame;
+	head->has_times = has_times ? 1 : 0;
+	head->count = count;
+	head->epoch = epoch;
+	head->ae = e.ae;
+	head->ee = e.ee;
+      }
+
+      ~coordinate_file_writer()
+      {
+	munmap(mapped, mapped_size);
+      }
+
+      coordinate_file_writer(const coordinate_file_writer &) = delete;
+      coordinate_file_writer &operator=(const coordinate_file_writer &) = delete;
+
+      size_t size() const { return head->count; }
+      unsigned columns() const { return coordinate_file::columns(head->frame); }
+
+      // Throws std::out_of_range past the last column
+      double *get_column(unsigned column)
+      {
+	if (column >= columns()) {
+	  throw std::out_of_range("coordinate_file_writer::get_column: no such column");
+	}
+	return column_at(column);
+      }
+
+      // nullptr if the file was created without timestamps
+      double *get_times()
+      {
+	return head->has_times ? column_at(columns()) : nullptr;
+      }
+
+      // Waits for everything written so far to reach the disk
+      void flush()
+      {
+	errno = 0;
+	if (msync(mapped, mapped_size, MS_SYNC) != 0) {
+	  throw coordinate_file::error("Can't flush", path);
+	}
+      }
+
+    };
+
+  }
+
+}
+
+#endif
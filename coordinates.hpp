@@ -21,14 +21,21 @@
 
 #include "constants.hpp"
 #include "conversion_matrices.hpp"
+#include "rotation_cache.hpp"
 #include "ecef.hpp"
 #include "ecef_vel.hpp"
 #include "ellipsoid.hpp"
+#include "geodetic_solvers.hpp"
+#include "inertial_frames.hpp"
+#include "instrumentation.hpp"
 #include "lat_long.hpp"
+#include "local_frame.hpp"
 #include "tod_eci.hpp"
 #include "tod_eci_vel.hpp"
 #include "xyz_coordinate.hpp"
 #include "xyz_velocity.hpp"
+#include "xyz_point.hpp"
 #include "converts.hpp"
+#include "batch_converts.hpp"
 
 #endif
@@ -24,16 +24,71 @@ namespace fr {
 
   namespace coordinates {
 
+    // sqrt isn't constexpr, so use Newton's method, stopping once it
+    // settles. Good to the last bit or so.
+    constexpr double constexpr_sqrt_step(double x, double guess, double previous, int rounds)
+    {
+      return (rounds == 0 || guess == previous) ? guess : constexpr_sqrt_step(x, 0.5 * (guess + x / guess), guess, rounds - 1);
+    }
+
+    constexpr double constexpr_sqrt(double x)
+    {
+      return x == 0.0 ? 0.0 : constexpr_sqrt_step(x, x < 1.0 ? 1.0 : x, 0.0, 128);
+    }
+
+    /**
+     * Literal type, so ellipsoids can be constexpr and everything
+     * derived from the semi-major axis and eccentricity is worked out
+     * once, at compile time if the ellipsoid is constexpr.
+     */
+
     struct ellipsoid_parameters {
-      double ae;
-      double ee;
+      double ae;           // Semi-major axis (meters)
+      double ee;           // First eccentricity squared
+      double one_minus_ee; // 1 - ee
+      double be;           // Semi-minor axis (meters)
+      double f;            // Flattening
+      double ep2;          // Second eccentricity squared
+
+      constexpr ellipsoid_parameters(const double &ae, const double &ee) : ae(ae), ee(ee), one_minus_ee(1.0 - ee), be(ae * constexpr_sqrt(1.0 - ee)), f(1.0 - constexpr_sqrt(1.0 - ee)), ep2(ee / (1.0 - ee))
+      {
+      }
 
-      ellipsoid_parameters(const double &ae, const double &ee) : ae(ae), ee(ee)
+      // Most datums are published as a semi-major axis and an inverse
+      // flattening
+      static constexpr ellipsoid_parameters from_flattening(double ae, double inverse_flattening)
       {
+	return ellipsoid_parameters(ae, (2.0 - 1.0 / inverse_flattening) / inverse_flattening);
       }
     };
 
-    const ellipsoid_parameters WGS84_ELLIPSOID(6378137.0, 0.00669437999014);
+    constexpr ellipsoid_parameters WGS84_ELLIPSOID(6378137.0, 0.00669437999014);
+    constexpr ellipsoid_parameters GRS80_ELLIPSOID = ellipsoid_parameters::from_flattening(6378137.0, 298.257222101);
+    constexpr ellipsoid_parameters WGS72_ELLIPSOID = ellipsoid_parameters::from_flattening(6378135.0, 298.26);
+    constexpr ellipsoid_parameters CLARKE1866_ELLIPSOID = ellipsoid_parameters::from_flattening(6378206.4, 294.978698214);
+
+    /**
+     * Datum tags for the converter<to_type, datum> specializations in
+     * converts.hpp. The ellipsoid is a template parameter there instead
+     * of a function argument, so the compiler can fold its constants
+     * into the conversion.
+     */
+
+    struct wgs84 {
+      static constexpr ellipsoid_parameters ellipsoid() { return WGS84_ELLIPSOID; }
+    };
+
+    struct grs80 {
+      static constexpr ellipsoid_parameters ellipsoid() { return GRS80_ELLIPSOID; }
+    };
+
+    struct wgs72 {
+      static constexpr ellipsoid_parameters ellipsoid() { return WGS72_ELLIPSOID; }
+    };
+
+    struct clarke1866 {
+      static constexpr ellipsoid_parameters ellipsoid() { return CLARKE1866_ELLIPSOID; }
+    };
 
   }
 }
@@ -0,0 +1,260 @@
+/**
+ * Time indexed series of tod_eci_vel samples. Samples are kept in
+ * time order in one array per component, and any time can be looked up
+ * without the caller having to find the two points around it. Lookups
+ * binary search for the bracketing samples. A cursor remembers the last
+ * segment it used, so a stream of increasing (or mostly increasing)
+ * times costs O(1) per lookup.
+ *
+ * By default interpolation between samples is the same as
+ * tod_eci_vel::interpolate. Set the interpolation to hermite to use
+ * the sample velocities as well (see tod_eci_vel_hermite_segment in
+ * interpolator.hpp), which allows much wider sample spacing for the
+ * same accuracy. Times before the first sample or after the last are
+ * extrapolated from the first or last segment.
+ *
+ * push_back throws std::invalid_argument for a sample time that isn't
+ * after the last one, and lookups throw std::out_of_range until there
+ * are at least two samples.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_EPHEMERIS
+#define _HPP_EPHEMERIS
+
+#include "interpolator.hpp"
+#include "tod_eci_vel.hpp"
+#include "xyz_point.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace fr {
+
+  namespace coordinates {
+
+    class ephemeris {
+    public:
+
+      enum interpolation { slerp, hermite };
+
+    private:
+      interpolation mode;
+      std::vector<double> times;
+      std::vector<double> x, y, z;
+      std::vector<double> dx, dy, dz;
+
+    public:
+
+      /**
+       * Remembers the segment from the last lookup. Checks that segment
+       * and the next one before falling back to a binary search. Not
+       * thread safe; give each thread its own cursor. The ephemeris must
+       * not be added to while a cursor on it is in use.
+       */
+
+      class cursor {
+	const ephemeris *eph;
+	size_t index;
+	bool valid;
+	tod_eci_vel_segment segment;
+	tod_eci_vel_hermite_segment hermite_segment;
+
+	void load(size_t new_index)
+	{
+	  index = new_index;
+	  if (eph->mode == hermite) {
+	    hermite_segment = eph->get_hermite_segment(index);
+	  } else {
+	    segment = eph->get_segment(index);
+	  }
+	  valid = true;
+	}
+
+	void interpolate(const double *at_times, tod_eci_vel_point *out, size_t count) const
+	{
+	  if (eph->mode == hermite) {
+	    hermite_segment.interpolate(at_times, out, count);
+	  } else {
+	    segment.interpolate(at_times, out, count);
+	  }
+	}
+
+      public:
+
+	explicit cursor(const ephemeris &eph) : eph(&eph), index(0), valid(false)
+	{
+	}
+
+	// Segment number for at_time, loading it if it isn't current
+	size_t seek(const double &at_time)
+	{
+	  if (valid && eph->in_segment(index, at_time)) {
+	    return index;
+	  }
+	  if (valid && index + 1 < eph->segments() && eph->in_segment(index + 1, at_time)) {
+	    load(index + 1);
+	    return index;
+	  }
+	  load(eph->find(at_time));
+	  return index;
+	}
+
+	tod_eci_vel_point operator()(const double &at_time)
+	{
+	  seek(at_time);
+	  tod_eci_vel_point retval;
+	  interpolate(&at_time, &retval, 1);
+	  return retval;
+	}
+
+	/**
+	 * Batch lookup. Runs of consecutive times that fall in the same
+	 * segment are interpolated together, so sorted times go through
+	 * the vectorized segment code.
+	 */
+
+	void operator()(const double *at_times, tod_eci_vel_point *out, size_t count)
+	{
+	  size_t start = 0;
+	  while (start < count) {
+	    seek(at_times[start]);
+	    size_t end = start + 1;
+	    while (end < count && eph->in_segment(index, at_times[end])) {
+	      ++end;
+	    }
+	    interpolate(at_times + start, out + start, end - start);
+	    start = end;
+	  }
+	}
+
+      };
+
+      ephemeris(interpolation mode = slerp) : mode(mode)
+      {
+      }
+
+      ephemeris(const double *sample_times, const tod_eci_vel_point *samples, size_t count, interpolation mode = slerp) : mode(mode)
+      {
+	reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+	  push_back(sample_times[i], samples[i]);
+	}
+      }
+
+      void reserve(size_t count)
+      {
+	times.reserve(count);
+	x.reserve(count);
+	y.reserve(count);
+	z.reserve(count);
+	dx.reserve(count);
+	dy.reserve(count);
+	dz.reserve(count);
+      }
+
+      // Samples have to be added in increasing time order
+      void push_back(const double &at_time, const tod_eci_vel_point &sample)
+      {
+	if (!std::isfinite(at_time) || !(times.empty() || at_time > times.back())) {
+	  throw std::invalid_argument("Ephemeris samples have to be added in increasing time order");
+	}
+	times.push_back(at_time);
+	x.push_back(sample.x);
+	y.push_back(sample.y);
+	z.push_back(sample.z);
+	dx.push_back(sample.dx);
+	dy.push_back(sample.dy);
+	dz.push_back(sample.dz);
+      }
+
+      void push_back(const double &at_time, const tod_eci_vel &sample)
+      {
+	push_back(at_time, tod_eci_vel_point(sample.get_x(), sample.get_y(), sample.get_z(), sample.get_dx(), sample.get_dy(), sample.get_dz()));
+      }
+
+      // Cursors made before changing this have to be discarded
+      void set_interpolation(interpolation new_mode) { mode = new_mode; }
+      interpolation get_interpolation() const { return mode; }
+
+      size_t size() const { return times.size(); }
+      bool empty() const { return times.empty(); }
+      size_t segments() const { return times.size() < 2 ? 0 : times.size() - 1; }
+
+      const double &get_time(size_t i) const { return times[i]; }
+      const double &start_time() const { return times.front(); }
+      const double &end_time() const { return times.back(); }
+
+      tod_eci_vel_point get_sample(size_t i) const
+      {
+	return tod_eci_vel_point(x[i], y[i], z[i], dx[i], dy[i], dz[i]);
+      }
+
+      // Raw arrays, for writing the samples out or converting them in batches
+      const double *get_times() const { return times.data(); }
+      const double *get_x() const { return x.data(); }
+      const double *get_y() const { return y.data(); }
+      const double *get_z() const { return z.data(); }
+      const double *get_dx() const { return dx.data(); }
+      const double *get_dy() const { return dy.data(); }
+      const double *get_dz() const { return dz.data(); }
+
+      // True if at_time is looked up in segment i. The first and last
+      // segments also take the times off their ends.
+      bool in_segment(size_t i, const double &at_time) const
+      {
+	return (i == 0 || at_time >= times[i]) && (i + 2 >= times.size() || at_time < times[i + 1]);
+      }
+
+      // Segment for at_time, by binary search. Needs at least two samples.
+      size_t find(const double &at_time) const
+      {
+	if (times.size() < 2) {
+	  throw std::out_of_range("Ephemeris lookups need at least two samples");
+	}
+	std::vector<double>::const_iterator after = std::upper_bound(times.begin() + 1, times.end() - 1, at_time);
+	return (after - times.begin()) - 1;
+      }
+
+      tod_eci_vel_segment get_segment(size_t i) const
+      {
+	return tod_eci_vel_segment(get_sample(i), times[i], get_sample(i + 1), times[i + 1]);
+      }
+
+      tod_eci_vel_hermite_segment get_hermite_segment(size_t i) const
+      {
+	return tod_eci_vel_hermite_segment(get_sample(i), times[i], get_sample(i + 1), times[i + 1]);
+      }
+
+      tod_eci_vel_point interpolate(const double &at_time) const
+      {
+	return cursor(*this)(at_time);
+      }
+
+      void interpolate(const double *at_times, tod_eci_vel_point *out, size_t count) const
+      {
+	cursor(*this)(at_times, out, count);
+      }
+
+    };
+
+  }
+
+}
+
+#endif
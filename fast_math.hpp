@@ -0,0 +1,256 @@
+/**
+ * Math policies for the batch kernels. Each policy is a type with
+ * static sin, cos, sincos, atan2, asin, acos and cbrt, plus array
+ * versions of sincos, atan2 and asin. Kernels take the policy as a
+ * template parameter (usually as a trailing argument defaulting to
+ * precise_math()), so the accuracy/speed trade is made per call site:
+ *
+ *  precise_math calls the standard library. With -O3 -ffast-math gcc
+ *  vectorizes the loops through glibc's vector math routines.
+ *
+ *  fast_math uses branch free polynomials with no library calls at all,
+ *  so loops using it vectorize at plain -O3, and sine and cosine of the
+ *  same angle share one range reduction. Measured against the standard
+ *  library over 10^6 random arguments at -O3, sin and cos are within
+ *  2.3e-16 absolute for |x| < 1e5, atan2, asin and acos within
+ *  4.5e-16 radians, including next to +-1, and cbrt within 3 ulp
+ *  over 1e-300 to 1e300. -ffast-math lets the compiler reassociate
+ *  the range reduction and fold the (1 - x)(1 + x) in asin and acos
+ *  back into 1 - x^2, which costs some of that: sin and cos stay
+ *  within 4e-16 for |x| < 10 but drift to 1e-14 at 100 and 1e-11 at
+ *  1e5, and asin and acos near +-1 are good to about 3e-14. Results
+ *  aren't bit for bit the same as the library's, so don't mix
+ *  policies in one comparison.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_FAST_MATH
+#define _HPP_FAST_MATH
+
+#include "constants.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace fr {
+
+  namespace coordinates {
+
+    struct precise_math {
+
+      template <typename T>
+      static T sin(T x) { return std::sin(x); }
+
+      template <typename T>
+      static T cos(T x) { return std::cos(x); }
+
+      // cos as a shifted sin, or gcc fuses the pair into a sincos call,
+      // which it can't vectorize
+      template <typename T>
+      static void sincos(T x, T &s, T &c)
+      {
+	s = std::sin(x);
+	c = std::sin(x + T(fr::constants::pi / 2.0));
+      }
+
+      template <typename T>
+      static T atan2(T y, T x) { return std::atan2(y, x); }
+
+      template <typename T>
+      static T asin(T x) { return std::asin(x); }
+
+      template <typename T>
+      static T acos(T x) { return std::acos(x); }
+
+      template <typename T>
+      static T cbrt(T x) { return std::cbrt(x); }
+
+      template <typename T>
+      static void sincos(const T * __restrict__ x, T * __restrict__ s, T * __restrict__ c, size_t count)
+      {
+	for (size_t i = 0; i < count; ++i) {
+	  sincos(x[i], s[i], c[i]);
+	}
+      }
+
+      template <typename T>
+      static void atan2(const T * __restrict__ y, const T * __restrict__ x, T * __restrict__ out, size_t count)
+      {
+	for (size_t i = 0; i < count; ++i) {
+	  out[i] = std::atan2(y[i], x[i]);
+	}
+      }
+
+      template <typename T>
+      static void asin(const T * __restrict__ x, T * __restrict__ out, size_t count)
+      {
+	for (size_t i = 0; i < count; ++i) {
+	  out[i] = std::asin(x[i]);
+	}
+      }
+
+    };
+
+    struct fast_math {
+
+      /**
+       * Sine and cosine together. x is reduced to r in [-pi/4, pi/4]
+       * with x = r + q pi/2, using pi/2 split in three so q pi/2 is
+       * subtracted nearly exactly, then both polynomials (the Cephes
+       * minimax coefficients) are evaluated and swapped and negated by
+       * quadrant with selects instead of branches. The quadrant count
+       * is an int, so |x| has to stay under about 3e9.
+       */
+
+      template <typename T>
+      static void sincos(T x, T &s, T &c)
+      {
+	const double two_over_pi = 0.63661977236758134308;
+	// pi/2 = pio2_1 + pio2_2 + pio2_3, the first two 33 bits each
+	const double pio2_1 = 1.57079632673412561417e+00;
+	const double pio2_2 = 6.07710050630396597660e-11;
+	const double pio2_3 = 2.02226624879595063154e-21;
+	double xd = x;
+	int q = int(xd * two_over_pi + (xd < 0 ? -0.5 : 0.5));
+	double qd = q;
+	double r = ((xd - qd * pio2_1) - qd * pio2_2) - qd * pio2_3;
+	double z = r * r;
+	double sp = r + r * z * (((((1.58962301576546568060e-10 * z - 2.50507477628578072866e-8) * z + 2.75573136213857245213e-6) * z - 1.98412698295895385996e-4) * z + 8.33333333332211858878e-3) * z - 1.66666666666666307295e-1);
+	double cp = 1.0 - 0.5 * z + z * z * (((((-1.13585365213876817300e-11 * z + 2.08757008419747316778e-9) * z - 2.75573141792967388112e-7) * z + 2.48015872888517045348e-5) * z - 1.38888888888730564116e-3) * z + 4.16666666666665929218e-2);
+	double ss = (q & 1) ? cp : sp;
+	double cc = (q & 1) ? sp : cp;
+	s = T((q & 2) ? -ss : ss);
+	c = T(((q + 1) & 2) ? -cc : cc);
+      }
+
+      template <typename T>
+      static T sin(T x)
+      {
+	T s, c;
+	sincos(x, s, c);
+	return s;
+      }
+
+      template <typename T>
+      static T cos(T x)
+      {
+	T s, c;
+	sincos(x, s, c);
+	return c;
+      }
+
+      /**
+       * atan2 by octant. The smaller of |x|, |y| over the larger gives
+       * t in [0, 1], which is folded again to |u| <= tan(pi/8) with
+       * atan(t) = pi/4 + atan((t - 1) / (t + 1)). atan(u) is the Cephes
+       * rational approximation, then the octant is undone.
+       */
+
+      template <typename T>
+      static T atan2(T y, T x)
+      {
+	const double pi = fr::constants::pi;
+	double ax = std::fabs(double(x));
+	double ay = std::fabs(double(y));
+	bool steep = ay > ax;
+	double mx = steep ? ay : ax;
+	double mn = steep ? ax : ay;
+	double t = mx > 0 ? mn / mx : 0.0;
+	bool fold = t > 0.41421356237309504880;
+	double u = fold ? (t - 1.0) / (t + 1.0) : t;
+	double z = u * u;
+	double p = ((((-8.750608600031904122785e-1 * z - 1.615753718733365076637e1) * z - 7.500855792314704667340e1) * z - 1.228866684490136173410e2) * z - 6.485021904942025371773e1);
+	double qn = (((((z + 2.485846490142306297962e1) * z + 1.650270098316988542046e2) * z + 4.328810604912902668951e2) * z + 4.853903996359136964868e2) * z + 1.945506571482613964425e2);
+	double a = u + u * z * p / qn;
+	a = fold ? pi / 4.0 + a : a;
+	a = steep ? pi / 2.0 - a : a;
+	a = x < 0 ? pi - a : a;
+	return T(std::copysign(a, double(y)));
+      }
+
+      template <typename T>
+      static T asin(T x)
+      {
+	return atan2(x, T(std::sqrt((1.0 - double(x)) * (1.0 + double(x)))));
+      }
+
+      template <typename T>
+      static T acos(T x)
+      {
+	return atan2(T(std::sqrt((1.0 - double(x)) * (1.0 + double(x)))), x);
+      }
+
+      /**
+       * Cube root. The first guess divides the exponent by three
+       * through the high word of the double, the way fdlibm does, and
+       * four Newton steps take it from about 5% to rounding error.
+       * Denormals come back wrong; nothing here produces one.
+       */
+
+      template <typename T>
+      static T cbrt(T x)
+      {
+	double ax = std::fabs(double(x));
+	uint64_t bits;
+	std::memcpy(&bits, &ax, sizeof(bits));
+	uint32_t hi = uint32_t(bits >> 32) / 3 + 715094163u;
+	bits = uint64_t(hi) << 32;
+	double y;
+	std::memcpy(&y, &bits, sizeof(y));
+	for (int i = 0; i < 4; ++i) {
+	  y = (2.0 * y + ax / (y * y)) / 3.0;
+	}
+	return T(ax == 0 ? double(x) : std::copysign(y, double(x)));
+      }
+
+      template <typename T>
+      static void sincos(const T * __restrict__ x, T * __restrict__ s, T * __restrict__ c, size_t count)
+      {
+	for (size_t i = 0; i < count; ++i) {
+	  sincos(x[i], s[i], c[i]);
+	}
+      }
+
+      template <typename T>
+      static void atan2(const T * __restrict__ y, const T * __restrict__ x, T * __restrict__ out, size_t count)
+      {
+	for (size_t i = 0; i < count; ++i) {
+	  out[i] = atan2(y[i], x[i]);
+	}
+      }
+
+      template <typename T>
+      static void asin(const T * __restrict__ x, T * __restrict__ out, size_t count)
+      {
+	for (size_t i = 0; i < count; ++i) {
+	  out[i] = asin(x[i]);
+	}
+      }
+
+    };
+
+    // Passed where a kernel takes a math policy, runs the kernel with
+    // that policy on the instruction set simd_dispatch.hpp picked for
+    // this CPU. Defined there.
+    template <typename math = precise_math>
+    struct dispatched;
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,909 @@
+/**
+ * Ellipsoidal geodesics. Solves the inverse problem (distance and
+ * azimuths between two points) and the direct problem (where you end
+ * up going a distance along an azimuth) on the ellipsoid, using
+ * Karney's algorithm (C. F. F. Karney, "Algorithms for geodesics",
+ * J. Geodesy 87, 43-55, 2013.) This is a port of the parts of
+ * GeographicLib's Geodesic and GeodesicLine classes that do that,
+ * with the same sixth order series, so it agrees with GeographicLib to
+ * a few nanometers and converges everywhere, including for nearly
+ * antipodal points where Vincenty's method fails.
+ *
+ * haversine_distance is about 0.5% off on the ellipsoid. Use this where
+ * that matters.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * The geodesic algorithms are ported from GeographicLib, which carries
+ * this notice:
+ *
+ *  Copyright (c) 2009-2013, Charles Karney <charles@karney.com>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _HPP_GEODESIC
+#define _HPP_GEODESIC
+
+#include "constants.hpp"
+#include "ellipsoid.hpp"
+#include "lat_long.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace fr {
+
+  namespace coordinates {
+
+    class geodesic {
+
+      enum { order = 6, nC3x = 15, maxit1 = 20, maxit2 = maxit1 + std::numeric_limits<double>::digits + 10 };
+
+      double a, f, f1, e2, ep2, n, b, etol2;
+      double A3x[order];
+      double C3x[nC3x];
+
+      static double tiny() { return std::sqrt(std::numeric_limits<double>::min()); }
+      static double tol0() { return std::numeric_limits<double>::epsilon(); }
+      static double tol1() { return 200 * tol0(); }
+      static double tol2() { return std::sqrt(tol0()); }
+      static double tolb() { return tol0(); }
+      static double xthresh() { return 1000 * tol2(); }
+      static double degree() { return fr::constants::pi / 180.0; }
+
+      static double sq(double x) { return x * x; }
+
+      // p[0] is the highest order coefficient
+      static double polyval(int order, const double *p, double x)
+      {
+	double y = order < 0 ? 0 : *p++;
+	while (--order >= 0) {
+	  y = y * x + *p++;
+	}
+	return y;
+      }
+
+      static void norm(double &x, double &y)
+      {
+	double r = std::hypot(x, y);
+	x /= r;
+	y /= r;
+      }
+
+      // Error free sum, t gets the rounding error
+      static double sum(double u, double v, double &t)
+      {
+	volatile double s = u + v;
+	volatile double up = s - v;
+	volatile double vpp = s - up;
+	up -= u;
+	vpp -= v;
+	t = s != 0 ? 0.0 - (up + vpp) : s;
+	return s;
+      }
+
+      // Rounds small angles so they underflow to zero rather than to a
+      // denormal
+      static double ang_round(double x)
+      {
+	const double z = 1.0 / 16.0;
+	double y = std::fabs(x);
+	double w = z - y;
+	y = w > 0 ? z - w : y;
+	return std::copysign(y, x);
+      }
+
+      static double ang_normalize(double x)
+      {
+	double y = std::remainder(x, 360.0);
+	return std::fabs(y) == 180 ? std::copysign(180.0, x) : y;
+      }
+
+      static double lat_fix(double x)
+      {
+	return std::fabs(x) > 90 ? std::numeric_limits<double>::quiet_NaN() : x;
+      }
+
+      // y - x reduced to [-180, 180], with the rounding error in e
+      static double ang_diff(double x, double y, double &e)
+      {
+	double d = sum(std::remainder(-x, 360.0), std::remainder(y, 360.0), e);
+	d = sum(std::remainder(d, 360.0), e, e);
+	if (d == 0 || std::fabs(d) == 180) {
+	  d = std::copysign(d, e == 0 ? y - x : -e);
+	}
+	return d;
+      }
+
+      // Sine and cosine of an angle in degrees, exact for multiples of
+      // 90 degrees
+      static void sincosd(double x, double &sinx, double &cosx)
+      {
+	double r = std::fmod(x, 360.0);
+	int q = std::isnan(r) ? 0 : int(std::round(r / 90));
+	r -= 90 * q;
+	r *= degree();
+	double s = std::sin(r), c = std::cos(r);
+	switch (q & 3) {
+	case 0: sinx = s; cosx = c; break;
+	case 1: sinx = c; cosx = -s; break;
+	case 2: sinx = -s; cosx = -c; break;
+	default: sinx = -c; cosx = s; break;
+	}
+	cosx += 0.0;
+	if (sinx == 0) {
+	  sinx = std::copysign(sinx, x);
+	}
+      }
+
+      // Same for x + t, where t is a small correction to x
+      static void sincosde(double x, double t, double &sinx, double &cosx)
+      {
+	int q = int(std::round(x / 90));
+	double r = x - 90 * q;
+	r = ang_round(r + t) * degree();
+	double s = std::sin(r), c = std::cos(r);
+	switch (q & 3) {
+	case 0: sinx = s; cosx = c; break;
+	case 1: sinx = c; cosx = -s; break;
+	case 2: sinx = -s; cosx = -c; break;
+	default: sinx = -c; cosx = s; break;
+	}
+	cosx += 0.0;
+	if (sinx == 0) {
+	  sinx = std::copysign(sinx, x);
+	}
+      }
+
+      static double atan2d(double y, double x)
+      {
+	int q = 0;
+	if (std::fabs(y) > std::fabs(x)) {
+	  std::swap(x, y);
+	  q = 2;
+	}
+	if (std::signbit(x)) {
+	  x = -x;
+	  ++q;
+	}
+	double ang = std::atan2(y, x) / degree();
+	switch (q) {
+	case 1: ang = std::copysign(180.0, y) - ang; break;
+	case 2: ang = 90 - ang; break;
+	case 3: ang = -90 + ang; break;
+	default: break;
+	}
+	return ang;
+      }
+
+      // Clenshaw summation of sum(c[i] * sin(2 i x), i = 1..n) if sinp,
+      // else sum(c[i] * cos((2 i + 1) x), i = 0..n-1)
+      static double sin_cos_series(bool sinp, double sinx, double cosx, const double *c, int n)
+      {
+	c += (n + sinp);
+	double ar = 2 * (cosx - sinx) * (cosx + sinx);
+	double y0 = (n & 1) ? *--c : 0, y1 = 0;
+	n /= 2;
+	while (n--) {
+	  y1 = ar * y0 - y1 + *--c;
+	  y0 = ar * y1 - y0 + *--c;
+	}
+	return sinp ? 2 * sinx * cosx * y0 : cosx * (y0 - y1);
+      }
+
+      static double astroid(double x, double y)
+      {
+	double k;
+	double p = sq(x), q = sq(y), r = (p + q - 1) / 6;
+	if (!(q == 0 && r <= 0)) {
+	  double S = p * q / 4;
+	  double r2 = sq(r), r3 = r * r2;
+	  double disc = S * (S + 2 * r3);
+	  double u = r;
+	  if (disc >= 0) {
+	    double T3 = S + r3;
+	    T3 += T3 < 0 ? -std::sqrt(disc) : std::sqrt(disc);
+	    double T = std::cbrt(T3);
+	    u += T + (T != 0 ? r2 / T : 0);
+	  } else {
+	    double ang = std::atan2(std::sqrt(-disc), -(S + r3));
+	    u += 2 * r * std::cos(ang / 3);
+	  }
+	  double v = std::sqrt(sq(u) + q);
+	  double uv = u < 0 ? q / (v - u) : u + v;
+	  double w = (uv - q) / (2 * v);
+	  k = uv / (std::sqrt(uv + sq(w)) + w);
+	} else {
+	  k = 0;
+	}
+	return k;
+      }
+
+      /*
+       * Series coefficients, as polynomials in eps or eps^2 with
+       * integer coefficients over a common denominator
+       */
+
+      static double A1m1f(double eps)
+      {
+	static const double coeff[] = { 1, 4, 64, 0, 256 };
+	int m = order / 2;
+	double t = polyval(m, coeff, sq(eps)) / coeff[m + 1];
+	return (t + eps) / (1 - eps);
+      }
+
+      static void C1f(double eps, double c[])
+      {
+	static const double coeff[] = {
+	  -1, 6, -16, 32,
+	  -9, 64, -128, 2048,
+	  9, -16, 768,
+	  3, -5, 512,
+	  -7, 1280,
+	  -7, 2048,
+	};
+	double eps2 = sq(eps), d = eps;
+	int o = 0;
+	for (int l = 1; l <= order; ++l) {
+	  int m = (order - l) / 2;
+	  c[l] = d * polyval(m, coeff + o, eps2) / coeff[o + m + 1];
+	  o += m + 2;
+	  d *= eps;
+	}
+      }
+
+      static void C1pf(double eps, double c[])
+      {
+	static const double coeff[] = {
+	  205, -432, 768, 1536,
+	  4005, -4736, 3840, 12288,
+	  -225, 116, 384,
+	  -7173, 2695, 7680,
+	  3467, 7680,
+	  38081, 61440,
+	};
+	double eps2 = sq(eps), d = eps;
+	int o = 0;
+	for (int l = 1; l <= order; ++l) {
+	  int m = (order - l) / 2;
+	  c[l] = d * polyval(m, coeff + o, eps2) / coeff[o + m + 1];
+	  o += m + 2;
+	  d *= eps;
+	}
+      }
+
+      static double A2m1f(double eps)
+      {
+	static const double coeff[] = { -11, -28, -192, 0, 256 };
+	int m = order / 2;
+	double t = polyval(m, coeff, sq(eps)) / coeff[m + 1];
+	return (t - eps) / (1 + eps);
+      }
+
+      static void C2f(double eps, double c[])
+      {
+	static const double coeff[] = {
+	  1, 2, 16, 32,
+	  35, 64, 384, 2048,
+	  15, 80, 768,
+	  7, 35, 512,
+	  63, 1280,
+	  77, 2048,
+	};
+	double eps2 = sq(eps), d = eps;
+	int o = 0;
+	for (int l = 1; l <= order; ++l) {
+	  int m = (order - l) / 2;
+	  c[l] = d * polyval(m, coeff + o, eps2) / coeff[o + m + 1];
+	  o += m + 2;
+	  d *= eps;
+	}
+      }
+
+      // A3 and C3 depend on the ellipsoid as well as eps, so their
+      // coefficients in n are worked out once in the constructor
+
+      void A3coeff()
+      {
+	static const double coeff[] = {
+	  -3, 128,
+	  -2, -3, 64,
+	  -1, -3, -1, 16,
+	  3, -1, -2, 8,
+	  1, -1, 2,
+	  1, 1,
+	};
+	int o = 0, k = 0;
+	for (int j = order - 1; j >= 0; --j) {
+	  int m = std::min(order - j - 1, j);
+	  A3x[k++] = polyval(m, coeff + o, n) / coeff[o + m + 1];
+	  o += m + 2;
+	}
+      }
+
+      void C3coeff()
+      {
+	static const double coeff[] = {
+	  3, 128,
+	  2, 5, 128,
+	  -1, 3, 3, 64,
+	  -1, 0, 1, 8,
+	  -1, 1, 4,
+	  5, 256,
+	  1, 3, 128,
+	  -3, -2, 3, 64,
+	  1, -3, 2, 32,
+	  7, 512,
+	  -10, 9, 384,
+	  5, -9, 5, 192,
+	  7, 512,
+	  -14, 7, 512,
+	  21, 2560,
+	};
+	int o = 0, k = 0;
+	for (int l = 1; l < order; ++l) {
+	  for (int j = order - 1; j >= l; --j) {
+	    int m = std::min(order - j - 1, j);
+	    C3x[k++] = polyval(m, coeff + o, n) / coeff[o + m + 1];
+	    o += m + 2;
+	  }
+	}
+      }
+
+      double A3f(double eps) const
+      {
+	return polyval(order - 1, A3x, eps);
+      }
+
+      void C3f(double eps, double c[]) const
+      {
+	double mult = 1;
+	int o = 0;
+	for (int l = 1; l < order; ++l) {
+	  int m = order - l - 1;
+	  mult *= eps;
+	  c[l] = mult * polyval(m, C3x + o, eps);
+	  o += m + 1;
+	}
+      }
+
+      // Distance (s12b) and reduced length (m12b) along a geodesic, in
+      // units of b
+      void lengths(double eps, double sig12, double ssig1, double csig1, double dn1, double ssig2, double csig2, double dn2, bool distance, bool reduced, double &s12b, double &m12b, double &m0, double C1a[], double C2a[]) const
+      {
+	double A1 = A1m1f(eps), A2 = 0, m0x = 0, J12 = 0;
+	C1f(eps, C1a);
+	if (reduced) {
+	  A2 = A2m1f(eps);
+	  C2f(eps, C2a);
+	  m0x = A1 - A2;
+	  A2 = 1 + A2;
+	}
+	A1 = 1 + A1;
+	if (distance) {
+	  double B1 = sin_cos_series(true, ssig2, csig2, C1a, order) - sin_cos_series(true, ssig1, csig1, C1a, order);
+	  s12b = A1 * (sig12 + B1);
+	  if (reduced) {
+	    double B2 = sin_cos_series(true, ssig2, csig2, C2a, order) - sin_cos_series(true, ssig1, csig1, C2a, order);
+	    J12 = m0x * sig12 + (A1 * B1 - A2 * B2);
+	  }
+	} else if (reduced) {
+	  for (int l = 1; l <= order; ++l) {
+	    C2a[l] = A1 * C1a[l] - A2 * C2a[l];
+	  }
+	  J12 = m0x * sig12 + (sin_cos_series(true, ssig2, csig2, C2a, order) - sin_cos_series(true, ssig1, csig1, C2a, order));
+	}
+	if (reduced) {
+	  m0 = m0x;
+	  m12b = dn2 * (csig1 * ssig2) - dn1 * (ssig1 * csig2) - csig1 * csig2 * J12;
+	}
+      }
+
+      // Starting guess for alp1 for Newton's method. Returns sig12 >= 0
+      // if it solved the problem outright for short lines, with dnm set.
+      double inverse_start(double sbet1, double cbet1, double dn1, double sbet2, double cbet2, double dn2, double lam12, double slam12, double clam12, double &salp1, double &calp1, double &salp2, double &calp2, double &dnm, double C1a[], double C2a[]) const
+      {
+	double sig12 = -1;
+	double sbet12 = sbet2 * cbet1 - cbet2 * sbet1;
+	double cbet12 = cbet2 * cbet1 + sbet2 * sbet1;
+	double sbet12a = sbet2 * cbet1 + cbet2 * sbet1;
+	bool shortline = cbet12 >= 0 && sbet12 < 0.5 && cbet2 * lam12 < 0.5;
+	double somg12, comg12;
+	if (shortline) {
+	  double sbetm2 = sq(sbet1 + sbet2);
+	  sbetm2 /= sbetm2 + sq(cbet1 + cbet2);
+	  dnm = std::sqrt(1 + ep2 * sbetm2);
+	  double omg12 = lam12 / (f1 * dnm);
+	  somg12 = std::sin(omg12);
+	  comg12 = std::cos(omg12);
+	} else {
+	  somg12 = slam12;
+	  comg12 = clam12;
+	}
+	salp1 = cbet2 * somg12;
+	calp1 = comg12 >= 0 ? sbet12 + cbet2 * sbet1 * sq(somg12) / (1 + comg12) : sbet12a - cbet2 * sbet1 * sq(somg12) / (1 - comg12);
+	double ssig12 = std::hypot(salp1, calp1);
+	double csig12 = sbet1 * sbet2 + cbet1 * cbet2 * comg12;
+	if (shortline && ssig12 < etol2) {
+	  // Really short lines
+	  salp2 = cbet1 * somg12;
+	  calp2 = sbet12 - cbet1 * sbet2 * (comg12 >= 0 ? sq(somg12) / (1 + comg12) : 1 - comg12);
+	  norm(salp2, calp2);
+	  sig12 = std::atan2(ssig12, csig12);
+	} else if (std::fabs(n) > 0.1 || csig12 >= 0 || ssig12 >= 6 * std::fabs(n) * fr::constants::pi * sq(cbet1)) {
+	  // Nothing to do, the zeroth order spherical approximation is OK
+	} else {
+	  // Nearly antipodal, scale to the astroid problem
+	  double x, y, lamscale, betscale;
+	  double lam12x = std::atan2(-slam12, -clam12);
+	  if (f >= 0) {
+	    double k2 = sq(sbet1) * ep2;
+	    double eps = k2 / (2 * (1 + std::sqrt(1 + k2)) + k2);
+	    lamscale = f * cbet1 * A3f(eps) * fr::constants::pi;
+	    betscale = lamscale * cbet1;
+	    x = lam12x / lamscale;
+	    y = sbet12a / betscale;
+	  } else {
+	    double cbet12a = cbet2 * cbet1 - sbet2 * sbet1;
+	    double bet12a = std::atan2(sbet12a, cbet12a);
+	    double m12b, m0, dummy;
+	    lengths(n, fr::constants::pi + bet12a, sbet1, -cbet1, dn1, sbet2, cbet2, dn2, false, true, dummy, m12b, m0, C1a, C2a);
+	    x = -1 + m12b / (cbet1 * cbet2 * m0 * fr::constants::pi);
+	    betscale = x < -0.01 ? sbet12a / x : -f * sq(cbet1) * fr::constants::pi;
+	    lamscale = betscale / cbet1;
+	    y = lam12x / lamscale;
+	  }
+	  if (y > -tol1() && x > -1 - xthresh()) {
+	    if (f >= 0) {
+	      salp1 = std::min(1.0, -x);
+	      calp1 = -std::sqrt(1 - sq(salp1));
+	    } else {
+	      calp1 = std::max(x > -tol1() ? 0.0 : -1.0, x);
+	      salp1 = std::sqrt(1 - sq(calp1));
+	    }
+	  } else {
+	    double k = astroid(x, y);
+	    double omg12a = lamscale * (f >= 0 ? -x * k / (1 + k) : -y * (1 + k) / k);
+	    somg12 = std::sin(omg12a);
+	    comg12 = -std::cos(omg12a);
+	    salp1 = cbet2 * somg12;
+	    calp1 = sbet12a - cbet2 * sbet1 * sq(somg12) / (1 - comg12);
+	  }
+	}
+	if (!(salp1 <= 0)) {
+	  norm(salp1, calp1);
+	} else {
+	  salp1 = 1;
+	  calp1 = 0;
+	}
+	return sig12;
+      }
+
+      // Longitude difference for a given alp1, and its derivative
+      double lambda12(double sbet1, double cbet1, double dn1, double sbet2, double cbet2, double dn2, double salp1, double calp1, double slam120, double clam120, bool diffp, double &salp2, double &calp2, double &sig12, double &ssig1, double &csig1, double &ssig2, double &csig2, double &eps, double &dlam12, double C1a[], double C2a[], double C3a[]) const
+      {
+	if (sbet1 == 0 && calp1 == 0) {
+	  calp1 = -tiny();
+	}
+	double salp0 = salp1 * cbet1;
+	double calp0 = std::hypot(calp1, salp1 * sbet1);
+	double somg1, comg1, somg2, comg2;
+	ssig1 = sbet1;
+	somg1 = salp0 * sbet1;
+	csig1 = comg1 = calp1 * cbet1;
+	norm(ssig1, csig1);
+	salp2 = cbet2 != cbet1 ? salp0 / cbet2 : salp1;
+	calp2 = cbet2 != cbet1 || std::fabs(sbet2) != -sbet1 ?
+	  std::sqrt(sq(calp1 * cbet1) + (cbet1 < -sbet1 ? (cbet2 - cbet1) * (cbet1 + cbet2) : (sbet1 - sbet2) * (sbet1 + sbet2))) / cbet2 :
+	  std::fabs(calp1);
+	ssig2 = sbet2;
+	somg2 = salp0 * sbet2;
+	csig2 = comg2 = calp2 * cbet2;
+	norm(ssig2, csig2);
+	sig12 = std::atan2(std::max(0.0, csig1 * ssig2 - ssig1 * csig2) + 0.0, csig1 * csig2 + ssig1 * ssig2);
+	double somg12 = std::max(0.0, comg1 * somg2 - somg1 * comg2) + 0.0;
+	double comg12 = comg1 * comg2 + somg1 * somg2;
+	double eta = std::atan2(somg12 * clam120 - comg12 * slam120, comg12 * clam120 + somg12 * slam120);
+	double k2 = sq(calp0) * ep2;
+	eps = k2 / (2 * (1 + std::sqrt(1 + k2)) + k2);
+	C3f(eps, C3a);
+	double B312 = sin_cos_series(true, ssig2, csig2, C3a, order - 1) - sin_cos_series(true, ssig1, csig1, C3a, order - 1);
+	double lam12 = eta - f * A3f(eps) * salp0 * (sig12 + B312);
+	if (diffp) {
+	  if (calp2 == 0) {
+	    dlam12 = -2 * f1 * dn1 / sbet1;
+	  } else {
+	    double dummy;
+	    lengths(eps, sig12, ssig1, csig1, dn1, ssig2, csig2, dn2, false, true, dummy, dlam12, dummy, C1a, C2a);
+	    dlam12 *= f1 / (calp2 * cbet2);
+	  }
+	}
+	return lam12;
+      }
+
+      /*
+       * The inverse problem. Returns the distance in meters and leaves
+       * the sines and cosines of the azimuths at each end in the
+       * s/c alp arguments.
+       */
+
+      double gen_inverse(double lat1, double lon1, double lat2, double lon2, double &salp1, double &calp1, double &salp2, double &calp2) const
+      {
+	double C1a[order + 1], C2a[order + 1], C3a[order];
+	double lon12s;
+	double lon12 = ang_diff(lon1, lon2, lon12s);
+	// Make longitude difference positive
+	int lonsign = std::signbit(lon12) ? -1 : 1;
+	lon12 *= lonsign;
+	lon12s *= lonsign;
+	double lam12 = lon12 * degree(), slam12, clam12;
+	sincosde(lon12, lon12s, slam12, clam12);
+	// The supplementary longitude difference
+	lon12s = (180 - lon12) - lon12s;
+
+	// Swap points so |bet1| >= |bet2|, then make lat1 <= -0
+	lat1 = ang_round(lat_fix(lat1));
+	lat2 = ang_round(lat_fix(lat2));
+	int swapp = std::fabs(lat1) < std::fabs(lat2) || std::isnan(lat2) ? -1 : 1;
+	if (swapp < 0) {
+	  lonsign *= -1;
+	  std::swap(lat1, lat2);
+	}
+	int latsign = std::signbit(lat1) ? 1 : -1;
+	lat1 *= latsign;
+	lat2 *= latsign;
+
+	// Reduced latitudes
+	double sbet1, cbet1, sbet2, cbet2;
+	sincosd(lat1, sbet1, cbet1);
+	sbet1 *= f1;
+	norm(sbet1, cbet1);
+	cbet1 = std::max(tiny(), cbet1);
+	sincosd(lat2, sbet2, cbet2);
+	sbet2 *= f1;
+	norm(sbet2, cbet2);
+	cbet2 = std::max(tiny(), cbet2);
+	if (cbet1 < -sbet1) {
+	  if (cbet2 == cbet1) {
+	    sbet2 = std::copysign(sbet1, sbet2);
+	  }
+	} else {
+	  if (std::fabs(sbet2) == -sbet1) {
+	    cbet2 = cbet1;
+	  }
+	}
+	double dn1 = std::sqrt(1 + ep2 * sq(sbet1));
+	double dn2 = std::sqrt(1 + ep2 * sq(sbet2));
+
+	double sig12, s12x = 0, m12x = 0, dummy;
+	bool meridian = lat1 == -90 || slam12 == 0;
+	if (meridian) {
+	  // Endpoints on a meridian, or one of them at a pole
+	  calp1 = clam12;
+	  salp1 = slam12;
+	  calp2 = 1;
+	  salp2 = 0;
+	  double ssig1 = sbet1, csig1 = calp1 * cbet1;
+	  double ssig2 = sbet2, csig2 = calp2 * cbet2;
+	  sig12 = std::atan2(std::max(0.0, csig1 * ssig2 - ssig1 * csig2) + 0.0, csig1 * csig2 + ssig1 * ssig2);
+	  lengths(n, sig12, ssig1, csig1, dn1, ssig2, csig2, dn2, true, true, s12x, m12x, dummy, C1a, C2a);
+	  // A meridian is only the shortest path if it doesn't pass a
+	  // conjugate point, m12 >= 0
+	  if (sig12 < tol2() || m12x >= 0) {
+	    if (sig12 < 3 * tiny() || (sig12 < tol0() && (s12x < 0 || m12x < 0))) {
+	      s12x = 0;
+	    }
+	    s12x *= b;
+	  } else {
+	    meridian = false;
+	  }
+	}
+
+	if (!meridian && sbet1 == 0 && (f <= 0 || lon12s >= f * 180)) {
+	  // Along the equator
+	  calp1 = calp2 = 0;
+	  salp1 = salp2 = 1;
+	  s12x = a * lam12;
+	} else if (!meridian) {
+	  double dnm = 1;
+	  sig12 = inverse_start(sbet1, cbet1, dn1, sbet2, cbet2, dn2, lam12, slam12, clam12, salp1, calp1, salp2, calp2, dnm, C1a, C2a);
+	  if (sig12 >= 0) {
+	    // Short line, solved by inverse_start
+	    s12x = sig12 * b * dnm;
+	  } else {
+	    // Newton's method, falling back to bisection on alp1 if it
+	    // strays out of the bracket
+	    double ssig1 = 0, csig1 = 0, ssig2 = 0, csig2 = 0, eps = 0;
+	    unsigned numit = 0;
+	    double salp1a = tiny(), calp1a = 1, salp1b = tiny(), calp1b = -1;
+	    for (bool tripn = false, tripb = false; ; ++numit) {
+	      double dv = 0;
+	      double v = lambda12(sbet1, cbet1, dn1, sbet2, cbet2, dn2, salp1, calp1, slam12, clam12, numit < maxit1, salp2, calp2, sig12, ssig1, csig1, ssig2, csig2, eps, dv, C1a, C2a, C3a);
+	      if (tripb || !(std::fabs(v) >= (tripn ? 8 : 1) * tol0()) || numit == maxit2) {
+		break;
+	      }
+	      if (v > 0 && (numit > maxit1 || calp1 / salp1 > calp1b / salp1b)) {
+		salp1b = salp1;
+		calp1b = calp1;
+	      } else if (v < 0 && (numit > maxit1 || calp1 / salp1 < calp1a / salp1a)) {
+		salp1a = salp1;
+		calp1a = calp1;
+	      }
+	      if (numit < maxit1 && dv > 0) {
+		double dalp1 = -v / dv;
+		if (std::fabs(dalp1) < fr::constants::pi) {
+		  double sdalp1 = std::sin(dalp1), cdalp1 = std::cos(dalp1);
+		  double nsalp1 = salp1 * cdalp1 + calp1 * sdalp1;
+		  if (nsalp1 > 0) {
+		    calp1 = calp1 * cdalp1 - salp1 * sdalp1;
+		    salp1 = nsalp1;
+		    norm(salp1, calp1);
+		    tripn = std::fabs(v) <= 16 * tol0();
+		    continue;
+		  }
+		}
+	      }
+	      salp1 = (salp1a + salp1b) / 2;
+	      calp1 = (calp1a + calp1b) / 2;
+	      norm(salp1, calp1);
+	      tripn = false;
+	      tripb = (std::fabs(salp1a - salp1) + (calp1a - calp1) < tolb() || std::fabs(salp1 - salp1b) + (calp1 - calp1b) < tolb());
+	    }
+	    lengths(eps, sig12, ssig1, csig1, dn1, ssig2, csig2, dn2, true, false, s12x, dummy, dummy, C1a, C2a);
+	    s12x *= b;
+	  }
+	}
+
+	if (swapp < 0) {
+	  std::swap(salp1, salp2);
+	  std::swap(calp1, calp2);
+	}
+	salp1 *= swapp * lonsign;
+	calp1 *= swapp * latsign;
+	salp2 *= swapp * lonsign;
+	calp2 *= swapp * latsign;
+	return 0.0 + s12x;
+      }
+
+    public:
+
+      /**
+       * Points along one geodesic, given by a starting point and
+       * azimuth. Works out everything that only depends on the start
+       * once, so each position costs a few series evaluations. The
+       * batch direct calls use one of these.
+       */
+
+      class line {
+	double f, f1, b;
+	double lon1;
+	double salp0, calp0, k2;
+	double ssig1, csig1, somg1, comg1;
+	double stau1, ctau1;
+	double A1m1, B11, A3c, B31;
+	double C1a[order + 1], C1pa[order + 1], C3a[order];
+
+      public:
+	line(const geodesic &g, const lat_long &from, double azi1) : f(g.f), f1(g.f1), b(g.b), lon1(from.get_long())
+	{
+	  double salp1, calp1, sbet1, cbet1;
+	  sincosd(ang_round(azi1), salp1, calp1);
+	  sincosd(ang_round(lat_fix(from.get_lat())), sbet1, cbet1);
+	  sbet1 *= f1;
+	  norm(sbet1, cbet1);
+	  cbet1 = std::max(tiny(), cbet1);
+	  salp0 = salp1 * cbet1;
+	  calp0 = std::hypot(calp1, salp1 * sbet1);
+	  ssig1 = sbet1;
+	  somg1 = salp0 * sbet1;
+	  csig1 = comg1 = sbet1 != 0 || calp1 != 0 ? cbet1 * calp1 : 1;
+	  norm(ssig1, csig1);
+	  k2 = sq(calp0) * g.ep2;
+	  double eps = k2 / (2 * (1 + std::sqrt(1 + k2)) + k2);
+	  A1m1 = A1m1f(eps);
+	  C1f(eps, C1a);
+	  B11 = sin_cos_series(true, ssig1, csig1, C1a, order);
+	  double s = std::sin(B11), c = std::cos(B11);
+	  stau1 = ssig1 * c + csig1 * s;
+	  ctau1 = csig1 * c - ssig1 * s;
+	  C1pf(eps, C1pa);
+	  g.C3f(eps, C3a);
+	  A3c = -f * salp0 * g.A3f(eps);
+	  B31 = sin_cos_series(true, ssig1, csig1, C3a, order - 1);
+	}
+
+	// Position s12 meters along the line, with longitude in
+	// [-180, 180] and the forward azimuth there
+	void position(double s12, double &lat2, double &lon2, double &azi2) const
+	{
+	  double tau12 = s12 / (b * (1 + A1m1));
+	  double s = std::sin(tau12), c = std::cos(tau12);
+	  double B12 = -sin_cos_series(true, stau1 * c + ctau1 * s, ctau1 * c - stau1 * s, C1pa, order);
+	  double sig12 = tau12 - (B12 - B11);
+	  double ssig12 = std::sin(sig12), csig12 = std::cos(sig12);
+	  if (std::fabs(f) > 0.01) {
+	    // Very flattened ellipsoids need a Newton step on sig12
+	    double ssig2 = ssig1 * csig12 + csig1 * ssig12;
+	    double csig2 = csig1 * csig12 - ssig1 * ssig12;
+	    B12 = sin_cos_series(true, ssig2, csig2, C1a, order);
+	    double serr = (1 + A1m1) * (sig12 + (B12 - B11)) - s12 / b;
+	    sig12 = sig12 - serr / std::sqrt(1 + k2 * sq(ssig2));
+	    ssig12 = std::sin(sig12);
+	    csig12 = std::cos(sig12);
+	  }
+	  double ssig2 = ssig1 * csig12 + csig1 * ssig12;
+	  double csig2 = csig1 * csig12 - ssig1 * ssig12;
+	  double sbet2 = calp0 * ssig2;
+	  double cbet2 = std::hypot(salp0, calp0 * csig2);
+	  if (cbet2 == 0) {
+	    cbet2 = csig2 = tiny();
+	  }
+	  double somg2 = salp0 * ssig2, comg2 = csig2;
+	  double omg12 = std::atan2(somg2 * comg1 - comg2 * somg1, comg2 * comg1 + somg2 * somg1);
+	  double lam12 = omg12 + A3c * (sig12 + (sin_cos_series(true, ssig2, csig2, C3a, order - 1) - B31));
+	  lon2 = ang_normalize(ang_normalize(lon1) + ang_normalize(lam12 / degree()));
+	  lat2 = atan2d(sbet2, f1 * cbet2);
+	  azi2 = atan2d(salp0, calp0 * csig2);
+	}
+
+      };
+
+      geodesic(const ellipsoid_parameters &e = WGS84_ELLIPSOID) : a(e.ae), f(e.f), f1(1 - e.f), e2(e.f * (2 - e.f)), ep2(e2 / sq(f1)), n(e.f / (2 - e.f)), b(e.ae * (1 - e.f))
+      {
+	etol2 = 0.1 * tol2() / std::sqrt(std::max(0.001, std::fabs(f)) * std::min(1.0, 1 - f / 2) / 2);
+	A3coeff();
+	C3coeff();
+      }
+
+      // Distance in meters between two points along the ellipsoid,
+      // ignoring altitude
+      double distance(const lat_long &p1, const lat_long &p2) const
+      {
+	if (p1.get_lat() == p2.get_lat() && p1.get_long() == p2.get_long()) {
+	  return 0.0;
+	}
+	double salp1, calp1, salp2, calp2;
+	return gen_inverse(p1.get_lat(), p1.get_long(), p2.get_lat(), p2.get_long(), salp1, calp1, salp2, calp2);
+      }
+
+      /**
+       * The inverse problem. Gives the distance in meters and the
+       * azimuths (degrees clockwise from north) of the geodesic at
+       * each end. azi2 is the direction you're heading as you arrive,
+       * not the bearing back to p1.
+       */
+
+      void inverse(const lat_long &p1, const lat_long &p2, double &s12, double &azi1, double &azi2) const
+      {
+	double salp1, calp1, salp2, calp2;
+	s12 = gen_inverse(p1.get_lat(), p1.get_long(), p2.get_lat(), p2.get_long(), salp1, calp1, salp2, calp2);
+	azi1 = atan2d(salp1, calp1);
+	azi2 = atan2d(salp2, calp2);
+      }
+
+      /**
+       * The direct problem. Where you end up going s12 meters from
+       * p1 along azimuth azi1. The result has p1's altitude.
+       */
+
+      lat_long direct(const lat_long &p1, double azi1, double s12, double &azi2) const
+      {
+	double lat2, lon2;
+	line(*this, p1, azi1).position(s12, lat2, lon2, azi2);
+	return lat_long(lat2, lon2, p1.get_alt());
+      }
+
+      lat_long direct(const lat_long &p1, double azi1, double s12) const
+      {
+	double azi2;
+	return direct(p1, azi1, s12, azi2);
+      }
+
+      /**
+       * One to many, like haversine_distance::distances. Points that
+       * coincide with from come back as 0 without solving anything.
+       */
+
+      void distances(const lat_long &from, const double *lat, const double *lon, double *out, size_t count) const
+      {
+	const double lat1 = from.get_lat();
+	const double lon1 = from.get_long();
+	double salp1, calp1, salp2, calp2;
+	for (size_t i = 0; i < count; ++i) {
+	  if (lat[i] == lat1 && lon[i] == lon1) {
+	    out[i] = 0.0;
+	  } else {
+	    out[i] = gen_inverse(lat1, lon1, lat[i], lon[i], salp1, calp1, salp2, calp2);
+	  }
+	}
+      }
+
+      // Many to many, laid out like haversine_distance::distances
+      void distances(const double *lat1, const double *lon1, size_t n1, const double *lat2, const double *lon2, size_t n2, double *out) const
+      {
+	for (size_t i = 0; i < n1; ++i) {
+	  distances(lat_long(lat1[i], lon1[i]), lat2, lon2, out + i * n2, n2);
+	}
+      }
+
+      /**
+       * Pairwise inverse over arrays, point i of the first set to point
+       * i of the second. Pass null for azi1 or azi2 if you don't need
+       * them.
+       */
+
+      void inverse(const double *lat1, const double *lon1, const double *lat2, const double *lon2, double *s12, double *azi1, double *azi2, size_t count) const
+      {
+	double salp1, calp1, salp2, calp2;
+	for (size_t i = 0; i < count; ++i) {
+	  s12[i] = gen_inverse(lat1[i], lon1[i], lat2[i], lon2[i], salp1, calp1, salp2, calp2);
+	  if (azi1) {
+	    azi1[i] = atan2d(salp1, calp1);
+	  }
+	  if (azi2) {
+	    azi2[i] = atan2d(salp2, calp2);
+	  }
+	}
+      }
+
+      /**
+       * Positions at count distances along one geodesic from from,
+       * leaving along azimuth azi1. azi2 can be null.
+       */
+
+      void direct(const lat_long &from, double azi1, const double *s12, double *lat, double *lon, double *azi2, size_t count) const
+      {
+	line path(*this, from, azi1);
+	double a2;
+	for (size_t i = 0; i < count; ++i) {
+	  path.position(s12[i], lat[i], lon[i], azi2 ? azi2[i] : a2);
+	}
+      }
+
+      // Pairwise direct over arrays
+      void direct(const double *lat1, const double *lon1, const double *azi1, const double *s12, double *lat2, double *lon2, double *azi2, size_t count) const
+      {
+	double a2;
+	for (size_t i = 0; i < count; ++i) {
+	  line(*this, lat_long(lat1[i], lon1[i]), azi1[i]).position(s12[i], lat2[i], lon2[i], azi2 ? azi2[i] : a2);
+	}
+      }
+
+    };
+
+  }
+
+}
+
+#endif
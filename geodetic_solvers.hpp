@@ -0,0 +1,227 @@
+/**
+ * ECEF to geodetic latitude/longitude/altitude solvers. Each solver
+ * is a small object with an operator() that takes x, y, z in meters
+ * and writes latitude and longitude in degrees and altitude in meters.
+ * Pass one to converter<lat_long> or batch_converter<lat_long> to pick
+ * the algorithm:
+ *
+ *  iterative_solver   - The original open ended fixed point loop. The
+ *                       number of passes varies from point to point.
+ *  bowring_solver<n>  - Bowring's method with a fixed number of
+ *                       iterations (one by default.) Only sqrt and
+ *                       atan2, no data dependent branches.
+ *  vermeille_solver   - Vermeille's closed form solution. Exact to
+ *                       rounding error, uses sqrt, cbrt and atan2.
+ *
+ * Worst case errors measured on WGS84 by converting 10^6 random
+ * lat_longs to ecef and back (so the error in the first conversion
+ * is included, it's around 1e-14 degrees and a few nanometers):
+ *
+ *  altitude band      iterative   bowring<1>  bowring<2>  vermeille
+ *  -50km..-10km  lat  2e-10 deg   2e-10 deg   3e-14 deg   3e-14 deg
+ *  -10km..10km   lat  2e-9 deg    8e-12 deg   3e-14 deg   3e-14 deg
+ *  10km..1000km  lat  4e-9 deg    5e-8 deg    3e-14 deg   3e-14 deg
+ *  1000km..40Mm  lat  3e-9 deg    5e-7 deg    3e-14 deg   3e-14 deg
+ *
+ * Altitude errors were under 3e-8 meters for every solver in every
+ * band. 1e-9 degrees of latitude is about 0.1mm on the ground, so for
+ * anything near the surface of the earth a single Bowring step is
+ * already better than the default iterative loop, and two steps or
+ * Vermeille are good to rounding error everywhere.
+ *
+ * Vermeille's method is not valid within about 43km of the center of
+ * the earth (where its cube root argument goes negative.) Nothing
+ * on or above the surface of the earth gets anywhere near that.
+ *
+ * geodetic_to_ecef goes the other way. Every lat/long to ECEF
+ * conversion in the library is done with it.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_GEODETIC_SOLVERS
+#define _HPP_GEODETIC_SOLVERS
+
+#include "constants.hpp"
+#include "ellipsoid.hpp"
+#include "fast_math.hpp"
+#include "instrumentation.hpp"
+#include <cmath>
+#include <type_traits>
+
+namespace fr {
+
+  namespace coordinates {
+
+    // Latitude and longitude in degrees and altitude in meters to ECEF
+    // x, y, z in meters. Works in float as well as double; math is a
+    // policy from fast_math.hpp for the sine and cosine.
+    template <typename math = precise_math, typename T>
+    inline void geodetic_to_ecef(T lat, T lon, T alt, const ellipsoid_parameters &e, T &x, T &y, T &z)
+    {
+      const T to_rad = T(fr::constants::pi / 180.0);
+      const T ae = e.ae;
+      const T ee = e.ee;
+      const T one_minus_ee = e.one_minus_ee;
+      T slat, clat, slon, clon;
+      math::sincos(lat * to_rad, slat, clat);
+      math::sincos(lon * to_rad, slon, clon);
+      T n = ae / std::sqrt(T(1) - ee * slat * slat);
+      T nh = (n + alt) * clat;
+      x = nh * clon;
+      y = nh * slon;
+      z = (n * one_minus_ee + alt) * slat;
+    }
+
+    struct iterative_solver {
+      double tolerance;
+
+      iterative_solver(double tolerance = 0.0000000001) : tolerance(tolerance)
+      {
+      }
+
+      void operator()(double x, double y, double z, const ellipsoid_parameters &e, double &lat, double &longitude, double &alt) const
+      {
+	double diff = 2 * tolerance;
+	double t = e.ee * z;
+	double n = 0.0;
+	double nph = 0.0;
+	double sinPhi = 0.0;
+#ifdef FR_COORDINATES_INSTRUMENT
+	unsigned iterations = 0;
+#endif
+
+	FR_COORDINATES_COUNT(instrument_geodetic_solves);
+	longitude = atan2(y, x) * 180 / fr::constants::pi;
+	while(diff > tolerance) {
+#ifdef FR_COORDINATES_INSTRUMENT
+	  ++iterations;
+#endif
+	  double zT = z + t;
+	  nph = sqrt(pow(x, 2) + pow(y, 2) + pow(zT, 2));
+	  sinPhi = zT / nph;
+	  n = e.ae / sqrt(1 - e.ee * sinPhi * sinPhi);
+	  double told = t;
+	  t = n * e.ee * sinPhi;
+	  diff = fabs(t - told);
+	}
+	FR_COORDINATES_RECORD(instrument_solver_iterations, iterations);
+
+	lat = asin(sinPhi) * 180 / fr::constants::pi;
+	alt = nph - n;
+      }
+    };
+
+    // bowring_solver and vermeille_solver take a math policy from
+    // fast_math.hpp for their atan2 and cbrt calls. fast_math keeps the
+    // batch loops free of library calls without -ffast-math.
+
+    template <unsigned iterations = 1, typename math = precise_math>
+    struct bowring_solver {
+
+      // Works in float as well as double, for the single precision
+      // batch conversions
+      template <typename T>
+      void operator()(T x, T y, T z, const ellipsoid_parameters &e, T &lat, T &longitude, T &alt) const
+      {
+	const T a = e.ae;
+	const T b = e.be;
+	const T ep2 = e.ep2;
+	const T ee = e.ee;
+	const T to_deg = T(180.0 / fr::constants::pi);
+	T p = std::sqrt(x * x + y * y);
+	// Parametric latitude of the first guess, tan(beta) = a z / b p.
+	// Kept as a sine/cosine pair so no trig calls are needed.
+	T r = std::sqrt(a * z * a * z + b * p * b * p);
+	T sb = a * z / r;
+	T cb = b * p / r;
+	T num = 0;
+	T den = 0;
+	T slat = 0;
+	T clat = 0;
+	for (unsigned i = 0; i < iterations; ++i) {
+	  num = z + ep2 * b * sb * sb * sb;
+	  den = p - ee * a * cb * cb * cb;
+	  T nrm = std::sqrt(num * num + den * den);
+	  slat = num / nrm;
+	  clat = den / nrm;
+	  // tan(beta) = (b / a) tan(lat) for the next pass
+	  T bs = b * slat;
+	  T ac = a * clat;
+	  T br = std::sqrt(bs * bs + ac * ac);
+	  sb = bs / br;
+	  cb = ac / br;
+	}
+	lat = math::atan2(num, den) * to_deg;
+	longitude = math::atan2(y, x) * to_deg;
+	alt = p * clat + z * slat - a * std::sqrt(T(1) - ee * slat * slat);
+      }
+    };
+
+    template <typename math = precise_math>
+    struct basic_vermeille_solver {
+
+      // Works in float as well as double. In float, latitude is good to
+      // a few 1e-5 degrees and altitude to a few meters.
+      template <typename T>
+      void operator()(T x, T y, T z, const ellipsoid_parameters &e, T &lat, T &longitude, T &alt) const
+      {
+	const T a2 = e.ae * e.ae;
+	const T ee = e.ee;
+	const T e4 = e.ee * e.ee;
+	const T one_minus_ee_a2 = e.one_minus_ee / (e.ae * e.ae);
+	const T to_deg = T(180.0 / fr::constants::pi);
+	T w2 = x * x + y * y;
+	T p = w2 / a2;
+	T q = one_minus_ee_a2 * z * z;
+	T r = (p + q - e4) / T(6);
+	T s = e4 * p * q / (T(4) * r * r * r);
+	T t = math::cbrt(T(1) + s + std::sqrt(s * (T(2) + s)));
+	T u = r * (T(1) + t + T(1) / t);
+	T v = std::sqrt(u * u + e4 * q);
+	T w = ee * (u + v - q) / (T(2) * v);
+	T k = std::sqrt(u + v + w * w) - w;
+	T d = k * std::sqrt(w2) / (k + ee);
+	T dz = std::sqrt(d * d + z * z);
+	lat = T(2) * math::atan2(z, d + dz) * to_deg;
+	longitude = math::atan2(y, x) * to_deg;
+	alt = (k + ee - T(1)) / k * dz;
+      }
+    };
+
+    typedef basic_vermeille_solver<> vermeille_solver;
+    typedef basic_vermeille_solver<fast_math> fast_vermeille_solver;
+
+    template <typename T>
+    struct is_geodetic_solver : std::false_type {
+    };
+
+    template <>
+    struct is_geodetic_solver<iterative_solver> : std::true_type {
+    };
+
+    template <unsigned iterations, typename math>
+    struct is_geodetic_solver<bowring_solver<iterations, math> > : std::true_type {
+    };
+
+    template <typename math>
+    struct is_geodetic_solver<basic_vermeille_solver<math> > : std::true_type {
+    };
+
+  }
+
+}
+
+#endif
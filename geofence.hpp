@@ -0,0 +1,756 @@
+/**
+ * Geofences. lat_long_polygon is a polygon on the same spherical earth
+ * haversine_distance uses, with great circle edges, so a fence drawn
+ * between two far apart vertices follows the shortest path between
+ * them rather than a line on a map. It tests points and circles for
+ * containment. geofence_index holds lots of them in a lat/long grid and
+ * tests points against all of them at once.
+ *
+ * Point in polygon casts a ray due south from the point along its
+ * meridian and counts the edges it crosses. Working in longitudes
+ * relative to the point means edges that cross the antimeridian need
+ * no special handling. A ring that winds all the way around the earth
+ * encloses a pole. Its inside is the side with the smaller area, so a
+ * ring at 80 north fences off the pole, not everything south of it.
+ * Use complement() for the other side. Any other ring encloses neither
+ * pole, which is what you want for any fence smaller than a hemisphere.
+ *
+ * Edges must span less than 180 degrees of longitude and vertices
+ * can't be on a pole, since neither has a well defined edge. Put an
+ * extra vertex in to go over a pole. Points exactly on an edge may be
+ * either inside or outside. NaN or infinite coordinates, in a vertex or
+ * in a point being tested, throw std::invalid_argument.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_GEOFENCE
+#define _HPP_GEOFENCE
+
+#include "constants.hpp"
+#include "ellipsoid.hpp"
+#include "haversine_distance.hpp"
+#include "lat_long.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace fr {
+
+  namespace coordinates {
+
+    // Longitude difference wrapped into [-180, 180)
+    inline double wrap_longitude(double degrees)
+    {
+      return degrees - 360.0 * floor((degrees + 180.0) / 360.0);
+    }
+
+    // How far east of from lon is, in [0, 360)
+    inline double degrees_east(double lon, double from)
+    {
+      double retval = wrap_longitude(lon - from);
+      return (retval < 0.0) ? retval + 360.0 : retval;
+    }
+
+    // Queries check their points with this before looking anything up,
+    // since a NaN longitude would make a garbage slab or cell index
+    inline void require_finite(double lat, double lon)
+    {
+      if (!std::isfinite(lat) || !std::isfinite(lon)) {
+	throw std::invalid_argument("geofence coordinates must be finite");
+      }
+    }
+
+    /**
+     * A latitude range and a longitude range starting at west and
+     * going extent degrees east, so a box can cross the antimeridian.
+     */
+
+    struct lat_long_box {
+      double south;
+      double north;
+      double west;
+      double extent;
+
+      static lat_long_box everywhere()
+      {
+	lat_long_box retval = { -90.0, 90.0, -180.0, 360.0 };
+	return retval;
+      }
+
+      bool contains(double lat, double lon) const
+      {
+	return lat >= south && lat <= north && degrees_east(lon, west) <= extent;
+      }
+
+      bool contains(const lat_long &p) const
+      {
+	return contains(p.get_lat(), p.get_long());
+      }
+
+      bool intersects(const lat_long_box &other) const
+      {
+	if (south > other.north || other.south > north) {
+	  return false;
+	}
+	// One of them starts inside the other
+	return degrees_east(other.west, west) <= extent || degrees_east(west, other.west) <= other.extent;
+      }
+
+    };
+
+    class lat_long_polygon {
+
+      struct edge {
+	double lon;		// Longitude of the first vertex
+	double span;		// Signed longitude change along the edge
+	double a[3];		// Unit vectors of the vertices
+	double b[3];
+	double n[3];		// Unit normal, a x b
+      };
+
+      // What point in polygon needs from an edge, copied into every
+      // slab the edge overlaps so each slab is one contiguous run
+      struct crossing {
+	double lon;
+	double span;
+	double up[3];		// Edge normal flipped to point north
+      };
+
+      double earth_radius;
+      std::vector<double> lats;
+      std::vector<double> lons;
+      std::vector<edge> edges;
+      // Edges by longitude slab, so a point only tests the edges whose
+      // longitudes overlap its own
+      double slab_width;
+      std::vector<size_t> slab_start;
+      std::vector<crossing> slab_crossings;
+      bool south_pole_inside;
+      double interior_area;
+      lat_long_box box;
+
+      static void unit_vector(double lat, double lon, double *v)
+      {
+	lat = lat * fr::constants::pi / 180.0;
+	lon = lon * fr::constants::pi / 180.0;
+	v[0] = cos(lat) * cos(lon);
+	v[1] = cos(lat) * sin(lon);
+	v[2] = sin(lat);
+      }
+
+      static void cross(const double *a, const double *b, double *out)
+      {
+	out[0] = a[1] * b[2] - a[2] * b[1];
+	out[1] = a[2] * b[0] - a[0] * b[2];
+	out[2] = a[0] * b[1] - a[1] * b[0];
+      }
+
+      static double dot(const double *a, const double *b)
+      {
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+      }
+
+      // Whether v, on the edge's great circle, is between its vertices
+      static bool on_arc(const edge &e, const double *v)
+      {
+	double c[3];
+	cross(e.a, v, c);
+	if (dot(c, e.n) < 0.0) {
+	  return false;
+	}
+	cross(v, e.b, c);
+	return dot(c, e.n) >= 0.0;
+      }
+
+      // Latitude of the northernmost point of the edge, which can be
+      // past both vertices
+      static double max_lat(const edge &e, double lat_a, double lat_b)
+      {
+	double retval = std::max(lat_a, lat_b);
+	double h = sqrt(e.n[0] * e.n[0] + e.n[1] * e.n[1]);
+	if (h == 0.0) {
+	  return retval;
+	}
+	// Top of the great circle, the pole pushed into its plane
+	double top[3] = { -e.n[0] * e.n[2] / h, -e.n[1] * e.n[2] / h, h };
+	if (on_arc(e, top)) {
+	  retval = std::max(retval, asin(std::min(h, 1.0)) * 180.0 / fr::constants::pi);
+	}
+	return retval;
+      }
+
+      static double min_lat(const edge &e, double lat_a, double lat_b)
+      {
+	double retval = std::min(lat_a, lat_b);
+	double h = sqrt(e.n[0] * e.n[0] + e.n[1] * e.n[1]);
+	if (h == 0.0) {
+	  return retval;
+	}
+	double bottom[3] = { e.n[0] * e.n[2] / h, e.n[1] * e.n[2] / h, -h };
+	if (on_arc(e, bottom)) {
+	  retval = std::min(retval, -asin(std::min(h, 1.0)) * 180.0 / fr::constants::pi);
+	}
+	return retval;
+      }
+
+      size_t slab_for(double lon) const
+      {
+	size_t slabs = slab_start.size() - 1;
+	size_t retval = (size_t) (degrees_east(lon, -180.0) / slab_width);
+	return std::min(retval, slabs - 1);
+      }
+
+      void build()
+      {
+	size_t count = lats.size();
+	if (count < 3) {
+	  throw std::invalid_argument("lat_long_polygon needs at least three vertices");
+	}
+	edges.resize(count);
+	double winding = 0.0;
+	double excess = 0.0;
+	double lon_now = 0.0;
+	double lon_low = 0.0;
+	double lon_high = 0.0;
+	box.south = 90.0;
+	box.north = -90.0;
+	for (size_t i = 0; i < count; ++i) {
+	  size_t j = (i + 1) % count;
+	  require_finite(lats[i], lons[i]);
+	  if (fabs(lats[i]) >= 90.0) {
+	    throw std::invalid_argument("lat_long_polygon vertices can't be on a pole");
+	  }
+	  edge &e = edges[i];
+	  e.lon = lons[i];
+	  e.span = wrap_longitude(lons[j] - lons[i]);
+	  if (e.span == -180.0) {
+	    throw std::invalid_argument("lat_long_polygon edges must span less than 180 degrees of longitude");
+	  }
+	  unit_vector(lats[i], lons[i], e.a);
+	  unit_vector(lats[j], lons[j], e.b);
+	  cross(e.a, e.b, e.n);
+	  double length = sqrt(dot(e.n, e.n));
+	  for (int k = 0; k < 3; ++k) {
+	    e.n[k] /= length;
+	  }
+	  box.south = std::min(box.south, min_lat(e, lats[i], lats[j]));
+	  box.north = std::max(box.north, max_lat(e, lats[i], lats[j]));
+
+	  // Signed area between the edge and the equator
+	  double t1 = tan(lats[i] * fr::constants::pi / 360.0);
+	  double t2 = tan(lats[j] * fr::constants::pi / 360.0);
+	  double half_span = e.span * fr::constants::pi / 360.0;
+	  excess += 2.0 * atan2(tan(half_span) * (t1 + t2), 1.0 + t1 * t2);
+	  winding += e.span;
+	  lon_now += e.span;
+	  lon_low = std::min(lon_low, lon_now);
+	  lon_high = std::max(lon_high, lon_now);
+	}
+
+	if (fabs(winding) < 180.0) {
+	  // Encloses neither pole
+	  south_pole_inside = false;
+	  interior_area = fabs(excess);
+	  box.west = wrap_longitude(lons[0] + lon_low);
+	  box.extent = lon_high - lon_low;
+	} else {
+	  // Goes around a pole, take the smaller side
+	  double north_area = fabs(winding * fr::constants::pi / 180.0 - excess);
+	  double south_area = 4.0 * fr::constants::pi - north_area;
+	  south_pole_inside = south_area < north_area;
+	  interior_area = std::min(north_area, south_area);
+	  box.west = -180.0;
+	  box.extent = 360.0;
+	  if (south_pole_inside) {
+	    box.south = -90.0;
+	  } else {
+	    box.north = 90.0;
+	  }
+	}
+	interior_area *= earth_radius * earth_radius;
+
+	// Around eight edges per slab, since a point tests every edge in
+	// its slab
+	size_t slabs = std::min((size_t) 512, std::max((size_t) 1, count / 8));
+	slab_width = 360.0 / slabs;
+	slab_start.resize(slabs + 1);
+	std::vector<std::vector<crossing> > by_slab(slabs);
+	for (size_t i = 0; i < count; ++i) {
+	  const edge &e = edges[i];
+	  double flip = (e.n[2] < 0.0) ? -1.0 : 1.0;
+	  crossing c = { e.lon, e.span, { e.n[0] * flip, e.n[1] * flip, e.n[2] * flip } };
+	  double west = (e.span < 0.0) ? e.lon + e.span : e.lon;
+	  size_t first = slab_for(west);
+	  size_t covered = std::min(slabs, (size_t) ((degrees_east(west, -180.0) - first * slab_width + fabs(e.span)) / slab_width) + 1);
+	  for (size_t s = 0; s < covered; ++s) {
+	    by_slab[(first + s) % slabs].push_back(c);
+	  }
+	}
+	slab_crossings.clear();
+	for (size_t s = 0; s < slabs; ++s) {
+	  slab_start[s] = slab_crossings.size();
+	  slab_crossings.insert(slab_crossings.end(), by_slab[s].begin(), by_slab[s].end());
+	}
+	slab_start[slabs] = slab_crossings.size();
+      }
+
+      void add_vertex(double lat, double lon)
+      {
+	// Skip repeats, including a closing vertex that repeats the first
+	if (!lats.empty() && lat == lats.back() && wrap_longitude(lon - lons.back()) == 0.0) {
+	  return;
+	}
+	lats.push_back(lat);
+	lons.push_back(lon);
+      }
+
+      void drop_closing_vertex()
+      {
+	if (lats.size() > 1 && lats.back() == lats.front() && wrap_longitude(lons.back() - lons.front()) == 0.0) {
+	  lats.pop_back();
+	  lons.pop_back();
+	}
+      }
+
+      // geofence_index frees the storage of the fences it removes
+      friend class geofence_index;
+
+      void release()
+      {
+	std::vector<double>().swap(lats);
+	std::vector<double>().swap(lons);
+	std::vector<edge>().swap(edges);
+	std::vector<size_t>().swap(slab_start);
+	std::vector<crossing>().swap(slab_crossings);
+      }
+
+    public:
+
+      /**
+       * Vertices in order around the ring, in either direction. The ring
+       * closes itself, but repeating the first vertex at the end is fine
+       * too. Throws std::invalid_argument for fewer than three distinct
+       * vertices, a vertex on a pole, an edge spanning 180 degrees of
+       * longitude or a vertex that isn't finite. Distances and areas are
+       * in the units of earth_radius, meters by default, same as
+       * haversine_distance.
+       */
+
+      lat_long_polygon(const std::vector<lat_long> &vertices, double earth_radius = WGS84_ELLIPSOID.ae) : earth_radius(earth_radius)
+      {
+	for (size_t i = 0; i < vertices.size(); ++i) {
+	  add_vertex(vertices[i].get_lat(), vertices[i].get_long());
+	}
+	drop_closing_vertex();
+	build();
+      }
+
+      lat_long_polygon(const double *lat, const double *lon, size_t count, double earth_radius = WGS84_ELLIPSOID.ae) : earth_radius(earth_radius)
+      {
+	for (size_t i = 0; i < count; ++i) {
+	  add_vertex(lat[i], lon[i]);
+	}
+	drop_closing_vertex();
+	build();
+      }
+
+      // Everything outside this polygon
+      lat_long_polygon complement() const
+      {
+	lat_long_polygon retval(*this);
+	retval.south_pole_inside = !south_pole_inside;
+	retval.interior_area = 4.0 * fr::constants::pi * earth_radius * earth_radius - interior_area;
+	retval.box = lat_long_box::everywhere();
+	return retval;
+      }
+
+      size_t size() const
+      {
+	return lats.size();
+      }
+
+      lat_long get(size_t vertex) const
+      {
+	return lat_long(lats[vertex], lons[vertex]);
+      }
+
+      // Area inside the fence
+      double area() const
+      {
+	return interior_area;
+      }
+
+      // Covers everything inside, edges included
+      const lat_long_box &bounds() const
+      {
+	return box;
+      }
+
+      bool contains(double lat, double lon) const
+      {
+	require_finite(lat, lon);
+	if (!box.contains(lat, lon)) {
+	  return false;
+	}
+	double p[3];
+	bool have_p = false;
+	bool inside = south_pole_inside;
+	size_t slab = slab_for(lon);
+	const crossing *c = slab_crossings.data();
+	for (size_t i = slab_start[slab]; i < slab_start[slab + 1]; ++i) {
+	  double rel = wrap_longitude(lon - c[i].lon);
+	  bool crosses = (c[i].span > 0.0) ? (rel >= 0.0 && rel < c[i].span) : (rel >= c[i].span && rel < 0.0);
+	  if (!crosses) {
+	    continue;
+	  }
+	  // The ray goes through an edge whose meridian it crosses if the
+	  // point is north of the edge's great circle
+	  if (!have_p) {
+	    unit_vector(lat, lon, p);
+	    have_p = true;
+	  }
+	  if (dot(c[i].up, p) > 0.0) {
+	    inside = !inside;
+	  }
+	}
+	return inside;
+      }
+
+      bool contains(const lat_long &p) const
+      {
+	return contains(p.get_lat(), p.get_long());
+      }
+
+      // Batch form, for count points given as latitude and longitude arrays
+      void contains(const double *lat, const double *lon, bool *out, size_t count) const
+      {
+	for (size_t i = 0; i < count; ++i) {
+	  out[i] = contains(lat[i], lon[i]);
+	}
+      }
+
+      /**
+       * Great circle distance from p to the nearest point on any edge,
+       * whether p is inside or not. Distances to vertices come from
+       * haversine_distance.
+       */
+
+      double distance_to_boundary(const lat_long &p) const
+      {
+	std::vector<double> to_vertex(lats.size());
+	haversine_distance(earth_radius).distances(p, lats.data(), lons.data(), to_vertex.data(), lats.size());
+	double v[3];
+	unit_vector(p.get_lat(), p.get_long(), v);
+	double retval = to_vertex[0];
+	for (size_t i = 0; i < edges.size(); ++i) {
+	  const edge &e = edges[i];
+	  retval = std::min(retval, to_vertex[i]);
+	  // Closest point on the edge's great circle
+	  double s = dot(e.n, v);
+	  double foot[3] = { v[0] - s * e.n[0], v[1] - s * e.n[1], v[2] - s * e.n[2] };
+	  if (on_arc(e, foot)) {
+	    retval = std::min(retval, earth_radius * asin(std::min(fabs(s), 1.0)));
+	  }
+	}
+	return retval;
+      }
+
+      // Whether the whole circle of radius around center is inside
+      bool contains(const lat_long &center, double radius) const
+      {
+	return contains(center) && distance_to_boundary(center) >= radius;
+      }
+
+    };
+
+    /**
+     * Lots of fences in a grid of cell_degrees by cell_degrees cells.
+     * Each cell lists the fences whose bounding boxes overlap it, so a
+     * point only gets tested against fences near it. Fences that cover
+     * more than an eighth of the grid, the polar ones for instance, are
+     * tested for every point instead of filling up the cells.
+     *
+     * Fences get ids in the order they're added, starting at 0. Not
+     * thread safe for writes. Concurrent queries are fine.
+     */
+
+    class geofence_index {
+
+    public:
+
+      struct hit {
+	size_t point;
+	size_t fence;
+      };
+
+    private:
+
+      struct fence {
+	lat_long_polygon polygon;
+	bool alive;
+	bool large;
+      };
+
+      // The cells keep a copy of each fence's bounding box, so most
+      // candidates get thrown out without touching the fence itself
+      struct cell_entry {
+	lat_long_box box;
+	size_t id;
+
+	bool operator==(size_t other) const
+	{
+	  return id == other;
+	}
+      };
+
+      typedef std::vector<cell_entry> cell;
+
+      double cell_degrees;
+      size_t rows;
+      size_t cols;
+      std::vector<fence> fences;
+      std::vector<cell> cells;
+      cell large;
+      size_t live_count;
+
+      size_t row_for(double lat) const
+      {
+	double r = floor((lat + 90.0) / cell_degrees);
+	return (size_t) std::max(0.0, std::min(r, (double) (rows - 1)));
+      }
+
+      size_t col_for(double lon) const
+      {
+	return std::min((size_t) (degrees_east(lon, -180.0) / cell_degrees), cols - 1);
+      }
+
+      // Calls f(cell) for every cell a box overlaps
+      template <typename func>
+      void each_cell(const lat_long_box &box, func f) const
+      {
+	size_t first_col = col_for(box.west);
+	size_t col_count = std::min(cols, (size_t) ((degrees_east(box.west, -180.0) - first_col * cell_degrees + box.extent) / cell_degrees) + 1);
+	for (size_t r = row_for(box.south); r <= row_for(box.north); ++r) {
+	  for (size_t c = 0; c < col_count; ++c) {
+	    f(r * cols + (first_col + c) % cols);
+	  }
+	}
+      }
+
+      size_t cell_count(const lat_long_box &box) const
+      {
+	size_t col_count = std::min(cols, (size_t) (box.extent / cell_degrees) + 2);
+	return (row_for(box.north) - row_for(box.south) + 1) * col_count;
+      }
+
+      struct add_to_cell {
+	std::vector<cell> *cells;
+	cell_entry entry;
+
+	void operator()(size_t c) const
+	{
+	  (*cells)[c].push_back(entry);
+	}
+      };
+
+      struct remove_from_cell {
+	std::vector<cell> *cells;
+	size_t id;
+
+	void operator()(size_t c) const
+	{
+	  cell &entries = (*cells)[c];
+	  entries.erase(std::find(entries.begin(), entries.end(), id));
+	}
+      };
+
+      // Calls f(id) for every fence whose bounding box holds the point
+      template <typename func>
+      void candidates(double lat, double lon, func f) const
+      {
+	require_finite(lat, lon);
+	const cell &entries = cells[row_for(lat) * cols + col_for(lon)];
+	for (size_t i = 0; i < entries.size(); ++i) {
+	  if (entries[i].box.contains(lat, lon)) {
+	    f(entries[i].id);
+	  }
+	}
+	for (size_t i = 0; i < large.size(); ++i) {
+	  if (large[i].box.contains(lat, lon)) {
+	    f(large[i].id);
+	  }
+	}
+      }
+
+      struct collect_containing {
+	const std::vector<fence> *fences;
+	double lat;
+	double lon;
+	std::vector<size_t> *out;
+
+	void operator()(size_t id) const
+	{
+	  if ((*fences)[id].polygon.contains(lat, lon)) {
+	    out->push_back(id);
+	  }
+	}
+      };
+
+      struct collect_circle {
+	const std::vector<fence> *fences;
+	lat_long center;
+	double radius;
+	std::vector<size_t> *out;
+
+	void operator()(size_t id) const
+	{
+	  if ((*fences)[id].polygon.contains(center, radius)) {
+	    out->push_back(id);
+	  }
+	}
+      };
+
+    public:
+
+      geofence_index(double cell_degrees = 1.0) : cell_degrees(cell_degrees), live_count(0)
+      {
+	rows = (size_t) ceil(180.0 / cell_degrees);
+	cols = (size_t) ceil(360.0 / cell_degrees);
+	cells.resize(rows * cols);
+      }
+
+      // Adds a fence and returns its id
+      size_t insert(const lat_long_polygon &polygon)
+      {
+	fence f = { polygon, true, false };
+	size_t id = fences.size();
+	f.large = cell_count(polygon.bounds()) * 8 > rows * cols;
+	fences.push_back(f);
+	++live_count;
+	cell_entry entry = { polygon.bounds(), id };
+	if (f.large) {
+	  large.push_back(entry);
+	} else {
+	  add_to_cell add = { &cells, entry };
+	  each_cell(polygon.bounds(), add);
+	}
+	return id;
+      }
+
+      // Returns false if the id wasn't in the index
+      bool remove(size_t id)
+      {
+	if (id >= fences.size() || !fences[id].alive) {
+	  return false;
+	}
+	fences[id].alive = false;
+	--live_count;
+	if (fences[id].large) {
+	  large.erase(std::find(large.begin(), large.end(), id));
+	} else {
+	  remove_from_cell erase = { &cells, id };
+	  each_cell(fences[id].polygon.bounds(), erase);
+	}
+	fences[id].polygon.release();
+	return true;
+      }
+
+      bool contains(size_t id) const
+      {
+	return id < fences.size() && fences[id].alive;
+      }
+
+      // A removed fence's polygon has been freed and has no vertices
+      const lat_long_polygon &get(size_t id) const
+      {
+	return fences[id].polygon;
+      }
+
+      size_t size() const
+      {
+	return live_count;
+      }
+
+      /**
+       * Ids of every fence containing p, appended to out in no
+       * particular order.
+       */
+
+      void containing(const lat_long &p, std::vector<size_t> &out) const
+      {
+	collect_containing collect = { &fences, p.get_lat(), p.get_long(), &out };
+	candidates(p.get_lat(), p.get_long(), collect);
+      }
+
+      std::vector<size_t> containing(const lat_long &p) const
+      {
+	std::vector<size_t> retval;
+	containing(p, retval);
+	return retval;
+      }
+
+      // Every fence the whole circle of radius around center is inside
+      void containing(const lat_long &center, double radius, std::vector<size_t> &out) const
+      {
+	// A fence holding the circle holds its center, so the center's
+	// cell has every candidate
+	collect_circle collect = { &fences, center, radius, &out };
+	candidates(center.get_lat(), center.get_long(), collect);
+      }
+
+      /**
+       * Many points against every fence. Appends a hit for each point
+       * and fence containing it, in no particular order. With several
+       * points per grid cell they're taken a cell at a time, so the
+       * fences near each cell only get pulled into cache once however
+       * scattered the points are. Every point is checked before any
+       * hits are appended.
+       */
+
+      void containing(const double *lat, const double *lon, size_t count, std::vector<hit> &out) const
+      {
+	std::vector<std::pair<size_t, size_t> > order(count);
+	for (size_t i = 0; i < count; ++i) {
+	  require_finite(lat[i], lon[i]);
+	  order[i] = std::make_pair(row_for(lat[i]) * cols + col_for(lon[i]), i);
+	}
+	// Fewer points than that and sorting costs more than it saves
+	if (count >= 4 * cells.size()) {
+	  std::sort(order.begin(), order.end());
+	}
+	std::vector<size_t> found;
+	for (size_t k = 0; k < count; ++k) {
+	  size_t i = order[k].second;
+	  found.clear();
+	  collect_containing collect = { &fences, lat[i], lon[i], &found };
+	  candidates(lat[i], lon[i], collect);
+	  for (size_t j = 0; j < found.size(); ++j) {
+	    hit h = { i, found[j] };
+	    out.push_back(h);
+	  }
+	}
+      }
+
+    };
+
+  }
+
+}
+
+#endif
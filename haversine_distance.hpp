@@ -30,7 +30,9 @@
 #include "ellipsoid.hpp"
 #include "lat_long.hpp"
 #include "constants.hpp"
+#include "fast_math.hpp"
 #include <cmath>
+#include <cstddef>
 
 namespace fr {
 
@@ -59,6 +61,116 @@ namespace fr {
 	return earth_radius * c;	
       }
 
+      /**
+       * One to many. Distances from one point to count points given as
+       * latitude and longitude arrays (degrees.) The reference point's
+       * trig is done once, outside the loop, and the loop is written so
+       * gcc can vectorize it at -O3 -ffast-math, or at plain -O3 with
+       * fast_math() as the last argument.
+       */
+
+      template <typename math = precise_math>
+      void distances(const lat_long &from, const double * __restrict__ lat, const double * __restrict__ lon, double * __restrict__ out, size_t count, const math & = math())
+      {
+	distances_kernel<math>(earth_radius, from, lat, lon, out, count);
+      }
+
+      // Same thing on the kernel set simd_dispatch.hpp picked for this CPU
+      template <typename math>
+      void distances(const lat_long &from, const double *lat, const double *lon, double *out, size_t count, const dispatched<math> &)
+      {
+	dispatched<math>::kernels().distances(earth_radius, from, lat, lon, out, count);
+      }
+
+      // The loop itself, inlined into distances() and into each of the
+      // instruction set specific copies in simd_dispatch.hpp
+      template <typename math>
+      __attribute__((always_inline)) static void distances_kernel(double r, const lat_long &from, const double * __restrict__ lat, const double * __restrict__ lon, double * __restrict__ out, size_t count)
+      {
+	const double to_rad = fr::constants::pi / 180.0;
+	const double lat1 = from.get_lat() * to_rad;
+	const double lon1 = from.get_long() * to_rad;
+	const double clat1 = cos(lat1);
+	for (size_t i = 0; i < count; ++i) {
+	  double lat2 = lat[i] * to_rad;
+	  double sdlat = math::sin((lat2 - lat1) / 2.0);
+	  double sdlon = math::sin((lon[i] * to_rad - lon1) / 2.0);
+	  // cos as a shifted sin, or gcc fuses it into a sincos it can't vectorize
+	  double clat2 = math::sin(lat2 + fr::constants::pi / 2.0);
+	  double a = sdlat * sdlat + clat1 * clat2 * sdlon * sdlon;
+	  out[i] = r * 2.0 * math::atan2(sqrt(a), sqrt(1.0 - a));
+	}
+      }
+
+      /**
+       * Many to many. Fills out with n1 rows of n2 distances, row i
+       * holding the distances from point i of the first set to every
+       * point of the second.
+       */
+
+      template <typename math = precise_math>
+      void distances(const double *lat1, const double *lon1, size_t n1, const double *lat2, const double *lon2, size_t n2, double *out, const math &m = math())
+      {
+	for (size_t i = 0; i < n1; ++i) {
+	  distances(lat_long(lat1[i], lon1[i]), lat2, lon2, out + i * n2, n2, m);
+	}
+      }
+
+      /**
+       * One to many distance and bearing together. Gives the same
+       * bearings as the bearing object, but shares the half angle sines
+       * and the latitude trig with the distance calculation.
+       */
+
+      template <typename math = precise_math>
+      void distances_and_bearings(const lat_long &from, const double * __restrict__ lat, const double * __restrict__ lon, double * __restrict__ dist_out, double * __restrict__ bearing_out, size_t count, const math & = math())
+      {
+	distances_and_bearings_kernel<math>(earth_radius, from, lat, lon, dist_out, bearing_out, count);
+      }
+
+      template <typename math>
+      void distances_and_bearings(const lat_long &from, const double *lat, const double *lon, double *dist_out, double *bearing_out, size_t count, const dispatched<math> &)
+      {
+	dispatched<math>::kernels().distances_and_bearings(earth_radius, from, lat, lon, dist_out, bearing_out, count);
+      }
+
+      template <typename math>
+      __attribute__((always_inline)) static void distances_and_bearings_kernel(double r, const lat_long &from, const double * __restrict__ lat, const double * __restrict__ lon, double * __restrict__ dist_out, double * __restrict__ bearing_out, size_t count)
+      {
+	const double to_rad = fr::constants::pi / 180.0;
+	const double lat1 = from.get_lat() * to_rad;
+	const double lon1 = from.get_long() * to_rad;
+	const double slat1 = sin(lat1);
+	const double clat1 = cos(lat1);
+	for (size_t i = 0; i < count; ++i) {
+	  double lat2 = lat[i] * to_rad;
+	  double half_dlon = (lon[i] * to_rad - lon1) / 2.0;
+	  double sdlat = math::sin((lat2 - lat1) / 2.0);
+	  double sdlon, cdlon, slat2, clat2;
+	  math::sincos(half_dlon, sdlon, cdlon);
+	  math::sincos(lat2, slat2, clat2);
+	  double a = sdlat * sdlat + clat1 * clat2 * sdlon * sdlon;
+	  dist_out[i] = r * 2.0 * math::atan2(sqrt(a), sqrt(1.0 - a));
+	  // Double angle formulas get sin and cos of dlon for the bearing
+	  double sin_dlon = 2.0 * sdlon * cdlon;
+	  double cos_dlon = 1.0 - 2.0 * sdlon * sdlon;
+	  double y = -sin_dlon * clat2;
+	  double x = clat1 * slat2 - slat1 * clat2 * cos_dlon;
+	  // Same as the single point fmod, without the call
+	  double b = math::atan2(y, x) * 180.0 / fr::constants::pi + 360.0;
+	  bearing_out[i] = (b >= 360.0) ? b - 360.0 : b;
+	}
+      }
+
+      // Many to many distance and bearing, laid out like distances()
+      template <typename math = precise_math>
+      void distances_and_bearings(const double *lat1, const double *lon1, size_t n1, const double *lat2, const double *lon2, size_t n2, double *dist_out, double *bearing_out, const math &m = math())
+      {
+	for (size_t i = 0; i < n1; ++i) {
+	  distances_and_bearings(lat_long(lat1[i], lon1[i]), lat2, lon2, dist_out + i * n2, bearing_out + i * n2, n2, m);
+	}
+      }
+
     };
 
   }
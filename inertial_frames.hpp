@@ -0,0 +1,595 @@
+/**
+ * J2000 and TEME inertial frames, tied to true of date ECI and ECEF by
+ * the IAU-76/FK5 reduction: IAU 1976 precession, the full 106 term IAU
+ * 1980 nutation series, apparent sidereal time with the 1994 equation
+ * of the equinoxes, and optional polar motion. From inertial to earth
+ * fixed the chain is
+ *
+ *   j2000 -> (precession) -> mean of date -> (nutation) -> tod_eci
+ *   tod_eci -> (apparent sidereal time) -> pseudo earth fixed
+ *   teme -> (mean sidereal time) -> pseudo earth fixed
+ *   pseudo earth fixed -> (polar motion) -> ecef
+ *
+ * tod_eci here is true of date proper. eci_ecef_rotation in
+ * conversion_matrices.hpp rotates by mean sidereal time only, which
+ * makes the tod_eci it produces TEME in all but name; the two differ
+ * by the equation of the equinoxes, around a second of arc. Code that
+ * needs J2000 or a strict true of date should go through a
+ * frame_rotation.
+ *
+ * J2000 is the FK5 mean equator and equinox of J2000.0. Filled in from
+ * the IERS bulletins, the ddpsi and ddeps nutation corrections bring it
+ * to GCRF within a few milliarcseconds.
+ *
+ * Times are seconds since the epoch, as everywhere else in the library,
+ * and are taken as UT1 for sidereal time. Precession and nutation run
+ * on TT, at_time + tt_offset.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_INERTIAL_FRAMES
+#define _HPP_INERTIAL_FRAMES
+
+#include "constants.hpp"
+#include "conversion_matrices.hpp"
+#include "gmst.hpp"
+#include "instrumentation.hpp"
+#include "xyz_point.hpp"
+#include <Eigen/Core>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+
+namespace fr {
+
+  namespace coordinates {
+
+    // Frame tags
+    struct j2000_frame {
+    };
+
+    struct teme_frame {
+    };
+
+    typedef xyz_point<j2000_frame> j2000_point;
+    typedef xyz_point<teme_frame> teme_point;
+
+    // The frames a frame_rotation can rotate between
+    template <typename frame>
+    struct is_chain_frame : std::integral_constant<bool, std::is_same<frame,ecef_frame>::value || std::is_same<frame,tod_eci_frame>::value || std::is_same<frame,j2000_frame>::value || std::is_same<frame,teme_frame>::value> {
+    };
+
+    // The frames the point converters will feed into a frame_rotation.
+    // A tod_eci_point usually came from eci_ecef_rotation, which makes
+    // it TEME in all but name, so it isn't taken as true of date here;
+    // wrap the numbers in a teme_point to say which one is meant, or use
+    // frame_rotation::rotate<tod_eci_frame, ...> for a strict true of
+    // date position.
+    template <typename frame>
+    struct is_chain_source_frame : std::integral_constant<bool, is_chain_frame<frame>::value && !std::is_same<frame,tod_eci_frame>::value> {
+    };
+
+    /**
+     * Earth orientation parameters, as published in IERS Bulletin A
+     * (polar motion) and Bulletin B (the IAU-80 nutation corrections.)
+     * The defaults leave polar motion and the corrections out, which
+     * costs up to about 15 meters at the surface and a meter or two in
+     * J2000 respectively.
+     */
+
+    struct earth_orientation {
+      // Polar motion, arc seconds
+      double xp;
+      double yp;
+      // Corrections to nutation in longitude and obliquity, arc seconds
+      double ddpsi;
+      double ddeps;
+      // TT minus the times passed in, seconds. Defaults to TT - UTC
+      // since 2017. Each second it's off moves a low orbit position by
+      // about 0.05 millimeters.
+      double tt_offset;
+
+      earth_orientation(double xp = 0.0, double yp = 0.0, double ddpsi = 0.0, double ddeps = 0.0, double tt_offset = 69.184) : xp(xp), yp(yp), ddpsi(ddpsi), ddeps(ddeps), tt_offset(tt_offset)
+      {
+      }
+
+    };
+
+    // Frame rotations about the x, y and z axes, in the sense that
+    // rotating the axes by a takes a vector's components from the old
+    // axes to the new ones.
+
+    inline Eigen::Matrix3d frame_rotation_x(double a)
+    {
+      double s = sin(a);
+      double c = cos(a);
+      Eigen::Matrix3d retval;
+      retval << 1.0, 0.0, 0.0,
+	0.0, c, s,
+	0.0, -s, c;
+      return retval;
+    }
+
+    inline Eigen::Matrix3d frame_rotation_y(double a)
+    {
+      double s = sin(a);
+      double c = cos(a);
+      Eigen::Matrix3d retval;
+      retval << c, 0.0, -s,
+	0.0, 1.0, 0.0,
+	s, 0.0, c;
+      return retval;
+    }
+
+    inline Eigen::Matrix3d frame_rotation_z(double a)
+    {
+      double s = sin(a);
+      double c = cos(a);
+      Eigen::Matrix3d retval;
+      retval << c, s, 0.0,
+	-s, c, 0.0,
+	0.0, 0.0, 1.0;
+      return retval;
+    }
+
+    /**
+     * IAU 1976 precession and IAU 1980 nutation at one epoch. Building
+     * one evaluates the whole nutation series, a few microseconds of
+     * work, so keep them around (or let a frame_chain do it) when
+     * converting more than a handful of points.
+     */
+
+    class precession_nutation {
+      double zeta;
+      double theta;
+      double z;
+      double mean_obliquity;
+      double dpsi;
+      double deps;
+      double eqe;
+
+      struct nutation_term {
+	// Multiples of the Moon's and Sun's mean anomalies, the Moon's
+	// argument of latitude, its elongation from the Sun and the
+	// longitude of its ascending node
+	int nl, nlp, nf, nd, nom;
+	// Longitude and obliquity coefficients and their rates per
+	// century, in 0.1 milliarcseconds
+	double sp, spt, ce, cet;
+      };
+
+      static constexpr double arcsec = fr::constants::pi / (180.0 * 3600.0);
+
+      // Seconds since the epoch to Julian centuries since J2000.0
+      static double centuries(const double &at_time)
+      {
+	return ((at_time / fr::constants::secs_per_ut1_day + 2440587.5) - 2451545.0) / 36525.0;
+      }
+
+      // Fundamental argument: a polynomial in arc seconds, plus whole
+      // revolutions per century kept separate to hold on to precision
+      static double argument(double t, double c0, double c1, double c2, double c3, double revolutions)
+      {
+	double a = fmod(c0 + (c1 + (c2 + c3 * t) * t) * t, 1296000.0) * arcsec;
+	return fmod(a + fmod(revolutions * t, 1.0) * 2.0 * fr::constants::pi, 2.0 * fr::constants::pi);
+      }
+
+      void nutate(double t, double &omega)
+      {
+	static const nutation_term terms[] = {
+	  {  0,  0,  0,  0,  1, -171996.0, -174.2,  92025.0,   8.9 },
+	  {  0,  0,  0,  0,  2,    2062.0,    0.2,   -895.0,   0.5 },
+	  { -2,  0,  2,  0,  1,      46.0,    0.0,    -24.0,   0.0 },
+	  {  2,  0, -2,  0,  0,      11.0,    0.0,      0.0,   0.0 },
+	  { -2,  0,  2,  0,  2,      -3.0,    0.0,      1.0,   0.0 },
+	  {  1, -1,  0, -1,  0,      -3.0,    0.0,      0.0,   0.0 },
+	  {  0, -2,  2, -2,  1,      -2.0,    0.0,      1.0,   0.0 },
+	  {  2,  0, -2,  0,  1,       1.0,    0.0,      0.0,   0.0 },
+	  {  0,  0,  2, -2,  2,  -13187.0,   -1.6,   5736.0,  -3.1 },
+	  {  0,  1,  0,  0,  0,    1426.0,   -3.4,     54.0,  -0.1 },
+	  {  0,  1,  2, -2,  2,    -517.0,    1.2,    224.0,  -0.6 },
+	  {  0, -1,  2, -2,  2,     217.0,   -0.5,    -95.0,   0.3 },
+	  {  0,  0,  2, -2,  1,     129.0,    0.1,    -70.0,   0.0 },
+	  {  2,  0,  0, -2,  0,      48.0,    0.0,      1.0,   0.0 },
+	  {  0,  0,  2, -2,  0,     -22.0,    0.0,      0.0,   0.0 },
+	  {  0,  2,  0,  0,  0,      17.0,   -0.1,      0.0,   0.0 },
+	  {  0,  1,  0,  0,  1,     -15.0,    0.0,      9.0,   0.0 },
+	  {  0,  2,  2, -2,  2,     -16.0,    0.1,      7.0,   0.0 },
+	  {  0, -1,  0,  0,  1,     -12.0,    0.0,      6.0,   0.0 },
+	  { -2,  0,  0,  2,  1,      -6.0,    0.0,      3.0,   0.0 },
+	  {  0, -1,  2, -2,  1,      -5.0,    0.0,      3.0,   0.0 },
+	  {  2,  0,  0, -2,  1,       4.0,    0.0,     -2.0,   0.0 },
+	  {  0,  1,  2, -2,  1,       4.0,    0.0,     -2.0,   0.0 },
+	  {  1,  0,  0, -1,  0,      -4.0,    0.0,      0.0,   0.0 },
+	  {  2,  1,  0, -2,  0,       1.0,    0.0,      0.0,   0.0 },
+	  {  0,  0, -2,  2,  1,       1.0,    0.0,      0.0,   0.0 },
+	  {  0,  1, -2,  2,  0,      -1.0,    0.0,      0.0,   0.0 },
+	  {  0,  1,  0,  0,  2,       1.0,    0.0,      0.0,   0.0 },
+	  { -1,  0,  0,  1,  1,       1.0,    0.0,      0.0,   0.0 },
+	  {  0,  1,  2, -2,  0,      -1.0,    0.0,      0.0,   0.0 },
+	  {  0,  0,  2,  0,  2,   -2274.0,   -0.2,    977.0,  -0.5 },
+	  {  1,  0,  0,  0,  0,     712.0,    0.1,     -7.0,   0.0 },
+	  {  0,  0,  2,  0,  1,    -386.0,   -0.4,    200.0,   0.0 },
+	  {  1,  0,  2,  0,  2,    -301.0,    0.0,    129.0,  -0.1 },
+	  {  1,  0,  0, -2,  0,    -158.0,    0.0,     -1.0,   0.0 },
+	  { -1,  0,  2,  0,  2,     123.0,    0.0,    -53.0,   0.0 },
+	  {  0,  0,  0,  2,  0,      63.0,    0.0,     -2.0,   0.0 },
+	  {  1,  0,  0,  0,  1,      63.0,    0.1,    -33.0,   0.0 },
+	  { -1,  0,  0,  0,  1,     -58.0,   -0.1,     32.0,   0.0 },
+	  { -1,  0,  2,  2,  2,     -59.0,    0.0,     26.0,   0.0 },
+	  {  1,  0,  2,  0,  1,     -51.0,    0.0,     27.0,   0.0 },
+	  {  0,  0,  2,  2,  2,     -38.0,    0.0,     16.0,   0.0 },
+	  {  2,  0,  0,  0,  0,      29.0,    0.0,     -1.0,   0.0 },
+	  {  1,  0,  2, -2,  2,      29.0,    0.0,    -12.0,   0.0 },
+	  {  2,  0,  2,  0,  2,     -31.0,    0.0,     13.0,   0.0 },
+	  {  0,  0,  2,  0,  0,      26.0,    0.0,     -1.0,   0.0 },
+	  { -1,  0,  2,  0,  1,      21.0,    0.0,    -10.0,   0.0 },
+	  { -1,  0,  0,  2,  1,      16.0,    0.0,     -8.0,   0.0 },
+	  {  1,  0,  0, -2,  1,     -13.0,    0.0,      7.0,   0.0 },
+	  { -1,  0,  2,  2,  1,     -10.0,    0.0,      5.0,   0.0 },
+	  {  1,  1,  0, -2,  0,      -7.0,    0.0,      0.0,   0.0 },
+	  {  0,  1,  2,  0,  2,       7.0,    0.0,     -3.0,   0.0 },
+	  {  0, -1,  2,  0,  2,      -7.0,    0.0,      3.0,   0.0 },
+	  {  1,  0,  2,  2,  2,      -8.0,    0.0,      3.0,   0.0 },
+	  {  1,  0,  0,  2,  0,       6.0,    0.0,      0.0,   0.0 },
+	  {  2,  0,  2, -2,  2,       6.0,    0.0,     -3.0,   0.0 },
+	  {  0,  0,  0,  2,  1,      -6.0,    0.0,      3.0,   0.0 },
+	  {  0,  0,  2,  2,  1,      -7.0,    0.0,      3.0,   0.0 },
+	  {  1,  0,  2, -2,  1,       6.0,    0.0,     -3.0,   0.0 },
+	  {  0,  0,  0, -2,  1,      -5.0,    0.0,      3.0,   0.0 },
+	  {  1, -1,  0,  0,  0,       5.0,    0.0,      0.0,   0.0 },
+	  {  2,  0,  2,  0,  1,      -5.0,    0.0,      3.0,   0.0 },
+	  {  0,  1,  0, -2,  0,      -4.0,    0.0,      0.0,   0.0 },
+	  {  1,  0, -2,  0,  0,       4.0,    0.0,      0.0,   0.0 },
+	  {  0,  0,  0,  1,  0,      -4.0,    0.0,      0.0,   0.0 },
+	  {  1,  1,  0,  0,  0,      -3.0,    0.0,      0.0,   0.0 },
+	  {  1,  0,  2,  0,  0,       3.0,    0.0,      0.0,   0.0 },
+	  {  1, -1,  2,  0,  2,      -3.0,    0.0,      1.0,   0.0 },
+	  { -1, -1,  2,  2,  2,      -3.0,    0.0,      1.0,   0.0 },
+	  { -2,  0,  0,  0,  1,      -2.0,    0.0,      1.0,   0.0 },
+	  {  3,  0,  2,  0,  2,      -3.0,    0.0,      1.0,   0.0 },
+	  {  0, -1,  2,  2,  2,      -3.0,    0.0,      1.0,   0.0 },
+	  {  1,  1,  2,  0,  2,       2.0,    0.0,     -1.0,   0.0 },
+	  { -1,  0,  2, -2,  1,      -2.0,    0.0,      1.0,   0.0 },
+	  {  2,  0,  0,  0,  1,       2.0,    0.0,     -1.0,   0.0 },
+	  {  1,  0,  0,  0,  2,      -2.0,    0.0,      1.0,   0.0 },
+	  {  3,  0,  0,  0,  0,       2.0,    0.0,      0.0,   0.0 },
+	  {  0,  0,  2,  1,  2,       2.0,    0.0,     -1.0,   0.0 },
+	  { -1,  0,  0,  0,  2,       1.0,    0.0,     -1.0,   0.0 },
+	  {  1,  0,  0, -4,  0,      -1.0,    0.0,      0.0,   0.0 },
+	  { -2,  0,  2,  2,  2,       1.0,    0.0,     -1.0,   0.0 },
+	  { -1,  0,  2,  4,  2,      -2.0,    0.0,      1.0,   0.0 },
+	  {  2,  0,  0, -4,  0,      -1.0,    0.0,      0.0,   0.0 },
+	  {  1,  1,  2, -2,  2,       1.0,    0.0,     -1.0,   0.0 },
+	  {  1,  0,  2,  2,  1,      -1.0,    0.0,      1.0,   0.0 },
+	  { -2,  0,  2,  4,  2,      -1.0,    0.0,      1.0,   0.0 },
+	  { -1,  0,  4,  0,  2,       1.0,    0.0,      0.0,   0.0 },
+	  {  1, -1,  0, -2,  0,       1.0,    0.0,      0.0,   0.0 },
+	  {  2,  0,  2, -2,  1,       1.0,    0.0,     -1.0,   0.0 },
+	  {  2,  0,  2,  2,  2,      -1.0,    0.0,      0.0,   0.0 },
+	  {  1,  0,  0,  2,  1,      -1.0,    0.0,      0.0,   0.0 },
+	  {  0,  0,  4, -2,  2,       1.0,    0.0,      0.0,   0.0 },
+	  {  3,  0,  2, -2,  2,       1.0,    0.0,      0.0,   0.0 },
+	  {  1,  0,  2, -2,  0,      -1.0,    0.0,      0.0,   0.0 },
+	  {  0,  1,  2,  0,  1,       1.0,    0.0,      0.0,   0.0 },
+	  { -1, -1,  0,  2,  1,       1.0,    0.0,      0.0,   0.0 },
+	  {  0,  0, -2,  0,  1,      -1.0,    0.0,      0.0,   0.0 },
+	  {  0,  0,  2, -1,  2,      -1.0,    0.0,      0.0,   0.0 },
+	  {  0,  1,  0,  2,  0,      -1.0,    0.0,      0.0,   0.0 },
+	  {  1,  0, -2, -2,  0,      -1.0,    0.0,      0.0,   0.0 },
+	  {  0, -1,  2,  0,  1,      -1.0,    0.0,      0.0,   0.0 },
+	  {  1,  1,  0, -2,  1,      -1.0,    0.0,      0.0,   0.0 },
+	  {  1,  0, -2,  2,  0,      -1.0,    0.0,      0.0,   0.0 },
+	  {  2,  0,  0,  2,  0,       1.0,    0.0,      0.0,   0.0 },
+	  {  0,  0,  2,  4,  2,      -1.0,    0.0,      0.0,   0.0 },
+	  {  0,  1,  0,  1,  0,       1.0,    0.0,      0.0,   0.0 }
+	};
+	const size_t n_terms = sizeof(terms) / sizeof(terms[0]);
+
+	double el = argument(t, 485866.733, 715922.633, 31.310, 0.064, 1325.0);
+	double elp = argument(t, 1287099.804, 1292581.224, -0.577, -0.012, 99.0);
+	double f = argument(t, 335778.877, 295263.137, -13.257, 0.011, 1342.0);
+	double d = argument(t, 1072261.307, 1105601.328, -6.891, 0.019, 1236.0);
+	omega = argument(t, 450160.280, -482890.539, 7.455, 0.008, -5.0);
+
+	// Smallest terms first
+	double dp = 0.0;
+	double de = 0.0;
+	for (size_t i = n_terms; i-- > 0; ) {
+	  const nutation_term &term = terms[i];
+	  double arg = term.nl * el + term.nlp * elp + term.nf * f + term.nd * d + term.nom * omega;
+	  dp += (term.sp + term.spt * t) * sin(arg);
+	  de += (term.ce + term.cet * t) * cos(arg);
+	}
+	dpsi = dp * 1e-4 * arcsec;
+	deps = de * 1e-4 * arcsec;
+      }
+
+    public:
+      explicit precession_nutation(const double &at_time, const earth_orientation &eop = earth_orientation())
+      {
+	FR_COORDINATES_COUNT(instrument_precession_nutation_built);
+	double t = centuries(at_time + eop.tt_offset);
+	zeta = (2306.2181 + (0.30188 + 0.017998 * t) * t) * t * arcsec;
+	theta = (2004.3109 + (-0.42665 - 0.041833 * t) * t) * t * arcsec;
+	z = (2306.2181 + (1.09468 + 0.018203 * t) * t) * t * arcsec;
+	mean_obliquity = (84381.448 + (-46.8150 + (-0.00059 + 0.001813 * t) * t) * t) * arcsec;
+	double omega;
+	nutate(t, omega);
+	dpsi += eop.ddpsi * arcsec;
+	deps += eop.ddeps * arcsec;
+	eqe = dpsi * cos(mean_obliquity);
+	// The 1994 terms in the node, in effect from 1997 February 27
+	if (at_time >= 857001600.0) {
+	  eqe += (0.00264 * sin(omega) + 0.000063 * sin(2.0 * omega)) * arcsec;
+	}
+      }
+
+      // Angles, in radians
+      double get_dpsi() const { return dpsi; }
+      double get_deps() const { return deps; }
+      double get_mean_obliquity() const { return mean_obliquity; }
+      double get_equation_of_equinoxes() const { return eqe; }
+
+      // J2000 to mean of date
+      Eigen::Matrix3d get_precession() const
+      {
+	return frame_rotation_z(-z) * frame_rotation_y(theta) * frame_rotation_z(-zeta);
+      }
+
+      // Mean of date to true of date
+      Eigen::Matrix3d get_nutation() const
+      {
+	return frame_rotation_x(-(mean_obliquity + deps)) * frame_rotation_z(-dpsi) * frame_rotation_x(mean_obliquity);
+      }
+
+      // J2000 to true of date
+      Eigen::Matrix3d get() const
+      {
+	return get_nutation() * get_precession();
+      }
+
+    };
+
+    /**
+     * The whole chain at one epoch. Holds the rotation from each
+     * inertial frame to ECEF, so going between any two of ecef,
+     * tod_eci, j2000 and teme is at most two 3x3 multiplies. Pass one
+     * to the converters the way you would an eci_ecef_rotation.
+     */
+
+    class frame_rotation {
+      double at_time;
+      Eigen::Matrix3d teme_to_ecef;
+      Eigen::Matrix3d tod_to_ecef;
+      Eigen::Matrix3d j2000_to_ecef;
+      // And back, kept so the inverse rotations are plain products
+      Eigen::Matrix3d ecef_to_teme;
+      Eigen::Matrix3d ecef_to_tod;
+      Eigen::Matrix3d ecef_to_j2000;
+
+      void build(const Eigen::Matrix3d &j2000_to_tod, double gmst, double eqe, const Eigen::Matrix3d &pef_to_ecef)
+      {
+	teme_to_ecef = pef_to_ecef * frame_rotation_z(gmst);
+	tod_to_ecef = pef_to_ecef * frame_rotation_z(gmst + eqe);
+	j2000_to_ecef = tod_to_ecef * j2000_to_tod;
+	ecef_to_teme = teme_to_ecef.transpose();
+	ecef_to_tod = tod_to_ecef.transpose();
+	ecef_to_j2000 = j2000_to_ecef.transpose();
+      }
+
+    public:
+      explicit frame_rotation(const double &at_time, const earth_orientation &eop = earth_orientation()) : at_time(at_time)
+      {
+	precession_nutation pn(at_time, eop);
+	build(pn.get(), gmst(at_time), pn.get_equation_of_equinoxes(), polar_motion(eop));
+      }
+
+      // From parts already worked out, which is how frame_chain makes them
+      frame_rotation(const double &at_time, const Eigen::Matrix3d &j2000_to_tod, double gmst, double eqe, const Eigen::Matrix3d &pef_to_ecef) : at_time(at_time)
+      {
+	build(j2000_to_tod, gmst, eqe, pef_to_ecef);
+      }
+
+      // Greenwich mean sidereal time in radians, the same angle
+      // eci_to_ecef uses
+      static double gmst(const double &at_time)
+      {
+	FR_COORDINATES_COUNT(instrument_gmst_evaluations);
+	fr::time::gmst time_gmst(at_time);
+	return time_gmst.get_gmst() * 2.0 * fr::constants::pi / fr::constants::secs_per_ut1_day;
+      }
+
+      // Pseudo earth fixed to ECEF (ITRF)
+      static Eigen::Matrix3d polar_motion(const earth_orientation &eop)
+      {
+	const double arcsec = fr::constants::pi / (180.0 * 3600.0);
+	return (frame_rotation_x(eop.yp * arcsec) * frame_rotation_y(eop.xp * arcsec)).transpose();
+      }
+
+      double get_time() const
+      {
+	return at_time;
+      }
+
+      // Rotation from each frame to ECEF
+
+      const Eigen::Matrix3d &to_ecef(ecef_frame) const
+      {
+	static const Eigen::Matrix3d identity = Eigen::Matrix3d::Identity();
+	return identity;
+      }
+
+      const Eigen::Matrix3d &to_ecef(tod_eci_frame) const { return tod_to_ecef; }
+      const Eigen::Matrix3d &to_ecef(teme_frame) const { return teme_to_ecef; }
+      const Eigen::Matrix3d &to_ecef(j2000_frame) const { return j2000_to_ecef; }
+
+      // And from ECEF to each frame
+
+      const Eigen::Matrix3d &from_ecef(ecef_frame) const
+      {
+	return to_ecef(ecef_frame());
+      }
+
+      const Eigen::Matrix3d &from_ecef(tod_eci_frame) const { return ecef_to_tod; }
+      const Eigen::Matrix3d &from_ecef(teme_frame) const { return ecef_to_teme; }
+      const Eigen::Matrix3d &from_ecef(j2000_frame) const { return ecef_to_j2000; }
+
+      // Rotation from one frame to another
+      template <typename from, typename to>
+      Eigen::Matrix3d get() const
+      {
+	return from_ecef(to()) * to_ecef(from());
+      }
+
+      template <typename from, typename to, typename Derived>
+      Eigen::Vector3d rotate(const Eigen::MatrixBase<Derived> &v) const
+      {
+	Eigen::Vector3d retval;
+	rotate<from, to>(v, retval);
+	return retval;
+      }
+
+      // Same, writing into out, which can be a Map over the caller's
+      // storage such as a point's map_xyz(). out must not alias v.
+      template <typename from, typename to, typename Derived, typename Out>
+      void rotate(const Eigen::MatrixBase<Derived> &v, const Eigen::MatrixBase<Out> &out) const
+      {
+	rotate(from(), to(), v, const_cast<Eigen::MatrixBase<Out> &>(out));
+      }
+
+    private:
+
+      // Skip the identity when one end is ECEF, which is most calls
+
+      template <typename from, typename to, typename Derived, typename Out>
+      void rotate(from, to, const Eigen::MatrixBase<Derived> &v, Eigen::MatrixBase<Out> &out) const
+      {
+	out.noalias() = from_ecef(to()) * (to_ecef(from()) * v);
+      }
+
+      template <typename from, typename Derived, typename Out>
+      void rotate(from, ecef_frame, const Eigen::MatrixBase<Derived> &v, Eigen::MatrixBase<Out> &out) const
+      {
+	out.noalias() = to_ecef(from()) * v;
+      }
+
+      template <typename to, typename Derived, typename Out>
+      void rotate(ecef_frame, to, const Eigen::MatrixBase<Derived> &v, Eigen::MatrixBase<Out> &out) const
+      {
+	out.noalias() = from_ecef(to()) * v;
+      }
+
+      template <typename Derived, typename Out>
+      void rotate(ecef_frame, ecef_frame, const Eigen::MatrixBase<Derived> &v, Eigen::MatrixBase<Out> &out) const
+      {
+	out = v;
+      }
+
+    };
+
+    /**
+     * frame_rotations for lots of times that are close together.
+     * Evaluates precession and nutation at anchor epochs every step
+     * seconds and interpolates the J2000 to true of date matrix and the
+     * equation of the equinoxes linearly in between, with sidereal time
+     * from a gha_interpolator on the same anchors. The error is
+     * quadratic in the step and comes almost all from the half monthly
+     * nutation terms; at the default hour the precession and nutation
+     * part is under 1e-10 radians. Sidereal time dominates end to end:
+     * the GMST evaluations behind the gha_interpolator carry a few times
+     * 1e-9 radians of rounding, so a chain rotation matches a fresh
+     * frame_rotation to about 1e-8 radians, 7 centimeters in low orbit.
+     * Moving on to the next segment reuses the anchor the two share, so
+     * a sorted run of times evaluates the series once per step instead
+     * of once per point.
+     *
+     * A NaN or infinite time throws std::invalid_argument. Not thread
+     * safe. Give each thread its own chain.
+     */
+
+    class frame_chain {
+      earth_orientation eop;
+      Eigen::Matrix3d pef_to_ecef;
+      double step;
+      double t0;
+      Eigen::Matrix3d pn0;
+      Eigen::Matrix3d pn1;
+      double eqe0;
+      double eqe1;
+      bool valid;
+      size_t evaluations;
+      gha_interpolator gha;
+
+      void anchor(double t, Eigen::Matrix3d &pn, double &eqe)
+      {
+	precession_nutation p(t, eop);
+	pn = p.get();
+	eqe = p.get_equation_of_equinoxes();
+	++evaluations;
+      }
+
+    public:
+      frame_chain(const earth_orientation &eop = earth_orientation(), double step = 3600.0) : eop(eop), pef_to_ecef(frame_rotation::polar_motion(eop)), step(step), t0(0.0), eqe0(0.0), eqe1(0.0), valid(false), evaluations(0), gha(step)
+      {
+      }
+
+      frame_rotation operator()(const double &at_time)
+      {
+	FR_COORDINATES_COUNT(instrument_frame_chain_interpolations);
+	// Written so a NaN falls through to the check below
+	if (!valid || !(at_time >= t0 && at_time < t0 + step)) {
+	  if (!std::isfinite(at_time)) {
+	    throw std::invalid_argument("frame_chain time must be finite");
+	  }
+	  double start = floor(at_time / step) * step;
+	  if (valid && start == t0 + step) {
+	    pn0 = pn1;
+	    eqe0 = eqe1;
+	    anchor(start + step, pn1, eqe1);
+	  } else if (valid && start == t0 - step) {
+	    pn1 = pn0;
+	    eqe1 = eqe0;
+	    anchor(start, pn0, eqe0);
+	  } else {
+	    anchor(start, pn0, eqe0);
+	    anchor(start + step, pn1, eqe1);
+	  }
+	  t0 = start;
+	  valid = true;
+	}
+	double f = (at_time - t0) / step;
+	return frame_rotation(at_time, pn0 + f * (pn1 - pn0), gha(at_time), eqe0 + f * (eqe1 - eqe0), pef_to_ecef);
+      }
+
+      const earth_orientation &get_earth_orientation() const
+      {
+	return eop;
+      }
+
+      // How many times the series has been evaluated
+      size_t get_evaluations() const
+      {
+	return evaluations;
+      }
+
+    };
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,404 @@
+/**
+ * Opt in counters and histograms for what the library is doing:
+ * converter calls by destination type, batch conversions and their
+ * sizes, iterative_solver iterations, GMST evaluations, rotation
+ * contexts built and interpolator calls.
+ *
+ * Build with -DFR_COORDINATES_INSTRUMENT to turn them on. Without it
+ * the FR_COORDINATES_COUNT and FR_COORDINATES_RECORD macros the library
+ * uses expand to nothing, and snapshots are all zeros. The converters
+ * are inline, so define it the same way in every file linked together.
+ *
+ * Each thread counts into its own block with plain relaxed loads and
+ * stores, so there are no locked instructions or shared cache lines on
+ * the hot paths. instrumentation::snapshot() adds up every live
+ * thread's block plus the totals from threads that have exited.
+ * Counts only ever go up. Subtract an earlier snapshot to get a rate,
+ * the way you would with any other monotonic counter:
+ *
+ *   instrumentation_snapshot before = instrumentation::snapshot();
+ *   ...
+ *   instrumentation_snapshot used = instrumentation::snapshot() - before;
+ *   used.write(std::cout);
+ *
+ * write() produces Prometheus text format, with each histogram as
+ * cumulative buckets plus a _sum and a _count.
+ *
+ * Counts made by the vectorized batch kernels are per call, not per
+ * point, so the loops stay the same with instrumentation on.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_INSTRUMENTATION
+#define _HPP_INSTRUMENTATION
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#ifdef FR_COORDINATES_INSTRUMENT
+#define FR_COORDINATES_COUNT(counter) ::fr::coordinates::instrumentation::count(::fr::coordinates::counter)
+#define FR_COORDINATES_COUNT_N(counter, n) ::fr::coordinates::instrumentation::count(::fr::coordinates::counter, (n))
+#define FR_COORDINATES_RECORD(histogram, value) ::fr::coordinates::instrumentation::record(::fr::coordinates::histogram, (value))
+#define FR_COORDINATES_BATCH(count) ::fr::coordinates::instrumentation::batch(count)
+#else
+#define FR_COORDINATES_COUNT(counter) do { } while (0)
+#define FR_COORDINATES_COUNT_N(counter, n) do { } while (0)
+#define FR_COORDINATES_RECORD(histogram, value) do { } while (0)
+#define FR_COORDINATES_BATCH(count) do { } while (0)
+#endif
+
+namespace fr {
+
+  namespace coordinates {
+
+    enum instrument_counter {
+      // converter<> calls by destination type. Converters that go
+      // through another type count both.
+      instrument_to_lat_long,
+      instrument_to_ecef,
+      instrument_to_tod_eci,
+      instrument_to_ecef_vel,
+      instrument_to_tod_eci_vel,
+      instrument_to_ecef_point,
+      instrument_to_tod_eci_point,
+      instrument_to_ecef_vel_point,
+      instrument_to_tod_eci_vel_point,
+      instrument_to_local_point,	// enu_point and ned_point
+      instrument_to_inertial_point,	// j2000_point and teme_point
+      // batch_converter<> calls and the points they converted
+      instrument_batch_calls,
+      instrument_batch_points,
+      instrument_geodetic_solves,	// iterative_solver calls
+      instrument_gmst_evaluations,
+      instrument_eci_to_ecef_built,
+      instrument_eci_ecef_rotation_built,
+      instrument_precession_nutation_built,
+      instrument_gha_interpolations,
+      instrument_frame_chain_interpolations,
+      instrument_segment_interpolations,	// interpolator.hpp segments
+      instrument_counter_count
+    };
+
+    enum instrument_histogram {
+      instrument_solver_iterations,	// per iterative_solver call
+      instrument_batch_size,		// points per batch_converter<> call
+      instrument_histogram_count
+    };
+
+    // Bucket i of solver_iterations holds values up to i, bucket i of
+    // batch_size values up to 2^i. The last bucket takes the rest.
+    const size_t instrument_buckets = 32;
+
+    struct instrumentation_snapshot {
+      uint64_t counters[instrument_counter_count];
+      uint64_t buckets[instrument_histogram_count][instrument_buckets];
+      uint64_t sums[instrument_histogram_count];
+
+      instrumentation_snapshot()
+      {
+	std::fill(counters, counters + instrument_counter_count, 0);
+	std::fill(&buckets[0][0], &buckets[0][0] + instrument_histogram_count * instrument_buckets, 0);
+	std::fill(sums, sums + instrument_histogram_count, 0);
+      }
+
+      uint64_t get(instrument_counter c) const
+      {
+	return counters[c];
+      }
+
+      // Number of values recorded in a histogram
+      uint64_t get_count(instrument_histogram h) const
+      {
+	uint64_t retval = 0;
+	for (size_t i = 0; i < instrument_buckets; ++i) {
+	  retval += buckets[h][i];
+	}
+	return retval;
+      }
+
+      uint64_t get_sum(instrument_histogram h) const
+      {
+	return sums[h];
+      }
+
+      // Upper bound of a bucket, the last one has none
+      static uint64_t bucket_limit(instrument_histogram h, size_t bucket)
+      {
+	return (h == instrument_solver_iterations) ? bucket : (uint64_t(1) << bucket);
+      }
+
+      static size_t bucket_for(instrument_histogram h, uint64_t value)
+      {
+	size_t bucket = 0;
+	if (h == instrument_solver_iterations) {
+	  bucket = (size_t) std::min(value, (uint64_t) instrument_buckets - 1);
+	} else if (value > 1) {
+	  // Smallest i with 2^i >= value
+	  bucket = 64 - __builtin_clzll(value - 1);
+	}
+	return std::min(bucket, instrument_buckets - 1);
+      }
+
+      static const char *name(instrument_counter c)
+      {
+	static const char *names[instrument_counter_count] = {
+	  "to_lat_long",
+	  "to_ecef",
+	  "to_tod_eci",
+	  "to_ecef_vel",
+	  "to_tod_eci_vel",
+	  "to_ecef_point",
+	  "to_tod_eci_point",
+	  "to_ecef_vel_point",
+	  "to_tod_eci_vel_point",
+	  "to_local_point",
+	  "to_inertial_point",
+	  "batch_calls",
+	  "batch_points",
+	  "geodetic_solves",
+	  "gmst_evaluations",
+	  "eci_to_ecef_built",
+	  "eci_ecef_rotation_built",
+	  "precession_nutation_built",
+	  "gha_interpolations",
+	  "frame_chain_interpolations",
+	  "segment_interpolations"
+	};
+	return names[c];
+      }
+
+      static const char *name(instrument_histogram h)
+      {
+	static const char *names[instrument_histogram_count] = {
+	  "solver_iterations",
+	  "batch_size"
+	};
+	return names[h];
+      }
+
+      instrumentation_snapshot &operator+=(const instrumentation_snapshot &other)
+      {
+	for (size_t i = 0; i < instrument_counter_count; ++i) {
+	  counters[i] += other.counters[i];
+	}
+	for (size_t h = 0; h < instrument_histogram_count; ++h) {
+	  for (size_t i = 0; i < instrument_buckets; ++i) {
+	    buckets[h][i] += other.buckets[h][i];
+	  }
+	  sums[h] += other.sums[h];
+	}
+	return *this;
+      }
+
+      // What happened between an earlier snapshot and this one
+      instrumentation_snapshot operator-(const instrumentation_snapshot &earlier) const
+      {
+	instrumentation_snapshot retval(*this);
+	for (size_t i = 0; i < instrument_counter_count; ++i) {
+	  retval.counters[i] -= earlier.counters[i];
+	}
+	for (size_t h = 0; h < instrument_histogram_count; ++h) {
+	  for (size_t i = 0; i < instrument_buckets; ++i) {
+	    retval.buckets[h][i] -= earlier.buckets[h][i];
+	  }
+	  retval.sums[h] -= earlier.sums[h];
+	}
+	return retval;
+      }
+
+      // Prometheus text format, every name prefixed with fr_coordinates_
+      void write(std::ostream &out) const
+      {
+	for (size_t i = 0; i < instrument_counter_count; ++i) {
+	  out << "# TYPE fr_coordinates_" << name((instrument_counter) i) << " counter\n";
+	  out << "fr_coordinates_" << name((instrument_counter) i) << " " << counters[i] << "\n";
+	}
+	for (size_t h = 0; h < instrument_histogram_count; ++h) {
+	  const char *n = name((instrument_histogram) h);
+	  uint64_t cumulative = 0;
+	  out << "# TYPE fr_coordinates_" << n << " histogram\n";
+	  for (size_t i = 0; i + 1 < instrument_buckets; ++i) {
+	    cumulative += buckets[h][i];
+	    out << "fr_coordinates_" << n << "_bucket{le=\"" << bucket_limit((instrument_histogram) h, i) << "\"} " << cumulative << "\n";
+	  }
+	  cumulative += buckets[h][instrument_buckets - 1];
+	  out << "fr_coordinates_" << n << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+	  out << "fr_coordinates_" << n << "_sum " << sums[h] << "\n";
+	  out << "fr_coordinates_" << n << "_count " << cumulative << "\n";
+	}
+      }
+
+    };
+
+    class instrumentation {
+
+      // One thread's counts. Only the owning thread writes them, the
+      // atomics are so snapshot() can read them from another thread.
+      struct block {
+	std::atomic<uint64_t> counters[instrument_counter_count];
+	std::atomic<uint64_t> buckets[instrument_histogram_count][instrument_buckets];
+	std::atomic<uint64_t> sums[instrument_histogram_count];
+
+	explicit block(bool registered = true);
+	~block();
+
+	void add_to(instrumentation_snapshot &s) const
+	{
+	  for (size_t i = 0; i < instrument_counter_count; ++i) {
+	    s.counters[i] += counters[i].load(std::memory_order_relaxed);
+	  }
+	  for (size_t h = 0; h < instrument_histogram_count; ++h) {
+	    for (size_t i = 0; i < instrument_buckets; ++i) {
+	      s.buckets[h][i] += buckets[h][i].load(std::memory_order_relaxed);
+	    }
+	    s.sums[h] += sums[h].load(std::memory_order_relaxed);
+	  }
+	}
+      };
+
+      struct registry {
+	std::mutex lock;
+	std::vector<const block *> live;
+	instrumentation_snapshot retired;
+      };
+
+      // Never destroyed, so threads that exit after main returns can
+      // still retire their blocks
+      static registry &get_registry()
+      {
+	static registry *r = new registry;
+	return *r;
+      }
+
+      // The thread's block. The pointer is trivially initialized so
+      // the hot path doesn't go through the thread_local init guard.
+      static block *&current()
+      {
+	static thread_local block *b = nullptr;
+	return b;
+      }
+
+      static block &local()
+      {
+	block *b = current();
+	if (__builtin_expect(b == nullptr, 0)) {
+	  static thread_local block owned;
+	  b = current() = &owned;
+	}
+	return *b;
+      }
+
+      // Takes counts made by thread_local destructors that run after
+      // the thread's block has been retired. They're dropped.
+      static block &discarded()
+      {
+	static block *d = new block(false);
+	return *d;
+      }
+
+      static void bump(std::atomic<uint64_t> &a, uint64_t n)
+      {
+	a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      }
+
+    public:
+
+      // Whether the library was built with FR_COORDINATES_INSTRUMENT
+      static bool enabled()
+      {
+#ifdef FR_COORDINATES_INSTRUMENT
+	return true;
+#else
+	return false;
+#endif
+      }
+
+      // Use the macros instead, so these compile out
+      static void count(instrument_counter c, uint64_t n = 1)
+      {
+	bump(local().counters[c], n);
+      }
+
+      static void record(instrument_histogram h, uint64_t value)
+      {
+	block &b = local();
+	bump(b.buckets[h][instrumentation_snapshot::bucket_for(h, value)], 1);
+	bump(b.sums[h], value);
+      }
+
+      // One batch_converter<> call
+      static void batch(uint64_t points)
+      {
+	block &b = local();
+	bump(b.counters[instrument_batch_calls], 1);
+	bump(b.counters[instrument_batch_points], points);
+	bump(b.buckets[instrument_batch_size][instrumentation_snapshot::bucket_for(instrument_batch_size, points)], 1);
+	bump(b.sums[instrument_batch_size], points);
+      }
+
+      // Totals over every thread so far
+      static instrumentation_snapshot snapshot()
+      {
+	registry &r = get_registry();
+	std::lock_guard<std::mutex> hold(r.lock);
+	instrumentation_snapshot retval(r.retired);
+	for (size_t i = 0; i < r.live.size(); ++i) {
+	  r.live[i]->add_to(retval);
+	}
+	return retval;
+      }
+
+    };
+
+    inline instrumentation::block::block(bool registered)
+    {
+      for (size_t i = 0; i < instrument_counter_count; ++i) {
+	counters[i].store(0, std::memory_order_relaxed);
+      }
+      for (size_t h = 0; h < instrument_histogram_count; ++h) {
+	for (size_t i = 0; i < instrument_buckets; ++i) {
+	  buckets[h][i].store(0, std::memory_order_relaxed);
+	}
+	sums[h].store(0, std::memory_order_relaxed);
+      }
+      if (!registered) {
+	return;
+      }
+      registry &r = get_registry();
+      std::lock_guard<std::mutex> hold(r.lock);
+      r.live.push_back(this);
+    }
+
+    // Folds the thread's counts into the retired totals
+    inline instrumentation::block::~block()
+    {
+      registry &r = get_registry();
+      std::lock_guard<std::mutex> hold(r.lock);
+      add_to(r.retired);
+      r.live.erase(std::find(r.live.begin(), r.live.end(), this));
+      current() = &discarded();
+    }
+
+  }
+
+}
+
+#endif
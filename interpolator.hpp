@@ -0,0 +1,278 @@
+/**
+ * Precomputed interpolation over one segment of a trajectory, for
+ * sampling the same pair of points at lots of times.
+ *
+ * interpolate_3x3 in xyz_coordinate rotates the first vector toward the
+ * second with a quaternion built from scratch on every call. The axis
+ * and total angle only depend on the two endpoints, and the rotation
+ * reduces to
+ *
+ *   p(a) = r(a) * (u cos(a theta) + w sin(a theta))
+ *
+ * where a is the fraction of the way through the segment, u the unit
+ * vector of the first point, w the unit vector perpendicular to it in
+ * the plane of both points, theta the angle between them and r the
+ * linearly interpolated length. slerp_segment works those out once, so
+ * each query is a sin, a cos and a few multiplies. Results match
+ * interpolate_3x3 to rounding.
+ *
+ * tod_eci_vel_hermite_segment interpolates with a cubic Hermite curve
+ * through both endpoints' positions and velocities instead.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_INTERPOLATOR
+#define _HPP_INTERPOLATOR
+
+#include "constants.hpp"
+#include "instrumentation.hpp"
+#include "tod_eci.hpp"
+#include "tod_eci_vel.hpp"
+#include "xyz_point.hpp"
+#include <Eigen/Core>
+#include <cmath>
+#include <cstddef>
+
+namespace fr {
+
+  namespace coordinates {
+
+    class slerp_segment {
+      double t0;
+      double inv_dt;
+      double theta;
+      double r0;
+      double dr;
+      Eigen::Vector3d u;
+      Eigen::Vector3d w;
+
+    public:
+
+      slerp_segment() : t0(0.0), inv_dt(0.0), theta(0.0), r0(0.0), dr(0.0), u(Eigen::Vector3d::Zero()), w(Eigen::Vector3d::Zero())
+      {
+      }
+
+      slerp_segment(const Eigen::Vector3d &from, const double &time_from, const Eigen::Vector3d &to, const double &time_to) : t0(time_from), inv_dt(1.0 / (time_to - time_from))
+      {
+	r0 = from.norm();
+	double r1 = to.norm();
+	dr = r1 - r0;
+	u = from / r0;
+	Eigen::Vector3d to_uv = to / r1;
+	double c = u.dot(to_uv);
+	theta = acos(c > 1.0 ? 1.0 : (c < -1.0 ? -1.0 : c));
+	// Component of the second point perpendicular to the first. If
+	// they're parallel there's no rotation and w doesn't matter.
+	Eigen::Vector3d perpendicular = to_uv - c * u;
+	double perpendicular_norm = perpendicular.norm();
+	if (perpendicular_norm > 0.0) {
+	  w = perpendicular / perpendicular_norm;
+	} else {
+	  w = Eigen::Vector3d::Zero();
+	}
+      }
+
+      Eigen::Vector3d operator()(const double &at_time) const
+      {
+	double a = (at_time - t0) * inv_dt;
+	double phi = theta * a;
+	double r = r0 + dr * a;
+	return r * (u * cos(phi) + w * sin(phi));
+      }
+
+      /**
+       * Interpolates at count times. Results are written as x, y, z
+       * triples, stride doubles apart, so this can fill the position or
+       * the velocity half of an array of points from xyz_point.hpp.
+       */
+
+      void operator()(const double * __restrict__ times, double * __restrict__ out, size_t stride, size_t count) const
+      {
+	const double half_pi = fr::constants::pi / 2.0;
+	const double ux = u(0), uy = u(1), uz = u(2);
+	const double wx = w(0), wy = w(1), wz = w(2);
+	for (size_t i = 0; i < count; ++i) {
+	  double a = (times[i] - t0) * inv_dt;
+	  double phi = theta * a;
+	  double r = r0 + dr * a;
+	  double c = r * sin(phi + half_pi);
+	  double s = r * sin(phi);
+	  out[i * stride] = ux * c + wx * s;
+	  out[i * stride + 1] = uy * c + wy * s;
+	  out[i * stride + 2] = uz * c + wz * s;
+	}
+      }
+
+    };
+
+    /**
+     * One segment of a position only trajectory
+     */
+
+    class tod_eci_segment {
+      slerp_segment position;
+
+    public:
+
+      tod_eci_segment()
+      {
+      }
+
+      tod_eci_segment(const tod_eci &now, const double &time_now, const tod_eci &next, const double &time_then) : position(now.get_xyz(), time_now, next.get_xyz(), time_then)
+      {
+      }
+
+      tod_eci_segment(const tod_eci_point &now, const double &time_now, const tod_eci_point &next, const double &time_then) : position(now.get_xyz(), time_now, next.get_xyz(), time_then)
+      {
+      }
+
+      tod_eci interpolate(const double &time_between) const
+      {
+	FR_COORDINATES_COUNT(instrument_segment_interpolations);
+	Eigen::Vector3d p = position(time_between);
+	return tod_eci(p(0), p(1), p(2));
+      }
+
+      void interpolate(const double *times, tod_eci_point *out, size_t count) const
+      {
+	FR_COORDINATES_COUNT_N(instrument_segment_interpolations, count);
+	position(times, &out->x, 3, count);
+      }
+
+    };
+
+    /**
+     * One segment of a position and velocity trajectory. Position and
+     * velocity are interpolated independently, the same way
+     * tod_eci_vel::interpolate does it.
+     */
+
+    class tod_eci_vel_segment {
+      slerp_segment position;
+      slerp_segment velocity;
+
+    public:
+
+      tod_eci_vel_segment()
+      {
+      }
+
+      tod_eci_vel_segment(const tod_eci_vel &now, const double &time_now, const tod_eci_vel &next, const double &time_then) : position(now.get_xyz(), time_now, next.get_xyz(), time_then), velocity(now.get_deltas(), time_now, next.get_deltas(), time_then)
+      {
+      }
+
+      tod_eci_vel_segment(const tod_eci_vel_point &now, const double &time_now, const tod_eci_vel_point &next, const double &time_then) : position(now.get_xyz(), time_now, next.get_xyz(), time_then), velocity(now.get_deltas(), time_now, next.get_deltas(), time_then)
+      {
+      }
+
+      tod_eci_vel interpolate(const double &time_between) const
+      {
+	FR_COORDINATES_COUNT(instrument_segment_interpolations);
+	Eigen::Vector3d p = position(time_between);
+	Eigen::Vector3d v = velocity(time_between);
+	return tod_eci_vel(p(0), p(1), p(2), v(0), v(1), v(2));
+      }
+
+      void interpolate(const double *times, tod_eci_vel_point *out, size_t count) const
+      {
+	FR_COORDINATES_COUNT_N(instrument_segment_interpolations, count);
+	position(times, &out->x, 6, count);
+	velocity(times, &out->dx, 6, count);
+      }
+
+    };
+
+    /**
+     * Cubic Hermite interpolation over one segment of a position and
+     * velocity trajectory. Unlike tod_eci_vel_segment this uses the
+     * velocities at both ends to shape the position curve, and the
+     * velocity comes from the derivative of that curve, so position
+     * and velocity are consistent with each other. On orbits with any
+     * eccentricity it's far more accurate for the same sample spacing;
+     * see test/interpolator_test.cpp for numbers.
+     *
+     * The cubic is stored as polynomial coefficients in the fraction of
+     * the segment s, p(s) = c0 + c1 s + c2 s^2 + c3 s^3, so each query
+     * is a few multiply-adds per component.
+     */
+
+    class tod_eci_vel_hermite_segment {
+      double t0;
+      double dt;
+      double inv_dt;
+      double c[4][3];
+
+      void setup(const Eigen::Vector3d &p0, const Eigen::Vector3d &v0, const Eigen::Vector3d &p1, const Eigen::Vector3d &v1)
+      {
+	Eigen::Vector3d m0 = v0 * dt;
+	Eigen::Vector3d m1 = v1 * dt;
+	for (int k = 0; k < 3; ++k) {
+	  c[0][k] = p0(k);
+	  c[1][k] = m0(k);
+	  c[2][k] = 3.0 * (p1(k) - p0(k)) - 2.0 * m0(k) - m1(k);
+	  c[3][k] = 2.0 * (p0(k) - p1(k)) + m0(k) + m1(k);
+	}
+      }
+
+    public:
+
+      tod_eci_vel_hermite_segment() : t0(0.0), dt(0.0), inv_dt(0.0), c()
+      {
+      }
+
+      tod_eci_vel_hermite_segment(const tod_eci_vel &now, const double &time_now, const tod_eci_vel &next, const double &time_then) : t0(time_now), dt(time_then - time_now), inv_dt(1.0 / (time_then - time_now))
+      {
+	setup(now.get_xyz(), now.get_deltas(), next.get_xyz(), next.get_deltas());
+      }
+
+      tod_eci_vel_hermite_segment(const tod_eci_vel_point &now, const double &time_now, const tod_eci_vel_point &next, const double &time_then) : t0(time_now), dt(time_then - time_now), inv_dt(1.0 / (time_then - time_now))
+      {
+	setup(now.get_xyz(), now.get_deltas(), next.get_xyz(), next.get_deltas());
+      }
+
+      tod_eci_vel interpolate(const double &time_between) const
+      {
+	tod_eci_vel_point p;
+	interpolate(&time_between, &p, 1);
+	return tod_eci_vel(p.x, p.y, p.z, p.dx, p.dy, p.dz);
+      }
+
+      void interpolate(const double * __restrict__ times, tod_eci_vel_point * __restrict__ out, size_t count) const
+      {
+	FR_COORDINATES_COUNT_N(instrument_segment_interpolations, count);
+	for (size_t i = 0; i < count; ++i) {
+	  double s = (times[i] - t0) * inv_dt;
+	  double p[3], v[3];
+	  for (int k = 0; k < 3; ++k) {
+	    p[k] = ((c[3][k] * s + c[2][k]) * s + c[1][k]) * s + c[0][k];
+	    v[k] = ((3.0 * c[3][k] * s + 2.0 * c[2][k]) * s + c[1][k]) * inv_dt;
+	  }
+	  out[i].x = p[0];
+	  out[i].y = p[1];
+	  out[i].z = p[2];
+	  out[i].dx = v[0];
+	  out[i].dy = v[1];
+	  out[i].dz = v[2];
+	}
+      }
+
+    };
+
+  }
+
+}
+
+#endif
@@ -36,17 +36,14 @@ namespace fr {
       {
       }
 
-      lat_long(const lat_long &copy) : latitude(copy.latitude), longitude(copy.longitude), altitude(copy.altitude)
-      {
-      }
+      // Defaulted so lat_long stays trivially copyable
+      lat_long(const lat_long &copy) = default;
 
       lat_long() : latitude(0.0), longitude(0.0), altitude(0.0)
       {
       }
 
-      ~lat_long()
-      {
-      }
+      ~lat_long() = default;
 
       // I'm still trying to get over the java-ism of making accessors
       // for everything, but I want my coordinate classes to be const
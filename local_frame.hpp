@@ -0,0 +1,136 @@
+/**
+ * Local tangent plane frames. A local_frame is pinned to an origin on
+ * or above the ellipsoid and keeps the origin's ECEF position and the
+ * rotations from ECEF into East-North-Up and North-East-Down, so
+ * converting a point is one subtraction and one 3x3 multiply. The
+ * conversions themselves are in converts.hpp and batch_converts.hpp;
+ * pass the frame wherever you'd pass a rotation context for tod_eci.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#ifndef _HPP_LOCAL_FRAME
+#define _HPP_LOCAL_FRAME
+
+#include "constants.hpp"
+#include "ellipsoid.hpp"
+#include "geodetic_solvers.hpp"
+#include "lat_long.hpp"
+#include "xyz_point.hpp"
+#include <Eigen/Core>
+#include <cmath>
+#include <type_traits>
+
+namespace fr {
+
+  namespace coordinates {
+
+    // Frame tags. x, y, z are east, north, up for enu_point and
+    // north, east, down for ned_point, in meters from the frame origin.
+    struct enu_frame {
+    };
+
+    struct ned_frame {
+    };
+
+    typedef xyz_point<enu_frame> enu_point;
+    typedef xyz_point<ned_frame> ned_point;
+    typedef xyz_point<enu_frame, float> enu_point_f;
+    typedef xyz_point<ned_frame, float> ned_point_f;
+
+    template <typename frame>
+    struct is_local_frame : std::integral_constant<bool, std::is_same<frame,enu_frame>::value || std::is_same<frame,ned_frame>::value> {
+    };
+
+    template <typename T>
+    struct is_local_position : std::integral_constant<bool, std::is_same<T,enu_point>::value || std::is_same<T,ned_point>::value> {
+    };
+
+    class local_frame {
+      lat_long origin_lat_long;
+      ecef_point origin;
+      ellipsoid_parameters e;
+      // ECEF to local. The inverse of each is its transpose.
+      Eigen::Matrix3d enu;
+      Eigen::Matrix3d ned;
+
+      void build()
+      {
+	const double to_rad = fr::constants::pi / 180.0;
+	double slat = sin(origin_lat_long.get_lat() * to_rad);
+	double clat = cos(origin_lat_long.get_lat() * to_rad);
+	double slon = sin(origin_lat_long.get_long() * to_rad);
+	double clon = cos(origin_lat_long.get_long() * to_rad);
+	enu << -slon, clon, 0.0,
+	  -slat * clon, -slat * slon, clat,
+	  clat * clon, clat * slon, slat;
+	ned.row(0) = enu.row(1);
+	ned.row(1) = enu.row(0);
+	ned.row(2) = -enu.row(2);
+      }
+
+    public:
+
+      // Origin given as latitude and longitude in degrees and altitude
+      // in meters above the ellipsoid
+      local_frame(const lat_long &at, const ellipsoid_parameters &e = WGS84_ELLIPSOID) : origin_lat_long(at), e(e)
+      {
+	geodetic_to_ecef(at.get_lat(), at.get_long(), at.get_alt(), e, origin.x, origin.y, origin.z);
+	build();
+      }
+
+      // Origin given in ECEF. The up axis is still the ellipsoid normal
+      // through the origin, not the direction from the earth's center.
+      local_frame(const ecef_point &at, const ellipsoid_parameters &e = WGS84_ELLIPSOID) : origin(at), e(e)
+      {
+	double lat, lon, alt;
+	vermeille_solver()(at.x, at.y, at.z, e, lat, lon, alt);
+	origin_lat_long = lat_long(lat, lon, alt);
+	build();
+      }
+
+      const ecef_point &get_origin() const { return origin; }
+      const lat_long &get_origin_lat_long() const { return origin_lat_long; }
+      const ellipsoid_parameters &get_ellipsoid() const { return e; }
+
+      // ECEF to local rotation for the frame tag
+      const Eigen::Matrix3d &get_rotation(enu_frame) const { return enu; }
+      const Eigen::Matrix3d &get_rotation(ned_frame) const { return ned; }
+
+      // Single point versions of the conversions, used by the converters
+      template <typename frame, typename Derived>
+      xyz_point<frame> to_local(const Eigen::MatrixBase<Derived> &ecef_xyz) const
+      {
+	xyz_point<frame> retval;
+	retval.map_xyz().noalias() = get_rotation(frame()) * (ecef_xyz - origin.map_xyz());
+	return retval;
+      }
+
+      template <typename frame>
+      ecef_point to_ecef(const xyz_point<frame> &p) const
+      {
+	ecef_point retval;
+	retval.map_xyz().noalias() = get_rotation(frame()).transpose() * p.map_xyz() + origin.map_xyz();
+	return retval;
+      }
+
+    };
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,435 @@
+/**
+ * Multithreaded front end for the batch converters. A thread_pool
+ * holds a set of worker threads, and parallel_converter<to_type>
+ * splits a batch into one contiguous slice per worker and runs the
+ * batch_converter for the same types on each slice. Use as
+ *
+ *   thread_pool pool;
+ *   parallel_converter<to_type> convert(pool);
+ *   convert(same arguments as batch_converter);
+ *
+ * Every point is converted by the same code the serial batch converters
+ * run, and slices start on multiples of slice_grain points, so the
+ * vectorized loops line up with the serial ones and the output is
+ * bit for bit the same as a serial run.
+ *
+ * The split only depends on the point count and the pool size, so
+ * worker n always gets the same slice of a buffer. On NUMA boxes,
+ * allocate output buffers without initializing them (or call
+ * first_touch on them) so each worker's slice lands in memory local to
+ * that worker.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_PARALLEL_CONVERTS
+#define _HPP_PARALLEL_CONVERTS
+
+#include "batch_converts.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fr {
+
+  namespace coordinates {
+
+    /**
+     * Fixed set of worker threads. run() calls a function once on each
+     * worker (the calling thread counts as worker 0) and waits for all
+     * of them to finish. If any of them throw, the first exception is
+     * rethrown from run().
+     */
+
+    class thread_pool {
+      std::vector<std::thread> workers;
+      std::mutex lock;
+      std::mutex run_lock;
+      std::condition_variable wake;
+      std::condition_variable done;
+      const std::function<void(size_t)> *job;
+      size_t generation;
+      size_t pending;
+      bool stopping;
+      std::exception_ptr error;
+
+      void record(std::exception_ptr e)
+      {
+	std::lock_guard<std::mutex> guard(lock);
+	if (!error) {
+	  error = e;
+	}
+      }
+
+      void worker_loop(size_t index)
+      {
+	size_t seen = 0;
+	for (;;) {
+	  std::unique_lock<std::mutex> guard(lock);
+	  wake.wait(guard, [&]() { return stopping || generation != seen; });
+	  if (stopping) {
+	    return;
+	  }
+	  seen = generation;
+	  const std::function<void(size_t)> *f = job;
+	  guard.unlock();
+	  try {
+	    (*f)(index);
+	  } catch (...) {
+	    record(std::current_exception());
+	  }
+	  guard.lock();
+	  if (--pending == 0) {
+	    done.notify_one();
+	  }
+	}
+      }
+
+    public:
+
+      // 0 threads means one per hardware thread
+      explicit thread_pool(unsigned threads = 0) : job(nullptr), generation(0), pending(0), stopping(false)
+      {
+	if (threads == 0) {
+	  threads = std::thread::hardware_concurrency();
+	}
+	for (unsigned i = 1; i < threads; ++i) {
+	  workers.push_back(std::thread(&thread_pool::worker_loop, this, (size_t) i));
+	}
+      }
+
+      ~thread_pool()
+      {
+	{
+	  std::lock_guard<std::mutex> guard(lock);
+	  stopping = true;
+	}
+	wake.notify_all();
+	for (size_t i = 0; i < workers.size(); ++i) {
+	  workers[i].join();
+	}
+      }
+
+      thread_pool(const thread_pool &) = delete;
+      thread_pool &operator=(const thread_pool &) = delete;
+
+      // Number of workers, including the calling thread
+      size_t size() const
+      {
+	return workers.size() + 1;
+      }
+
+      void run(const std::function<void(size_t)> &f)
+      {
+	std::lock_guard<std::mutex> one_at_a_time(run_lock);
+	{
+	  std::lock_guard<std::mutex> guard(lock);
+	  job = &f;
+	  pending = workers.size();
+	  error = nullptr;
+	  ++generation;
+	}
+	wake.notify_all();
+	try {
+	  f(0);
+	} catch (...) {
+	  record(std::current_exception());
+	}
+	std::unique_lock<std::mutex> guard(lock);
+	done.wait(guard, [&]() { return pending == 0; });
+	if (error) {
+	  std::exception_ptr e = error;
+	  error = nullptr;
+	  std::rethrow_exception(e);
+	}
+      }
+
+    };
+
+    // Slices start on multiples of this many points. Batches of fewer
+    // than serial_cutoff points aren't worth waking the pool for.
+    enum { slice_grain = 64, serial_cutoff = 16384 };
+
+    // First point and one past the last for worker index's slice
+    inline void slice_bounds(size_t count, size_t workers, size_t index, size_t &begin, size_t &end)
+    {
+      size_t blocks = (count + slice_grain - 1) / slice_grain;
+      begin = blocks * index / workers * slice_grain;
+      end = blocks * (index + 1) / workers * slice_grain;
+      if (begin > count) {
+	begin = count;
+      }
+      if (end > count) {
+	end = count;
+      }
+    }
+
+    // Calls f(begin, end) for each worker's slice of count points
+    template <typename function>
+    void parallel_for(thread_pool &pool, size_t count, function f)
+    {
+      if (count < serial_cutoff || pool.size() == 1) {
+	f((size_t) 0, count);
+	return;
+      }
+      size_t workers = pool.size();
+      pool.run([&](size_t index) {
+	  size_t begin, end;
+	  slice_bounds(count, workers, index, begin, end);
+	  if (begin < end) {
+	    f(begin, end);
+	  }
+	});
+    }
+
+    /**
+     * Zeroes a freshly allocated buffer from the workers that will
+     * later write to it, so its pages are placed near them. Only useful
+     * for buffers that haven't been written yet; std::vector zeroes its
+     * memory on the calling thread, so use new T[count] or malloc.
+     */
+
+    template <typename T>
+    void first_touch(thread_pool &pool, T *buffer, size_t count)
+    {
+      parallel_for(pool, count, [=](size_t begin, size_t end) {
+	  memset((void *) (buffer + begin), 0, (end - begin) * sizeof(T));
+	});
+    }
+
+    template <typename convert_to>
+    struct parallel_converter {
+
+    };
+
+    /***************************************************************
+     * Parallel convert to lat_long bits here
+     */
+
+    template <>
+    struct parallel_converter<lat_long> {
+      thread_pool &pool;
+
+      explicit parallel_converter(thread_pool &pool) : pool(pool)
+      {
+      }
+
+      template <typename solver = vermeille_solver, typename scalar = double>
+      typename std::enable_if<is_geodetic_solver<solver>::value>::type
+      operator()(const scalar *x, const scalar *y, const scalar *z, scalar *lat, scalar *lon, scalar *alt, size_t count, const ellipsoid_parameters &e = WGS84_ELLIPSOID, const solver &solve = solver())
+      {
+	parallel_for(pool, count, [&](size_t begin, size_t end) {
+	    batch_converter<lat_long>()(x + begin, y + begin, z + begin, lat + begin, lon + begin, alt + begin, end - begin, e, solve);
+	  });
+      }
+
+      // On the kernel set simd_dispatch.hpp picked for this CPU
+      template <typename math>
+      void operator()(const double *x, const double *y, const double *z, double *lat, double *lon, double *alt, size_t count, const ellipsoid_parameters &e, const dispatched<math> &d)
+      {
+	parallel_for(pool, count, [&](size_t begin, size_t end) {
+	    batch_converter<lat_long>()(x + begin, y + begin, z + begin, lat + begin, lon + begin, alt + begin, end - begin, e, d);
+	  });
+      }
+
+    };
+
+    /***************************************************************
+     * Parallel convert to ecef bits here
+     */
+
+    template <>
+    struct parallel_converter<ecef> {
+      thread_pool &pool;
+
+      explicit parallel_converter(thread_pool &pool) : pool(pool)
+      {
+      }
+
+      // Takes the same math policies batch_converter<ecef> does,
+      // dispatched<math>() included
+      template <typename scalar, typename math = precise_math>
+      void operator()(const scalar *lat, const scalar *lon, const scalar *alt, scalar *x, scalar *y, scalar *z, size_t count, const ellipsoid_parameters &e = WGS84_ELLIPSOID, const math &m = math())
+      {
+	parallel_for(pool, count, [&](size_t begin, size_t end) {
+	    batch_converter<ecef>()(lat + begin, lon + begin, alt + begin, x + begin, y + begin, z + begin, end - begin, e, m);
+	  });
+      }
+
+    };
+
+    /***************************************************************
+     * Parallel tod_eci_point to ecef_point. The rotation for a shared
+     * time is built once and shared by every worker. Each worker gets
+     * its own copy of the gha_interpolator for timestamped points.
+     */
+
+    template <>
+    struct parallel_converter<ecef_point> {
+      thread_pool &pool;
+
+      explicit parallel_converter(thread_pool &pool) : pool(pool)
+      {
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_point<tod_eci_frame, scalar> *in, xyz_point<ecef_frame, scalar> *out, size_t count, const eci_ecef_rotation &r)
+      {
+	parallel_for(pool, count, [&](size_t begin, size_t end) {
+	    batch_converter<ecef_point>()(in + begin, out + begin, end - begin, r);
+	  });
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_point<tod_eci_frame, scalar> *in, xyz_point<ecef_frame, scalar> *out, size_t count, const double &at_time)
+      {
+	(*this)(in, out, count, eci_ecef_rotation(at_time));
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_point<tod_eci_frame, scalar> *in, const double *times, xyz_point<ecef_frame, scalar> *out, size_t count, const gha_interpolator &gha = gha_interpolator())
+      {
+	parallel_for(pool, count, [&](size_t begin, size_t end) {
+	    gha_interpolator local(gha);
+	    batch_converter<ecef_point>()(in + begin, times + begin, out + begin, end - begin, local);
+	  });
+      }
+
+    };
+
+    template <>
+    struct parallel_converter<tod_eci_point> {
+      thread_pool &pool;
+
+      explicit parallel_converter(thread_pool &pool) : pool(pool)
+      {
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_point<ecef_frame, scalar> *in, xyz_point<tod_eci_frame, scalar> *out, size_t count, const eci_ecef_rotation &r)
+      {
+	parallel_for(pool, count, [&](size_t begin, size_t end) {
+	    batch_converter<tod_eci_point>()(in + begin, out + begin, end - begin, r);
+	  });
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_point<ecef_frame, scalar> *in, xyz_point<tod_eci_frame, scalar> *out, size_t count, const double &at_time)
+      {
+	(*this)(in, out, count, eci_ecef_rotation(at_time));
+      }
+
+    };
+
+    /***************************************************************
+     * Parallel state vector conversions
+     */
+
+    template <>
+    struct parallel_converter<ecef_vel_point> {
+      thread_pool &pool;
+
+      explicit parallel_converter(thread_pool &pool) : pool(pool)
+      {
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_state<tod_eci_frame, scalar> *in, xyz_state<ecef_frame, scalar> *out, size_t count, const eci_ecef_rotation &r)
+      {
+	parallel_for(pool, count, [&](size_t begin, size_t end) {
+	    batch_converter<ecef_vel_point>()(in + begin, out + begin, end - begin, r);
+	  });
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_state<tod_eci_frame, scalar> *in, xyz_state<ecef_frame, scalar> *out, size_t count, const double &at_time)
+      {
+	(*this)(in, out, count, eci_ecef_rotation(at_time));
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_state<tod_eci_frame, scalar> *in, const double *times, xyz_state<ecef_frame, scalar> *out, size_t count, const gha_interpolator &gha = gha_interpolator())
+      {
+	parallel_for(pool, count, [&](size_t begin, size_t end) {
+	    gha_interpolator local(gha);
+	    batch_converter<ecef_vel_point>()(in + begin, times + begin, out + begin, end - begin, local);
+	  });
+      }
+
+    };
+
+    template <>
+    struct parallel_converter<tod_eci_vel_point> {
+      thread_pool &pool;
+
+      explicit parallel_converter(thread_pool &pool) : pool(pool)
+      {
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_state<ecef_frame, scalar> *in, xyz_state<tod_eci_frame, scalar> *out, size_t count, const eci_ecef_rotation &r)
+      {
+	parallel_for(pool, count, [&](size_t begin, size_t end) {
+	    batch_converter<tod_eci_vel_point>()(in + begin, out + begin, end - begin, r);
+	  });
+      }
+
+      template <typename scalar>
+      void operator()(const xyz_state<ecef_frame, scalar> *in, xyz_state<tod_eci_frame, scalar> *out, size_t count, const double &at_time)
+      {
+	(*this)(in, out, count, eci_ecef_rotation(at_time));
+      }
+
+    };
+
+    // The float point types convert with the same kernels
+    template <>
+    struct parallel_converter<ecef_point_f> : public parallel_converter<ecef_point> {
+      explicit parallel_converter(thread_pool &pool) : parallel_converter<ecef_point>(pool)
+      {
+      }
+    };
+
+    template <>
+    struct parallel_converter<tod_eci_point_f> : public parallel_converter<tod_eci_point> {
+      explicit parallel_converter(thread_pool &pool) : parallel_converter<tod_eci_point>(pool)
+      {
+      }
+    };
+
+    template <>
+    struct parallel_converter<ecef_vel_point_f> : public parallel_converter<ecef_vel_point> {
+      explicit parallel_converter(thread_pool &pool) : parallel_converter<ecef_vel_point>(pool)
+      {
+      }
+    };
+
+    template <>
+    struct parallel_converter<tod_eci_vel_point_f> : public parallel_converter<tod_eci_vel_point> {
+      explicit parallel_converter(thread_pool &pool) : parallel_converter<tod_eci_vel_point>(pool)
+      {
+      }
+    };
+
+  }
+
+}
+
+#endif
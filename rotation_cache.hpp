@@ -0,0 +1,101 @@
+/**
+ * Bounded least recently used cache of eci_ecef_rotation objects keyed
+ * by observation time. Useful when points for a handful of epochs come
+ * in interleaved and you don't want to keep track of the rotation
+ * contexts yourself. Times are matched exactly. A capacity of 0 or a
+ * NaN or infinite time throws std::invalid_argument.
+ *
+ * Not thread safe. Give each thread its own cache.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "conversion_matrices.hpp"
+#include <cmath>
+#include <cstddef>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#ifndef _HPP_ROTATION_CACHE
+#define _HPP_ROTATION_CACHE
+
+namespace fr {
+
+  namespace coordinates {
+
+    class rotation_cache {
+      typedef std::list<eci_ecef_rotation> entry_list;
+      size_t capacity;
+      // Most recently used at the front
+      entry_list entries;
+      std::unordered_map<double, entry_list::iterator> index;
+      size_t hit_count;
+      size_t miss_count;
+
+    public:
+      rotation_cache(size_t capacity = 16) : capacity(capacity), hit_count(0), miss_count(0)
+      {
+	if (capacity == 0) {
+	  throw std::invalid_argument("rotation_cache capacity must be at least 1");
+	}
+      }
+
+      /**
+       * Returns the rotation context for at_time, building it if it
+       * isn't already in the cache. The reference stays valid until
+       * capacity other times have been looked up since.
+       */
+
+      const eci_ecef_rotation &get(const double &at_time)
+      {
+	// NaN never compares equal to itself, so it would never hit
+	if (!std::isfinite(at_time)) {
+	  throw std::invalid_argument("rotation_cache time must be finite");
+	}
+	std::unordered_map<double, entry_list::iterator>::iterator found = index.find(at_time);
+	if (found != index.end()) {
+	  ++hit_count;
+	  entries.splice(entries.begin(), entries, found->second);
+	  return entries.front();
+	}
+	++miss_count;
+	if (entries.size() >= capacity) {
+	  index.erase(entries.back().get_time());
+	  entries.pop_back();
+	}
+	entries.push_front(eci_ecef_rotation(at_time));
+	index[at_time] = entries.begin();
+	return entries.front();
+      }
+
+      void clear()
+      {
+	entries.clear();
+	index.clear();
+      }
+
+      size_t size() const { return entries.size(); }
+      size_t hits() const { return hit_count; }
+      size_t misses() const { return miss_count; }
+
+    };
+
+  }
+
+}
+
+#endif
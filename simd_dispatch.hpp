@@ -0,0 +1,290 @@
+/**
+ * Runtime instruction set selection for the batch kernels. The
+ * lat/long to ECEF and ECEF to lat/long batch conversions and the one
+ * to many haversine_distance and bearing loops are each compiled four
+ * times here, for no vectorization at all, SSE2, AVX2 with FMA and
+ * AVX-512, and the best one the CPU supports is picked the first time
+ * one is called. So one binary built for plain x86-64 runs AVX-512 on
+ * the machines that have it and SSE2 on the ones that don't.
+ *
+ * Pass dispatched<math>() where the kernel takes a math policy:
+ *
+ *   batch_converter<ecef>()(lat, lon, alt, x, y, z, n, WGS84_ELLIPSOID, dispatched<fast_math>());
+ *   haversine_distance().distances(from, lat, lon, out, n, dispatched<>());
+ *
+ * Only double arrays are dispatched. Build with -ffast-math, which
+ * lets gcc call glibc's vector sin and atan2 of the matching width
+ * with precise_math. With fast_math, -fno-math-errno is enough for
+ * AVX-512, and SSE2 and AVX2 also need -fno-trapping-math to turn its
+ * selects into blends. Without those flags the loops don't vectorize
+ * and every backend runs the same scalar code. ECEF to lat/long uses
+ * basic_vermeille_solver<math>. On 1K points at -O3 -ffast-math,
+ * lat/long to ECEF takes about 55, 26, 9.5 and 6.7 ns a point from
+ * scalar up to AVX-512 with precise_math; see bench/simd_bench.cpp.
+ *
+ * Set FR_COORDINATES_SIMD to scalar, sse2, avx2 or avx512 in the
+ * environment to start with that backend instead, or call
+ * simd_dispatch::force() to switch at run time. A backend the CPU
+ * can't run is never selected; force() throws std::invalid_argument
+ * for one and the environment variable is ignored.
+ *
+ * Backends can differ from each other in the last bit, since vector
+ * and scalar sin don't round the same and AVX2 can fuse multiplies
+ * and adds, so compare results within one backend.
+ * parallel_converts.hpp gets the same output as a serial run as long
+ * as the backend isn't switched in the middle. The target attributes
+ * only add instructions to the ones the translation unit was compiled
+ * with, so building with -march=native makes the lower backends
+ * the same as the native one, and the scalar backend relies on gcc's
+ * optimize attribute and is just the default code under clang. On
+ * other architectures only the scalar backend is available.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_SIMD_DISPATCH
+#define _HPP_SIMD_DISPATCH
+
+#include "batch_converts.hpp"
+#include "bearing.hpp"
+#include "fast_math.hpp"
+#include "geodetic_solvers.hpp"
+#include "haversine_distance.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FR_SIMD_X86 1
+#endif
+
+namespace fr {
+
+  namespace coordinates {
+
+    enum simd_backend {
+      simd_scalar,		// Not vectorized, as a baseline
+      simd_sse2,		// 2 doubles a vector, every x86-64
+      simd_avx2,		// 4 doubles a vector, with FMA (Haswell and later)
+      simd_avx512,		// 8 doubles a vector, AVX-512F and DQ
+      simd_backend_count
+    };
+
+    // One backend's copy of each kernel, for one math policy
+    template <typename math>
+    struct simd_kernel_set {
+      void (*lat_long_to_ecef)(const double *lat, const double *lon, const double *alt, double *x, double *y, double *z, size_t count, const ellipsoid_parameters &e);
+      void (*ecef_to_lat_long)(const double *x, const double *y, const double *z, double *lat, double *lon, double *alt, size_t count, const ellipsoid_parameters &e);
+      void (*distances)(double earth_radius, const lat_long &from, const double *lat, const double *lon, double *out, size_t count);
+      void (*bearings)(const lat_long &from, const double *lat, const double *lon, double *out, size_t count);
+      void (*distances_and_bearings)(double earth_radius, const lat_long &from, const double *lat, const double *lon, double *dist_out, double *bearing_out, size_t count);
+    };
+
+    // Stamps out one backend's kernels. The kernels themselves are
+    // always_inline, so each copy is compiled for the instruction set
+    // in its attributes.
+
+#define FR_SIMD_KERNELS(name, attributes)				\
+    template <typename math>						\
+    struct name {							\
+      attributes static void lat_long_to_ecef(const double * __restrict__ lat, const double * __restrict__ lon, const double * __restrict__ alt, double * __restrict__ x, double * __restrict__ y, double * __restrict__ z, size_t count, const ellipsoid_parameters &e) \
+      {									\
+	batch_converter<ecef>::kernel<double, math>(lat, lon, alt, x, y, z, count, e); \
+      }									\
+									\
+      attributes static void ecef_to_lat_long(const double * __restrict__ x, const double * __restrict__ y, const double * __restrict__ z, double * __restrict__ lat, double * __restrict__ lon, double * __restrict__ alt, size_t count, const ellipsoid_parameters &e) \
+      {									\
+	batch_converter<lat_long>::kernel(x, y, z, lat, lon, alt, count, e, basic_vermeille_solver<math>()); \
+      }									\
+									\
+      attributes static void distances(double earth_radius, const lat_long &from, const double * __restrict__ lat, const double * __restrict__ lon, double * __restrict__ out, size_t count) \
+      {									\
+	haversine_distance::distances_kernel<math>(earth_radius, from, lat, lon, out, count); \
+      }									\
+									\
+      attributes static void bearings(const lat_long &from, const double * __restrict__ lat, const double * __restrict__ lon, double * __restrict__ out, size_t count) \
+      {									\
+	bearing::kernel<math>(from, lat, lon, out, count);		\
+      }									\
+									\
+      attributes static void distances_and_bearings(double earth_radius, const lat_long &from, const double * __restrict__ lat, const double * __restrict__ lon, double * __restrict__ dist_out, double * __restrict__ bearing_out, size_t count) \
+      {									\
+	haversine_distance::distances_and_bearings_kernel<math>(earth_radius, from, lat, lon, dist_out, bearing_out, count); \
+      }									\
+									\
+      static simd_kernel_set<math> get()				\
+      {									\
+	simd_kernel_set<math> retval = { &lat_long_to_ecef, &ecef_to_lat_long, &distances, &bearings, &distances_and_bearings }; \
+	return retval;							\
+      }									\
+    };
+
+#if defined(__GNUC__) && !defined(__clang__)
+    FR_SIMD_KERNELS(scalar_kernels, __attribute__((optimize("no-tree-vectorize"))))
+#else
+    FR_SIMD_KERNELS(scalar_kernels, )
+#endif
+
+#ifdef FR_SIMD_X86
+    FR_SIMD_KERNELS(sse2_kernels, __attribute__((target("sse2"))))
+    FR_SIMD_KERNELS(avx2_kernels, __attribute__((target("avx2,fma"))))
+    FR_SIMD_KERNELS(avx512_kernels, __attribute__((target("avx512f,avx512dq,avx2,fma,prefer-vector-width=512"))))
+#else
+    // Never selected, supported() says no
+    template <typename math>
+    struct sse2_kernels : public scalar_kernels<math> {
+    };
+
+    template <typename math>
+    struct avx2_kernels : public scalar_kernels<math> {
+    };
+
+    template <typename math>
+    struct avx512_kernels : public scalar_kernels<math> {
+    };
+#endif
+
+#undef FR_SIMD_KERNELS
+
+    class simd_dispatch {
+
+      static simd_backend from_environment()
+      {
+	const char *setting = getenv("FR_COORDINATES_SIMD");
+	simd_backend b;
+	if (setting != NULL && parse(setting, b) && supported(b)) {
+	  return b;
+	}
+	return best();
+      }
+
+      static std::atomic<simd_backend> &current()
+      {
+	static std::atomic<simd_backend> backend(from_environment());
+	return backend;
+      }
+
+    public:
+
+      // Whether this CPU (and OS) can run the backend
+      static bool supported(simd_backend b)
+      {
+	if (b == simd_scalar) {
+	  return true;
+	}
+#ifdef FR_SIMD_X86
+	__builtin_cpu_init();
+	switch(b) {
+	case simd_sse2:
+	  return __builtin_cpu_supports("sse2");
+	case simd_avx2:
+	  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	case simd_avx512:
+	  return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+	default:
+	  break;
+	}
+#endif
+	return false;
+      }
+
+      // Widest backend this CPU supports
+      static simd_backend best()
+      {
+	for (int b = simd_backend_count - 1; b > simd_scalar; --b) {
+	  if (supported((simd_backend) b)) {
+	    return (simd_backend) b;
+	  }
+	}
+	return simd_scalar;
+      }
+
+      // The backend dispatched<> kernels run on
+      static simd_backend active()
+      {
+	return current().load(std::memory_order_relaxed);
+      }
+
+      // Switch every thread to another backend, for testing and
+      // benchmarking. Don't do it while another thread is in the
+      // middle of a batch you want consistent results from.
+      static void force(simd_backend b)
+      {
+	if (b < simd_scalar || b >= simd_backend_count || !supported(b)) {
+	  throw std::invalid_argument(std::string("SIMD backend not supported on this CPU: ") + name(b));
+	}
+	current().store(b, std::memory_order_relaxed);
+      }
+
+      static const char *name(simd_backend b)
+      {
+	switch(b) {
+	case simd_scalar:
+	  return "scalar";
+	case simd_sse2:
+	  return "sse2";
+	case simd_avx2:
+	  return "avx2";
+	case simd_avx512:
+	  return "avx512";
+	default:
+	  return "unknown";
+	}
+      }
+
+      // Backend for a name as returned by name(), false if there isn't one
+      static bool parse(const char *backend_name, simd_backend &b)
+      {
+	for (int i = simd_scalar; i < simd_backend_count; ++i) {
+	  if (strcmp(backend_name, name((simd_backend) i)) == 0) {
+	    b = (simd_backend) i;
+	    return true;
+	  }
+	}
+	return false;
+      }
+
+      template <typename math>
+      static const simd_kernel_set<math> &kernels(simd_backend b)
+      {
+	static const simd_kernel_set<math> table[simd_backend_count] = {
+	  scalar_kernels<math>::get(),
+	  sse2_kernels<math>::get(),
+	  avx2_kernels<math>::get(),
+	  avx512_kernels<math>::get()
+	};
+	return table[b];
+      }
+
+    };
+
+    template <typename math>
+    struct dispatched {
+
+      static const simd_kernel_set<math> &kernels()
+      {
+	return simd_dispatch::kernels<math>(simd_dispatch::active());
+      }
+
+    };
+
+  }
+
+}
+
+#endif
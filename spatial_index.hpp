@@ -0,0 +1,509 @@
+/**
+ * Spatial index for radius and nearest neighbor queries over lots of
+ * lat_longs, using the same spherical earth haversine_distance does.
+ * Points are kept as unit vectors in a k-d tree. Chord length through
+ * the sphere goes up with great circle distance, so the tree can prune
+ * on straight line distance and still return exactly what a brute force
+ * scan with haversine_distance would, in O(log n) or so per query
+ * instead of O(n).
+ *
+ * Points get ids in the order they're added, starting at 0. Removing a
+ * point just marks it dead. The tree gets rebuilt from the live points
+ * once enough have been removed or inserted since the last build that
+ * it might be lopsided, so inserts and removes are amortized O(log n).
+ * An insert that lands deeper than about 2 log2(n) also rebuilds the
+ * lopsided subtree it went through, the way a scapegoat tree does, so
+ * sorted inserts can't grow a long chain for the searches to recurse
+ * down.
+ *
+ * Not thread safe for writes. Concurrent queries are fine.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_SPATIAL_INDEX
+#define _HPP_SPATIAL_INDEX
+
+#include "constants.hpp"
+#include "ellipsoid.hpp"
+#include "geodetic_solvers.hpp"
+#include "lat_long.hpp"
+#include "xyz_point.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <queue>
+#include <vector>
+
+namespace fr {
+
+  namespace coordinates {
+
+    class lat_long_index {
+
+    public:
+
+      static const size_t npos = (size_t) -1;
+
+      struct neighbor {
+	size_t id;
+	double distance;
+
+	bool operator<(const neighbor &other) const
+	{
+	  return distance < other.distance;
+	}
+      };
+
+    private:
+
+      struct entry {
+	double v[3];  // Unit vector
+	lat_long position;
+	bool alive;
+      };
+
+      struct node {
+	double v[3];
+	size_t id;
+	int axis;
+	size_t left;
+	size_t right;
+      };
+
+      double earth_radius;
+      std::vector<entry> entries;
+      std::vector<node> nodes;
+      size_t root;
+      size_t live_count;
+      size_t dead_in_tree;
+      size_t built_size;
+      size_t inserted_since_build;
+
+      static void unit_vector(const lat_long &p, double *v)
+      {
+	double lat = p.get_lat() * fr::constants::pi / 180.0;
+	double lon = p.get_long() * fr::constants::pi / 180.0;
+	v[0] = cos(lat) * cos(lon);
+	v[1] = cos(lat) * sin(lon);
+	v[2] = sin(lat);
+      }
+
+      static double chord2(const double *a, const double *b)
+      {
+	double dx = a[0] - b[0];
+	double dy = a[1] - b[1];
+	double dz = a[2] - b[2];
+	return dx * dx + dy * dy + dz * dz;
+      }
+
+      // Great circle distance for a squared chord length
+      double chord2_to_distance(double c2) const
+      {
+	double half = sqrt(c2) / 2.0;
+	return earth_radius * 2.0 * asin(half > 1.0 ? 1.0 : half);
+      }
+
+      // Squared chord length for a great circle distance
+      double distance_to_chord2(double distance) const
+      {
+	double theta = distance / earth_radius;
+	if (theta >= fr::constants::pi) {
+	  return 4.0;
+	}
+	double c = 2.0 * sin(theta / 2.0);
+	return c * c;
+      }
+
+      size_t make_node(size_t id, int axis)
+      {
+	node n;
+	n.v[0] = entries[id].v[0];
+	n.v[1] = entries[id].v[1];
+	n.v[2] = entries[id].v[2];
+	n.id = id;
+	n.axis = axis;
+	n.left = npos;
+	n.right = npos;
+	nodes.push_back(n);
+	return nodes.size() - 1;
+      }
+
+      struct axis_less {
+	const std::vector<entry> *entries;
+	int axis;
+
+	bool operator()(size_t a, size_t b) const
+	{
+	  return (*entries)[a].v[axis] < (*entries)[b].v[axis];
+	}
+      };
+
+      // Number of nodes under n, including dead ones
+      size_t subtree_size(size_t n) const
+      {
+	size_t retval = 0;
+	std::vector<size_t> pending;
+	if (n != npos) {
+	  pending.push_back(n);
+	}
+	while (!pending.empty()) {
+	  const node &current = nodes[pending.back()];
+	  pending.pop_back();
+	  ++retval;
+	  if (current.left != npos) {
+	    pending.push_back(current.left);
+	  }
+	  if (current.right != npos) {
+	    pending.push_back(current.right);
+	  }
+	}
+	return retval;
+      }
+
+      // Deepest an insert can go before part of the tree gets rebuilt
+      static size_t max_depth(size_t tree_size)
+      {
+	size_t bits = 0;
+	while (tree_size > 0) {
+	  ++bits;
+	  tree_size >>= 1;
+	}
+	return 2 * bits + 1;
+      }
+
+      // Splits on the axis with the biggest spread at the median point
+      size_t build(std::vector<size_t>::iterator first, std::vector<size_t>::iterator last)
+      {
+	if (first == last) {
+	  return npos;
+	}
+	double lo[3] = { 2.0, 2.0, 2.0 };
+	double hi[3] = { -2.0, -2.0, -2.0 };
+	for (std::vector<size_t>::iterator i = first; i != last; ++i) {
+	  for (int a = 0; a < 3; ++a) {
+	    lo[a] = std::min(lo[a], entries[*i].v[a]);
+	    hi[a] = std::max(hi[a], entries[*i].v[a]);
+	  }
+	}
+	int axis = 0;
+	for (int a = 1; a < 3; ++a) {
+	  if (hi[a] - lo[a] > hi[axis] - lo[axis]) {
+	    axis = a;
+	  }
+	}
+	std::vector<size_t>::iterator middle = first + (last - first) / 2;
+	axis_less compare = { &entries, axis };
+	std::nth_element(first, middle, last, compare);
+	size_t n = make_node(*middle, axis);
+	size_t left = build(first, middle);
+	size_t right = build(middle + 1, last);
+	nodes[n].left = left;
+	nodes[n].right = right;
+	return n;
+      }
+
+      void rebuild()
+      {
+	std::vector<size_t> ids;
+	ids.reserve(live_count);
+	for (size_t i = 0; i < entries.size(); ++i) {
+	  if (entries[i].alive) {
+	    ids.push_back(i);
+	  }
+	}
+	nodes.clear();
+	nodes.reserve(ids.size());
+	root = build(ids.begin(), ids.end());
+	dead_in_tree = 0;
+	built_size = ids.size();
+	inserted_since_build = 0;
+      }
+
+      // path runs from the root down to a node that was just inserted
+      // too deep. Finds the lowest node on it that's out of balance,
+      // with one child holding more than 70% of its subtree, and
+      // rebuilds that subtree. The old nodes are left in place until
+      // the next full rebuild, which happens early if too many pile up.
+      void rebalance(const std::vector<size_t> &path)
+      {
+	size_t child_size = 1;
+	size_t i = path.size() - 1;
+	while (i > 0) {
+	  --i;
+	  const node &current = nodes[path[i]];
+	  size_t sibling = current.left == path[i + 1] ? current.right : current.left;
+	  size_t size = 1 + child_size + subtree_size(sibling);
+	  if (child_size * 10 > size * 7) {
+	    break;
+	  }
+	  child_size = size;
+	}
+	std::vector<size_t> ids;
+	std::vector<size_t> pending(1, path[i]);
+	while (!pending.empty()) {
+	  const node &current = nodes[pending.back()];
+	  pending.pop_back();
+	  ids.push_back(current.id);
+	  if (current.left != npos) {
+	    pending.push_back(current.left);
+	  }
+	  if (current.right != npos) {
+	    pending.push_back(current.right);
+	  }
+	}
+	size_t fresh = build(ids.begin(), ids.end());
+	if (i == 0) {
+	  root = fresh;
+	} else if (nodes[path[i - 1]].left == path[i]) {
+	  nodes[path[i - 1]].left = fresh;
+	} else {
+	  nodes[path[i - 1]].right = fresh;
+	}
+	if (nodes.size() > 4 * (built_size + inserted_since_build)) {
+	  rebuild();
+	}
+      }
+
+      void within(size_t n, const double *q, double limit2, std::vector<neighbor> &out) const
+      {
+	while (n != npos) {
+	  const node &current = nodes[n];
+	  double c2 = chord2(q, current.v);
+	  if (c2 <= limit2 && entries[current.id].alive) {
+	    neighbor found = { current.id, chord2_to_distance(c2) };
+	    out.push_back(found);
+	  }
+	  double diff = q[current.axis] - current.v[current.axis];
+	  size_t near = diff < 0.0 ? current.left : current.right;
+	  size_t far = diff < 0.0 ? current.right : current.left;
+	  if (diff * diff <= limit2) {
+	    within(far, q, limit2, out);
+	  }
+	  n = near;
+	}
+      }
+
+      // Max heap of the k best squared chords seen so far
+      void nearest(size_t n, const double *q, size_t k, std::priority_queue<std::pair<double, size_t> > &best) const
+      {
+	while (n != npos) {
+	  const node &current = nodes[n];
+	  if (entries[current.id].alive) {
+	    double c2 = chord2(q, current.v);
+	    if (best.size() < k) {
+	      best.push(std::make_pair(c2, current.id));
+	    } else if (c2 < best.top().first) {
+	      best.pop();
+	      best.push(std::make_pair(c2, current.id));
+	    }
+	  }
+	  double diff = q[current.axis] - current.v[current.axis];
+	  size_t near = diff < 0.0 ? current.left : current.right;
+	  size_t far = diff < 0.0 ? current.right : current.left;
+	  nearest(near, q, k, best);
+	  if (best.size() < k || diff * diff < best.top().first) {
+	    n = far;
+	  } else {
+	    n = npos;
+	  }
+	}
+      }
+
+    public:
+
+      // Default to meters, same as haversine_distance
+      lat_long_index(double earth_radius = WGS84_ELLIPSOID.ae) : earth_radius(earth_radius), root(npos), live_count(0), dead_in_tree(0), built_size(0), inserted_since_build(0)
+      {
+      }
+
+      /**
+       * Bulk load. Adds count points from latitude and longitude arrays
+       * (degrees) and builds a balanced tree over everything in the
+       * index. The new points get consecutive ids, the first of which
+       * is returned.
+       */
+
+      size_t build(const double *lat, const double *lon, size_t count)
+      {
+	size_t first = entries.size();
+	entries.reserve(entries.size() + count);
+	for (size_t i = 0; i < count; ++i) {
+	  entry e;
+	  e.position = lat_long(lat[i], lon[i]);
+	  unit_vector(e.position, e.v);
+	  e.alive = true;
+	  entries.push_back(e);
+	}
+	live_count += count;
+	rebuild();
+	return first;
+      }
+
+      // Adds one point and returns its id
+      size_t insert(const lat_long &p)
+      {
+	entry e;
+	e.position = p;
+	unit_vector(p, e.v);
+	e.alive = true;
+	entries.push_back(e);
+	size_t id = entries.size() - 1;
+	++live_count;
+	++inserted_since_build;
+	if (inserted_since_build > built_size) {
+	  rebuild();
+	  return id;
+	}
+	// Walk down to a leaf and hang the new point off it
+	if (root == npos) {
+	  root = make_node(id, 0);
+	  return id;
+	}
+	std::vector<size_t> path;
+	size_t n = root;
+	for (;;) {
+	  path.push_back(n);
+	  node &current = nodes[n];
+	  bool go_left = e.v[current.axis] < current.v[current.axis];
+	  size_t next = go_left ? current.left : current.right;
+	  if (next == npos) {
+	    size_t child = make_node(id, (current.axis + 1) % 3);
+	    if (go_left) {
+	      nodes[n].left = child;
+	    } else {
+	      nodes[n].right = child;
+	    }
+	    path.push_back(child);
+	    break;
+	  }
+	  n = next;
+	}
+	if (path.size() > max_depth(built_size + inserted_since_build)) {
+	  rebalance(path);
+	}
+	return id;
+      }
+
+      // Adds a point given in ECEF. It's converted to geodetic first,
+      // since distances are worked out from geodetic lat/long
+      size_t insert(const ecef_point &p, const ellipsoid_parameters &e = WGS84_ELLIPSOID)
+      {
+	double lat, lon, alt;
+	vermeille_solver()(p.x, p.y, p.z, e, lat, lon, alt);
+	return insert(lat_long(lat, lon, alt));
+      }
+
+      // Returns false if the id wasn't in the index
+      bool remove(size_t id)
+      {
+	if (id >= entries.size() || !entries[id].alive) {
+	  return false;
+	}
+	entries[id].alive = false;
+	--live_count;
+	++dead_in_tree;
+	if (dead_in_tree > live_count) {
+	  rebuild();
+	}
+	return true;
+      }
+
+      bool contains(size_t id) const
+      {
+	return id < entries.size() && entries[id].alive;
+      }
+
+      const lat_long &get(size_t id) const
+      {
+	return entries[id].position;
+      }
+
+      size_t size() const
+      {
+	return live_count;
+      }
+
+      // Longest path from the root, in nodes
+      size_t depth() const
+      {
+	size_t retval = 0;
+	std::vector<std::pair<size_t, size_t> > pending;
+	if (root != npos) {
+	  pending.push_back(std::make_pair(root, (size_t) 1));
+	}
+	while (!pending.empty()) {
+	  std::pair<size_t, size_t> current = pending.back();
+	  pending.pop_back();
+	  retval = std::max(retval, current.second);
+	  if (nodes[current.first].left != npos) {
+	    pending.push_back(std::make_pair(nodes[current.first].left, current.second + 1));
+	  }
+	  if (nodes[current.first].right != npos) {
+	    pending.push_back(std::make_pair(nodes[current.first].right, current.second + 1));
+	  }
+	}
+	return retval;
+      }
+
+      /**
+       * Every point within radius (same units as the earth radius) of
+       * center. Results are appended to out in no particular order.
+       */
+
+      void within(const lat_long &center, double radius, std::vector<neighbor> &out) const
+      {
+	double q[3];
+	unit_vector(center, q);
+	within(root, q, distance_to_chord2(radius), out);
+      }
+
+      std::vector<neighbor> within(const lat_long &center, double radius) const
+      {
+	std::vector<neighbor> retval;
+	within(center, radius, retval);
+	return retval;
+      }
+
+      /**
+       * The k points closest to center, closest first.
+       */
+
+      std::vector<neighbor> nearest(const lat_long &center, size_t k) const
+      {
+	std::vector<neighbor> retval;
+	if (k == 0) {
+	  return retval;
+	}
+	double q[3];
+	unit_vector(center, q);
+	std::priority_queue<std::pair<double, size_t> > best;
+	nearest(root, q, k, best);
+	retval.resize(best.size());
+	for (size_t i = best.size(); i > 0; --i) {
+	  neighbor n = { best.top().second, chord2_to_distance(best.top().first) };
+	  retval[i - 1] = n;
+	  best.pop();
+	}
+	return retval;
+      }
+
+    };
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,313 @@
+/**
+ * Streaming conversion for feeds too long to hold in memory. A
+ * stream_converter pulls chunks of points from a source, converts them
+ * and pushes the results to a sink. The source and the sink each run
+ * on their own thread, and the chunks go around a small ring of
+ * buffers, so reading the next chunk and writing the last one overlap
+ * with converting the current one. Memory use is the ring and nothing
+ * else, however long the stream runs.
+ *
+ *   stream_converter<ecef_point, lat_long> stream;
+ *   stream.run(source, sink);
+ *
+ * source(buffer, max) fills up to max points and returns how many it
+ * wrote, 0 at the end of the stream. sink(buffer, count) gets each
+ * converted chunk, in order. A source that returns more than max stops
+ * the stream with std::length_error. By default each point goes through
+ * converter<out_type>; pass a chunk converter (a batch_converter or
+ * parallel_converter wrapped in a lambda, say) for anything else.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _HPP_STREAM_CONVERTER
+#define _HPP_STREAM_CONVERTER
+
+#include "converts.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace fr {
+
+  namespace coordinates {
+
+    // Chunk converter that runs converter<convert_to> on every point
+    template <typename convert_to>
+    struct each_converter {
+
+      template <typename convert_from>
+      void operator()(const convert_from *in, convert_to *out, size_t count) const
+      {
+	converter<convert_to> convert;
+	for (size_t i = 0; i < count; ++i) {
+	  out[i] = convert(in[i]);
+	}
+      }
+
+    };
+
+    /**
+     * Throughput numbers for a stream. Times are in seconds, and are
+     * the time spent in the source, the converter and the sink. Since
+     * the three overlap, the biggest of them is the bottleneck and
+     * elapsed should come out close to it.
+     */
+
+    struct stream_counters {
+      uint64_t chunks;
+      uint64_t points;
+      double elapsed;
+      double source_time;
+      double convert_time;
+      double sink_time;
+
+      double points_per_second() const
+      {
+	return elapsed > 0.0 ? (double) points / elapsed : 0.0;
+      }
+    };
+
+    template <typename in_type, typename out_type>
+    class stream_converter {
+
+    public:
+      typedef std::function<size_t(in_type *, size_t)> source_type;
+      typedef std::function<void(const out_type *, size_t)> sink_type;
+      typedef std::function<void(const in_type *, out_type *, size_t)> convert_type;
+
+    private:
+      typedef std::chrono::steady_clock clock;
+
+      enum slot_state { empty, filled, converted, finished };
+
+      struct slot {
+	std::vector<in_type> in;
+	std::vector<out_type> out;
+	size_t count;
+	slot_state state;
+      };
+
+      size_t chunk_size;
+      convert_type convert;
+      std::vector<slot> ring;
+      std::mutex lock;
+      std::condition_variable changed;
+      bool aborted;
+      std::exception_ptr error;
+
+      // Nanoseconds, readable while a stream is running
+      std::atomic<uint64_t> chunk_count;
+      std::atomic<uint64_t> point_count;
+      std::atomic<uint64_t> elapsed_ns;
+      std::atomic<uint64_t> source_ns;
+      std::atomic<uint64_t> convert_ns;
+      std::atomic<uint64_t> sink_ns;
+      std::atomic<clock::rep> started;	// Ticks of clock
+      std::atomic<bool> running;
+
+      static uint64_t since(const clock::time_point &start)
+      {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+      }
+
+      uint64_t since_started() const
+      {
+	return since(clock::time_point(clock::duration(started.load())));
+      }
+
+      void fail(std::exception_ptr e)
+      {
+	std::lock_guard<std::mutex> guard(lock);
+	if (!error) {
+	  error = e;
+	}
+	aborted = true;
+	changed.notify_all();
+      }
+
+      // Waits for slot s to reach one of two states. False if the
+      // stream was aborted.
+      bool wait_for(slot &s, slot_state a, slot_state b)
+      {
+	std::unique_lock<std::mutex> guard(lock);
+	changed.wait(guard, [&]() { return aborted || s.state == a || s.state == b; });
+	return !aborted;
+      }
+
+      void set_state(slot &s, slot_state state)
+      {
+	std::lock_guard<std::mutex> guard(lock);
+	s.state = state;
+	changed.notify_all();
+      }
+
+      void read_loop(const source_type &source)
+      {
+	try {
+	  for (size_t k = 0; ; ++k) {
+	    slot &s = ring[k % ring.size()];
+	    if (!wait_for(s, empty, empty)) {
+	      return;
+	    }
+	    clock::time_point start = clock::now();
+	    s.count = source(s.in.data(), chunk_size);
+	    source_ns += since(start);
+	    if (s.count > chunk_size) {
+	      throw std::length_error("stream_converter: source returned more points than it had room for");
+	    }
+	    if (s.count == 0) {
+	      set_state(s, finished);
+	      return;
+	    }
+	    set_state(s, filled);
+	  }
+	} catch (...) {
+	  fail(std::current_exception());
+	}
+      }
+
+      void write_loop(const sink_type &sink)
+      {
+	try {
+	  for (size_t k = 0; ; ++k) {
+	    slot &s = ring[k % ring.size()];
+	    if (!wait_for(s, converted, finished) || s.state == finished) {
+	      return;
+	    }
+	    clock::time_point start = clock::now();
+	    sink(s.out.data(), s.count);
+	    sink_ns += since(start);
+	    set_state(s, empty);
+	  }
+	} catch (...) {
+	  fail(std::current_exception());
+	}
+      }
+
+    public:
+
+      /**
+       * Buffers is the number of chunks in the ring. Two is enough
+       * for the source, converter and sink to all be busy at once if
+       * they take about the same time; more smooths out a bursty source
+       * or sink. A chunk_size or buffers of 0 throws
+       * std::invalid_argument.
+       */
+
+      stream_converter(size_t chunk_size = 65536, const convert_type &convert = each_converter<out_type>(), size_t buffers = 2) : chunk_size(chunk_size), convert(convert), ring(buffers), aborted(false), chunk_count(0), point_count(0), elapsed_ns(0), source_ns(0), convert_ns(0), sink_ns(0), started(0), running(false)
+      {
+	if (chunk_size == 0 || buffers == 0) {
+	  throw std::invalid_argument("stream_converter needs a chunk_size and buffers of at least 1");
+	}
+	for (size_t i = 0; i < ring.size(); ++i) {
+	  ring[i].in.resize(chunk_size);
+	  ring[i].out.resize(chunk_size);
+	}
+      }
+
+      stream_converter(const stream_converter &) = delete;
+      stream_converter &operator=(const stream_converter &) = delete;
+
+      /**
+       * Runs the stream to the end on the calling thread, which does the
+       * converting. If the source, sink or converter throws, the stream
+       * stops and the exception is rethrown here. Chunks already passed
+       * to the sink stay passed.
+       */
+
+      stream_counters run(const source_type &source, const sink_type &sink)
+      {
+	for (size_t i = 0; i < ring.size(); ++i) {
+	  ring[i].state = empty;
+	  ring[i].count = 0;
+	}
+	aborted = false;
+	error = nullptr;
+	chunk_count = 0;
+	point_count = 0;
+	source_ns = 0;
+	convert_ns = 0;
+	sink_ns = 0;
+	elapsed_ns = 0;
+	started = clock::now().time_since_epoch().count();
+	running = true;
+	std::thread reader(&stream_converter::read_loop, this, std::cref(source));
+	std::thread writer(&stream_converter::write_loop, this, std::cref(sink));
+	try {
+	  for (size_t k = 0; ; ++k) {
+	    slot &s = ring[k % ring.size()];
+	    if (!wait_for(s, filled, finished)) {
+	      break;
+	    }
+	    if (s.state == finished) {
+	      break;
+	    }
+	    clock::time_point start = clock::now();
+	    convert(s.in.data(), s.out.data(), s.count);
+	    convert_ns += since(start);
+	    ++chunk_count;
+	    point_count += s.count;
+	    set_state(s, converted);
+	  }
+	} catch (...) {
+	  fail(std::current_exception());
+	}
+	reader.join();
+	writer.join();
+	elapsed_ns = since_started();
+	running = false;
+	if (error) {
+	  std::rethrow_exception(error);
+	}
+	return get_counters();
+      }
+
+      // Safe to call from another thread while run() is going
+      stream_counters get_counters() const
+      {
+	stream_counters retval;
+	retval.chunks = chunk_count;
+	retval.points = point_count;
+	retval.elapsed = (running ? (double) since_started() : (double) elapsed_ns) / 1e9;
+	retval.source_time = (double) source_ns / 1e9;
+	retval.convert_time = (double) convert_ns / 1e9;
+	retval.sink_time = (double) sink_ns / 1e9;
+	return retval;
+      }
+
+      size_t get_chunk_size() const { return chunk_size; }
+
+      // Bytes held by the buffer ring
+      size_t buffer_bytes() const
+      {
+	return ring.size() * chunk_size * (sizeof(in_type) + sizeof(out_type));
+      }
+
+    };
+
+  }
+
+}
+
+#endif
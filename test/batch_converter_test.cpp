@@ -0,0 +1,356 @@
+/**
+ * Tests batch conversions against the single point converters
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "coordinates.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+class batch_converter_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(batch_converter_test);
+  CPPUNIT_TEST(test_batch_to_ecef);
+  CPPUNIT_TEST(test_batch_to_lat_long);
+  CPPUNIT_TEST(test_batch_eci_ecef);
+  CPPUNIT_TEST(test_batch_state_vectors);
+  CPPUNIT_TEST(test_batch_timestamped);
+  CPPUNIT_TEST(test_batch_timestamped_nan);
+  CPPUNIT_TEST(test_batch_float);
+  CPPUNIT_TEST(test_batch_local_origin);
+  CPPUNIT_TEST(test_batch_float_rotations);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::vector<double> lat, lon, alt;
+
+public:
+
+  void setUp()
+  {
+    // A spread of points including the poles and the antimeridian
+    const double lats[] = { 39.75, -33.86, 0.0, 90.0, -90.0, 51.48, 64.2, -12.5 };
+    const double lons[] = { 104.87, 151.21, 0.0, 0.0, 45.0, -0.0015, 180.0, -179.99 };
+    const double alts[] = { 1609.344, 58.0, 0.0, 0.0, -42.0, 45.0, 400000.0, 35786000.0 };
+    lat.assign(lats, lats + 8);
+    lon.assign(lons, lons + 8);
+    alt.assign(alts, alts + 8);
+  }
+
+  void test_batch_to_ecef()
+  {
+    size_t count = lat.size();
+    std::vector<double> x(count), y(count), z(count);
+    fr::coordinates::batch_converter<fr::coordinates::ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      fr::coordinates::lat_long point(lat[i], lon[i], alt[i]);
+      fr::coordinates::ecef expected = fr::coordinates::converter<fr::coordinates::ecef>()(point);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_x(), x[i], .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_y(), y[i], .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_z(), z[i], .000001);
+    }
+  }
+
+  // Round trips the test points through ecef with each solver and
+  // checks them against the original iterative converter
+  template <typename solver>
+  void check_solver(const solver &solve, double tolerance)
+  {
+    size_t count = lat.size();
+    std::vector<double> x(count), y(count), z(count);
+    std::vector<double> lat2(count), lon2(count), alt2(count);
+    fr::coordinates::batch_converter<fr::coordinates::ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count);
+    fr::coordinates::batch_converter<fr::coordinates::lat_long>()(x.data(), y.data(), z.data(), lat2.data(), lon2.data(), alt2.data(), count, fr::coordinates::WGS84_ELLIPSOID, solve);
+    for (size_t i = 0; i < count; ++i) {
+      fr::coordinates::ecef point(x[i], y[i], z[i]);
+      fr::coordinates::lat_long expected = fr::coordinates::converter<fr::coordinates::lat_long>()(point);
+      fr::coordinates::lat_long single = fr::coordinates::converter<fr::coordinates::lat_long>()(point, fr::coordinates::WGS84_ELLIPSOID, solve);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_lat(), lat2[i], tolerance);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_alt(), alt2[i], .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(lat2[i], single.get_lat(), .0000000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(alt2[i], single.get_alt(), .000001);
+      // Longitude is meaningless at the poles
+      if (fabs(lat[i]) < 90.0) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_long(), lon2[i], .0000000001);
+      }
+    }
+  }
+
+  void test_batch_to_lat_long()
+  {
+    check_solver(fr::coordinates::iterative_solver(), .0000000001);
+    check_solver(fr::coordinates::bowring_solver<1>(), .000001);
+    check_solver(fr::coordinates::bowring_solver<2>(), .00000001);
+    check_solver(fr::coordinates::vermeille_solver(), .00000001);
+    // Naming the solver still works with double arrays
+    size_t count = lat.size();
+    std::vector<double> x(count), y(count), z(count), lat2(count), lon2(count), alt2(count);
+    fr::coordinates::batch_converter<fr::coordinates::ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count);
+    fr::coordinates::batch_converter<fr::coordinates::lat_long>().operator()<fr::coordinates::bowring_solver<2> >(x.data(), y.data(), z.data(), lat2.data(), lon2.data(), alt2.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(lat[i], lat2[i], .00000001);
+    }
+  }
+
+  void test_batch_eci_ecef()
+  {
+    double t = 1381968000.0;
+    std::vector<fr::coordinates::ecef_point> ecef(lat.size());
+    std::vector<fr::coordinates::tod_eci_point> eci(lat.size());
+    std::vector<fr::coordinates::ecef_point> back(lat.size());
+    for (size_t i = 0; i < lat.size(); ++i) {
+      ecef[i] = fr::coordinates::converter<fr::coordinates::ecef_point>()(fr::coordinates::lat_long(lat[i], lon[i], alt[i]));
+    }
+    fr::coordinates::batch_converter<fr::coordinates::tod_eci_point>()(ecef.data(), eci.data(), ecef.size(), t);
+    fr::coordinates::batch_converter<fr::coordinates::ecef_point>()(eci.data(), back.data(), eci.size(), t);
+    for (size_t i = 0; i < ecef.size(); ++i) {
+      fr::coordinates::tod_eci_point expected = fr::coordinates::converter<fr::coordinates::tod_eci_point>()(ecef[i], t);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.x, eci[i].x, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.y, eci[i].y, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.z, eci[i].z, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].x, back[i].x, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].y, back[i].y, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].z, back[i].z, .000001);
+    }
+  }
+
+  void test_batch_state_vectors()
+  {
+    double t = 1381968000.0;
+    fr::coordinates::eci_ecef_rotation r(t);
+    std::vector<fr::coordinates::tod_eci_vel_point> eci;
+    for (int i = 0; i < 100; ++i) {
+      eci.push_back(fr::coordinates::tod_eci_vel_point(7000000.0 - i * 1000.0, i * 5000.0, -i * 3000.0, i * 10.0, 7500.0 - i, i * 2.0));
+    }
+    std::vector<fr::coordinates::ecef_vel_point> ecef(eci.size());
+    std::vector<fr::coordinates::tod_eci_vel_point> back(eci.size());
+    fr::coordinates::batch_converter<fr::coordinates::ecef_vel_point>()(eci.data(), ecef.data(), eci.size(), r);
+    fr::coordinates::batch_converter<fr::coordinates::tod_eci_vel_point>()(ecef.data(), back.data(), ecef.size(), t);
+    fr::coordinates::eci_to_ecef cm(t);
+    for (size_t i = 0; i < eci.size(); ++i) {
+      // Check against the full 6x6 state matrix
+      Eigen::Matrix<double,6,1> expected = cm.get_xyz_vel() * eci[i].get_vector();
+      Eigen::Matrix<double,6,1> actual = ecef[i].get_vector();
+      Eigen::Matrix<double,6,1> original = eci[i].get_vector();
+      Eigen::Matrix<double,6,1> round_trip = back[i].get_vector();
+      for (int j = 0; j < 6; ++j) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(expected(j), actual(j), .000001);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(original(j), round_trip(j), .000001);
+      }
+    }
+  }
+
+  // Every point with its own time, spread over a couple of days so a
+  // bunch of hour angle interpolation segments get used. Evaluating
+  // GMST from a Julian date has around 1e-9 radians of rounding noise
+  // in it, which is a couple of centimeters out at 7000km, so that's
+  // as close as the interpolated angles can be expected to match.
+  void test_batch_timestamped()
+  {
+    std::vector<fr::coordinates::tod_eci_vel_point> eci;
+    std::vector<fr::coordinates::tod_eci_point> eci_pos;
+    std::vector<double> times;
+    for (int i = 0; i < 1000; ++i) {
+      eci.push_back(fr::coordinates::tod_eci_vel_point(7000000.0 - i * 1000.0, i * 5000.0, -i * 3000.0, i * 10.0, 7500.0 - i, i * 2.0));
+      eci_pos.push_back(fr::coordinates::tod_eci_point(eci.back().x, eci.back().y, eci.back().z));
+      times.push_back(1381968000.0 + (i * 7919 % 1000) * 173.3);
+    }
+    std::vector<fr::coordinates::ecef_vel_point> ecef(eci.size());
+    std::vector<fr::coordinates::ecef_point> ecef_pos(eci.size());
+    fr::coordinates::batch_converter<fr::coordinates::ecef_vel_point>()(eci.data(), times.data(), ecef.data(), eci.size());
+    fr::coordinates::batch_converter<fr::coordinates::ecef_point>()(eci_pos.data(), times.data(), ecef_pos.data(), eci_pos.size());
+    for (size_t i = 0; i < eci.size(); ++i) {
+      fr::coordinates::ecef_vel_point expected = fr::coordinates::converter<fr::coordinates::ecef_vel_point>()(eci[i], times[i]);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.x, ecef[i].x, .05);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.y, ecef[i].y, .05);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.z, ecef[i].z, .05);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.dx, ecef[i].dx, .0001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.dy, ecef[i].dy, .0001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.dz, ecef[i].dz, .0001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.x, ecef_pos[i].x, .05);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.y, ecef_pos[i].y, .05);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.z, ecef_pos[i].z, .05);
+    }
+  }
+
+  // A NaN time used to anchor the interpolator at NaN for good, so
+  // every later point came out NaN too
+  void test_batch_timestamped_nan()
+  {
+    std::vector<fr::coordinates::tod_eci_point> eci(3, fr::coordinates::tod_eci_point(7000000.0, 100.0, 2000.0));
+    std::vector<fr::coordinates::ecef_point> ecef(eci.size());
+    double times[] = { NAN, 1e9, 1e9 + 60.0 };
+    fr::coordinates::gha_interpolator gha;
+    CPPUNIT_ASSERT_THROW(fr::coordinates::batch_converter<fr::coordinates::ecef_point>()(eci.data(), times, ecef.data(), eci.size(), gha), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(gha(INFINITY), std::invalid_argument);
+    fr::coordinates::batch_converter<fr::coordinates::ecef_point>()(eci.data(), times + 1, ecef.data(), 2, gha);
+    for (size_t i = 0; i < 2; ++i) {
+      fr::coordinates::ecef_point expected = fr::coordinates::converter<fr::coordinates::ecef_point>()(eci[i], times[i + 1]);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.x, ecef[i].x, .05);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.y, ecef[i].y, .05);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.z, ecef[i].z, .05);
+    }
+    // Once anchored, a NaN still isn't let through
+    CPPUNIT_ASSERT_THROW(gha(NAN), std::invalid_argument);
+  }
+
+  void test_batch_float()
+  {
+    size_t count = lat.size();
+    std::vector<float> latf(lat.begin(), lat.end()), lonf(lon.begin(), lon.end()), altf(alt.begin(), alt.end());
+    std::vector<float> x(count), y(count), z(count), lat2(count), lon2(count), alt2(count);
+    fr::coordinates::batch_converter<fr::coordinates::ecef>()(latf.data(), lonf.data(), altf.data(), x.data(), y.data(), z.data(), count);
+    fr::coordinates::batch_converter<fr::coordinates::lat_long>()(x.data(), y.data(), z.data(), lat2.data(), lon2.data(), alt2.data(), count);
+    std::vector<float> lat3(count), lon3(count), alt3(count);
+    fr::coordinates::batch_converter<fr::coordinates::lat_long>()(x.data(), y.data(), z.data(), lat3.data(), lon3.data(), alt3.data(), count, fr::coordinates::WGS84_ELLIPSOID, fr::coordinates::bowring_solver<2>());
+    for (size_t i = 0; i < count; ++i) {
+      fr::coordinates::ecef expected = fr::coordinates::converter<fr::coordinates::ecef>()(fr::coordinates::lat_long(lat[i], lon[i], alt[i]));
+      // A couple of meters, mostly from rounding lat/lon to float
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_x(), x[i], 5.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_y(), y[i], 5.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_z(), z[i], 5.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(lat[i], lat2[i], .00005);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(lat[i], lat3[i], .00005);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(alt[i], alt2[i], 5.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(alt[i], alt3[i], 5.0);
+      if (fabs(lat[i]) < 90.0) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, remainder(lon[i] - lon2[i], 360.0), .00005);
+      }
+    }
+  }
+
+  // Float offsets from a nearby origin keep millimeters
+  void test_batch_local_origin()
+  {
+    fr::coordinates::ecef_point origin = fr::coordinates::converter<fr::coordinates::ecef_point>()(fr::coordinates::lat_long(39.75, -104.87, 1600.0));
+    size_t count = 1000;
+    std::vector<double> near_lat(count), near_lon(count), near_alt(count);
+    for (size_t i = 0; i < count; ++i) {
+      near_lat[i] = 39.7 + 0.1 * (double) ((i * 7919) % count) / (double) count;
+      near_lon[i] = -104.92 + 0.1 * (double) ((i * 104729) % count) / (double) count;
+      near_alt[i] = 1600.0 + (double) (i % 100) * 10.0;
+    }
+    std::vector<float> x(count), y(count), z(count);
+    fr::coordinates::batch_converter<fr::coordinates::ecef>()(near_lat.data(), near_lon.data(), near_alt.data(), x.data(), y.data(), z.data(), count, origin);
+    std::vector<double> lat2(count), lon2(count), alt2(count);
+    fr::coordinates::batch_converter<fr::coordinates::lat_long>()(x.data(), y.data(), z.data(), lat2.data(), lon2.data(), alt2.data(), count, origin);
+    for (size_t i = 0; i < count; ++i) {
+      fr::coordinates::ecef expected = fr::coordinates::converter<fr::coordinates::ecef>()(fr::coordinates::lat_long(near_lat[i], near_lon[i], near_alt[i]));
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_x() - origin.x, x[i], .001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_y() - origin.y, y[i], .001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_z() - origin.z, z[i], .001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(near_lat[i], lat2[i], .00000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(near_lon[i], lon2[i], .00000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(near_alt[i], alt2[i], .001);
+    }
+  }
+
+  // The rotation and local frame kernels take the float point types,
+  // rotate in double and round on the way out, so they should land
+  // within a float ulp or so of the double kernels
+  void test_batch_float_rotations()
+  {
+    double t = 1381968000.0;
+    std::vector<fr::coordinates::tod_eci_vel_point> eci;
+    std::vector<fr::coordinates::tod_eci_vel_point_f> eci_f;
+    std::vector<fr::coordinates::tod_eci_point_f> eci_pos_f;
+    std::vector<double> times;
+    for (int i = 0; i < 100; ++i) {
+      eci.push_back(fr::coordinates::tod_eci_vel_point(7000000.0 - i * 1000.0, i * 5000.0, -i * 3000.0, i * 10.0, 7500.0 - i, i * 2.0));
+      eci_f.push_back(fr::coordinates::tod_eci_vel_point_f(eci.back().x, eci.back().y, eci.back().z, eci.back().dx, eci.back().dy, eci.back().dz));
+      eci_pos_f.push_back(fr::coordinates::tod_eci_point_f(eci_f.back().x, eci_f.back().y, eci_f.back().z));
+      times.push_back(t + i * 60.0);
+    }
+    size_t count = eci.size();
+    std::vector<fr::coordinates::ecef_vel_point> ecef(count);
+    std::vector<fr::coordinates::ecef_vel_point_f> ecef_f(count);
+    std::vector<fr::coordinates::tod_eci_vel_point_f> back_f(count);
+    std::vector<fr::coordinates::ecef_point_f> ecef_pos_f(count), stamped_f(count), chain_f(count);
+    std::vector<fr::coordinates::tod_eci_point_f> back_pos_f(count);
+    fr::coordinates::batch_converter<fr::coordinates::ecef_vel_point>()(eci.data(), ecef.data(), count, t);
+    fr::coordinates::batch_converter<fr::coordinates::ecef_vel_point_f>()(eci_f.data(), ecef_f.data(), count, t);
+    fr::coordinates::batch_converter<fr::coordinates::tod_eci_vel_point_f>()(ecef_f.data(), back_f.data(), count, t);
+    fr::coordinates::batch_converter<fr::coordinates::ecef_point_f>()(eci_pos_f.data(), ecef_pos_f.data(), count, t);
+    fr::coordinates::batch_converter<fr::coordinates::tod_eci_point_f>()(ecef_pos_f.data(), back_pos_f.data(), count, t);
+    fr::coordinates::batch_converter<fr::coordinates::ecef_point_f>()(eci_pos_f.data(), times.data(), stamped_f.data(), count);
+    fr::coordinates::frame_rotation r(t);
+    std::vector<fr::coordinates::xyz_point<fr::coordinates::teme_frame, float> > teme_f(count);
+    std::vector<fr::coordinates::xyz_point<fr::coordinates::j2000_frame, float> > j2000_f(count);
+    std::vector<fr::coordinates::teme_point> teme(count);
+    for (size_t i = 0; i < count; ++i) {
+      teme_f[i] = fr::coordinates::xyz_point<fr::coordinates::teme_frame, float>(eci_f[i].x, eci_f[i].y, eci_f[i].z);
+      teme[i] = fr::coordinates::teme_point(eci_f[i].x, eci_f[i].y, eci_f[i].z);
+    }
+    fr::coordinates::batch_converter<fr::coordinates::j2000_point>()(teme_f.data(), j2000_f.data(), count, r);
+    fr::coordinates::batch_converter<fr::coordinates::ecef_point_f>()(j2000_f.data(), chain_f.data(), count, r);
+    std::vector<fr::coordinates::ecef_point> chain(count);
+    fr::coordinates::batch_converter<fr::coordinates::ecef_point>()(teme.data(), chain.data(), count, r);
+    for (size_t i = 0; i < count; ++i) {
+      fr::coordinates::ecef_vel_point expected = fr::coordinates::converter<fr::coordinates::ecef_vel_point>()(eci[i], times[i]);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].x, ecef_f[i].x, 1.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].y, ecef_f[i].y, 1.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].z, ecef_f[i].z, 1.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].dx, ecef_f[i].dx, .01);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].dy, ecef_f[i].dy, .01);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].dz, ecef_f[i].dz, .01);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].x, ecef_pos_f[i].x, 1.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].y, ecef_pos_f[i].y, 1.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].z, ecef_pos_f[i].z, 1.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(eci[i].x, back_f[i].x, 1.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(eci[i].dy, back_f[i].dy, .01);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(eci[i].z, back_pos_f[i].z, 1.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.x, stamped_f[i].x, 1.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.y, stamped_f[i].y, 1.0);
+      // TEME to J2000 and back through the chain to ECEF
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(chain[i].x, chain_f[i].x, 2.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(chain[i].y, chain_f[i].y, 2.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(chain[i].z, chain_f[i].z, 2.0);
+    }
+
+    // Local frames, from ecef_point_f and from float lat/long
+    fr::coordinates::local_frame f(fr::coordinates::lat_long(39.75, -104.87, 1600.0));
+    std::vector<fr::coordinates::ecef_point_f> near_f(lat.size());
+    std::vector<float> latf(lat.begin(), lat.end()), lonf(lon.begin(), lon.end()), altf(alt.begin(), alt.end());
+    std::vector<fr::coordinates::enu_point_f> enu_f(lat.size()), enu_ll_f(lat.size());
+    std::vector<fr::coordinates::ned_point_f> ned_f(lat.size());
+    std::vector<fr::coordinates::ecef_point_f> round_f(lat.size());
+    for (size_t i = 0; i < lat.size(); ++i) {
+      fr::coordinates::ecef_point p = fr::coordinates::converter<fr::coordinates::ecef_point>()(fr::coordinates::lat_long(latf[i], lonf[i], altf[i]));
+      near_f[i] = fr::coordinates::ecef_point_f(p.x, p.y, p.z);
+    }
+    fr::coordinates::batch_converter<fr::coordinates::enu_point_f>()(near_f.data(), enu_f.data(), near_f.size(), f);
+    fr::coordinates::batch_converter<fr::coordinates::ned_point_f>()(near_f.data(), ned_f.data(), near_f.size(), f);
+    fr::coordinates::batch_converter<fr::coordinates::enu_point_f>()(latf.data(), lonf.data(), altf.data(), enu_ll_f.data(), latf.size(), f);
+    fr::coordinates::batch_converter<fr::coordinates::ecef_point_f>()(enu_f.data(), round_f.data(), enu_f.size(), f);
+    for (size_t i = 0; i < lat.size(); ++i) {
+      fr::coordinates::enu_point expected = f.to_local<fr::coordinates::enu_frame>(fr::coordinates::ecef_point(near_f[i].x, near_f[i].y, near_f[i].z).map_xyz());
+      double tolerance = 1.0 + 1e-7 * fabs(expected.x) + 1e-7 * fabs(expected.y) + 1e-7 * fabs(expected.z);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.x, enu_f[i].x, tolerance);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.y, enu_f[i].y, tolerance);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.z, enu_f[i].z, tolerance);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.y, ned_f[i].x, tolerance);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(-expected.z, ned_f[i].z, tolerance);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.x, enu_ll_f[i].x, tolerance);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.z, enu_ll_f[i].z, tolerance);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(near_f[i].x, round_f[i].x, tolerance);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(near_f[i].z, round_f[i].z, tolerance);
+    }
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(batch_converter_test);
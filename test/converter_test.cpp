@@ -18,8 +18,10 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 #include "coordinates.hpp"
+#include <cmath>
 #include <iostream>
 #include <iomanip>
+#include <stdexcept>
 
 class converter_test : public CppUnit::TestFixture
 {
@@ -27,6 +29,10 @@ class converter_test : public CppUnit::TestFixture
   CPPUNIT_TEST(test_to_latlong);
   CPPUNIT_TEST(test_to_ecef);
   CPPUNIT_TEST(test_eci_to_ecef);
+  CPPUNIT_TEST(test_points);
+  CPPUNIT_TEST(test_rotation_context);
+  CPPUNIT_TEST(test_datums);
+  CPPUNIT_TEST(test_maps);
   CPPUNIT_TEST_SUITE_END();
 public:
   
@@ -89,6 +95,145 @@ public:
     CPPUNIT_ASSERT(denver_ecef.get_z() - denver2_ecef.get_z() < .000001);
   }
 
+  // The value types should convert the same as the classes do
+  void test_points()
+  {
+    CPPUNIT_ASSERT(std::is_trivially_copyable<fr::coordinates::lat_long>::value);
+    CPPUNIT_ASSERT(sizeof(fr::coordinates::tod_eci_point) == 24);
+
+    fr::coordinates::lat_long denver(39.75, 104.87, 1609.344);
+    fr::coordinates::ecef denver_ecef = fr::coordinates::converter<fr::coordinates::ecef>()(denver);
+    fr::coordinates::ecef_point denver_point = fr::coordinates::converter<fr::coordinates::ecef_point>()(denver);
+    CPPUNIT_ASSERT(denver_ecef.get_x() == denver_point.x);
+    CPPUNIT_ASSERT(denver_ecef.get_y() == denver_point.y);
+    CPPUNIT_ASSERT(denver_ecef.get_z() == denver_point.z);
+
+    fr::coordinates::lat_long denver2 = fr::coordinates::converter<fr::coordinates::lat_long>()(denver_point);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(denver.get_lat(), denver2.get_lat(), .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(denver.get_long(), denver2.get_long(), .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(denver.get_alt(), denver2.get_alt(), .000001);
+
+    fr::coordinates::tod_eci denver_eci = fr::coordinates::converter<fr::coordinates::tod_eci>()(denver_ecef, 1000.0);
+    fr::coordinates::tod_eci_point denver_eci_point = fr::coordinates::converter<fr::coordinates::tod_eci_point>()(denver_point, 1000.0);
+    CPPUNIT_ASSERT(denver_eci.get_x() == denver_eci_point.x);
+    CPPUNIT_ASSERT(denver_eci.get_y() == denver_eci_point.y);
+    CPPUNIT_ASSERT(denver_eci.get_z() == denver_eci_point.z);
+    fr::coordinates::ecef back = fr::coordinates::converter<fr::coordinates::ecef>()(denver_eci_point, 1000.0);
+    fr::coordinates::ecef_point back_point = fr::coordinates::converter<fr::coordinates::ecef_point>()(denver_eci_point, 1000.0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(denver_point.x, back.get_x(), .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(denver_point.y, back_point.y, .000001);
+
+    fr::coordinates::tod_eci_vel_point sat(7000000.0, 0.0, 0.0, 0.0, 7500.0, 0.0);
+    fr::coordinates::tod_eci_vel sat_class = fr::coordinates::converter<fr::coordinates::tod_eci_vel>()(sat);
+    fr::coordinates::ecef_vel sat_ecef = fr::coordinates::converter<fr::coordinates::ecef_vel>()(sat_class, 1000.0);
+    fr::coordinates::ecef_vel_point sat_ecef_point = fr::coordinates::converter<fr::coordinates::ecef_vel_point>()(sat, 1000.0);
+    CPPUNIT_ASSERT(sat_ecef.get_x() == sat_ecef_point.x);
+    CPPUNIT_ASSERT(sat_ecef.get_dy() == sat_ecef_point.dy);
+    fr::coordinates::tod_eci_vel_point sat2 = fr::coordinates::converter<fr::coordinates::tod_eci_vel_point>()(sat_ecef_point, 1000.0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(sat.x, sat2.x, .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(sat.dy, sat2.dy, .000001);
+  }
+
+  // Conversions with a precomputed rotation context should match the
+  // ones that take a time
+  void test_rotation_context()
+  {
+    double t = 1381968000.0;
+    fr::coordinates::rotation_cache cache(2);
+    const fr::coordinates::eci_ecef_rotation &r = cache.get(t);
+    CPPUNIT_ASSERT(r.get_time() == t);
+    CPPUNIT_ASSERT(&cache.get(t) == &r);
+    CPPUNIT_ASSERT(cache.hits() == 1 && cache.misses() == 1);
+
+    fr::coordinates::ecef denver_ecef(-1260484.206487,4747249.668167,4057711.884932);
+    fr::coordinates::tod_eci by_time = fr::coordinates::converter<fr::coordinates::tod_eci>()(denver_ecef, t);
+    fr::coordinates::tod_eci by_context = fr::coordinates::converter<fr::coordinates::tod_eci>()(denver_ecef, r);
+    CPPUNIT_ASSERT(by_time.get_x() == by_context.get_x());
+    CPPUNIT_ASSERT(by_time.get_y() == by_context.get_y());
+    CPPUNIT_ASSERT(by_time.get_z() == by_context.get_z());
+    fr::coordinates::ecef back = fr::coordinates::converter<fr::coordinates::ecef>()(by_context, r);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(denver_ecef.get_x(), back.get_x(), .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(denver_ecef.get_y(), back.get_y(), .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(denver_ecef.get_z(), back.get_z(), .000001);
+
+    // The block multiply should agree with the full 6x6 state matrix
+    fr::coordinates::tod_eci_vel sat(7000000.0, 100.0, 2000.0, 10.0, 7500.0, 5.0);
+    fr::coordinates::eci_to_ecef cm(t);
+    Eigen::Matrix<double,6,1> expected = cm.get_xyz_vel() * sat.get_vector();
+    fr::coordinates::ecef_vel sat_ecef = fr::coordinates::converter<fr::coordinates::ecef_vel>()(sat, r);
+    Eigen::Matrix<double,6,1> actual = sat_ecef.get_vector();
+    for (int i = 0; i < 6; ++i) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected(i), actual(i), .000001);
+    }
+    fr::coordinates::tod_eci_vel sat2 = fr::coordinates::converter<fr::coordinates::tod_eci_vel>()(sat_ecef, cache.get(t));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(sat.get_x(), sat2.get_x(), .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(sat.get_dy(), sat2.get_dy(), .000001);
+
+    fr::coordinates::lat_long sat_ll = fr::coordinates::converter<fr::coordinates::lat_long>()(sat, r);
+    fr::coordinates::lat_long sat_ll2 = fr::coordinates::converter<fr::coordinates::lat_long>()(sat, t);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(sat_ll.get_lat(), sat_ll2.get_lat(), .000001);
+
+    // Eviction
+    cache.get(t + 1.0);
+    cache.get(t + 2.0);
+    CPPUNIT_ASSERT(cache.size() == 2);
+    cache.get(t);
+    CPPUNIT_ASSERT(cache.misses() == 4);
+
+    CPPUNIT_ASSERT_THROW(fr::coordinates::rotation_cache empty(0), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(cache.get(NAN), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(cache.get(INFINITY), std::invalid_argument);
+    CPPUNIT_ASSERT(cache.size() == 2 && cache.misses() == 4);
+  }
+
+  void test_datums()
+  {
+    static_assert(fr::coordinates::WGS84_ELLIPSOID.be > 6356752.3 && fr::coordinates::WGS84_ELLIPSOID.be < 6356752.4, "WGS84 semi-minor axis should be computed at compile time");
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(298.257223563, 1.0 / fr::coordinates::WGS84_ELLIPSOID.f, .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(6356583.8, fr::coordinates::CLARKE1866_ELLIPSOID.be, .0001);
+
+    fr::coordinates::lat_long denver(39.75, 104.87, 1609.344);
+    fr::coordinates::ecef runtime = fr::coordinates::converter<fr::coordinates::ecef>()(denver);
+    fr::coordinates::ecef folded = fr::coordinates::converter<fr::coordinates::ecef, fr::coordinates::wgs84>()(denver);
+    CPPUNIT_ASSERT(runtime.get_x() == folded.get_x());
+    CPPUNIT_ASSERT(runtime.get_y() == folded.get_y());
+    CPPUNIT_ASSERT(runtime.get_z() == folded.get_z());
+
+    // GRS80 and WGS84 differ by a tenth of a millimeter or so
+    fr::coordinates::ecef_point grs80 = fr::coordinates::converter<fr::coordinates::ecef_point, fr::coordinates::grs80>()(denver);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(runtime.get_z(), grs80.z, .001);
+
+    fr::coordinates::ecef clarke = fr::coordinates::converter<fr::coordinates::ecef, fr::coordinates::clarke1866>()(denver);
+    fr::coordinates::lat_long denver2 = fr::coordinates::converter<fr::coordinates::lat_long, fr::coordinates::clarke1866>()(clarke);
+    CPPUNIT_ASSERT(fabs(runtime.get_z() - clarke.get_z()) > 1.0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(denver.get_lat(), denver2.get_lat(), .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(denver.get_long(), denver2.get_long(), .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(denver.get_alt(), denver2.get_alt(), .000001);
+  }
+
+  // The maps are views of the point's own storage, and the rotation
+  // context paths match the 6x6 matrix they replaced
+  void test_maps()
+  {
+    fr::coordinates::tod_eci_vel_point sat(7000000.0, 10000.0, 200000.0, -10.0, 7500.0, 30.0);
+    sat.map_xyz()(1) = 20000.0;
+    sat.map_deltas() *= 2.0;
+    CPPUNIT_ASSERT(sat.y == 20000.0);
+    CPPUNIT_ASSERT(sat.dy == 15000.0);
+    CPPUNIT_ASSERT(sat.map_vector()(5) == 60.0);
+
+    fr::coordinates::eci_to_ecef m(1000.0);
+    Eigen::Matrix<double,6,1> expected = m.get_xyz_vel() * sat.get_vector();
+    fr::coordinates::ecef_vel_point sat_ecef = fr::coordinates::converter<fr::coordinates::ecef_vel_point>()(sat, 1000.0);
+    for (int i = 0; i < 6; ++i) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected(i), sat_ecef.map_vector()(i), .000001);
+    }
+
+    fr::coordinates::ecef_vel sat_class = fr::coordinates::converter<fr::coordinates::ecef_vel>()(sat, 1000.0);
+    CPPUNIT_ASSERT(sat_class.map_xyz() == sat_ecef.map_xyz());
+    CPPUNIT_ASSERT(sat_class.map_deltas() == sat_ecef.map_deltas());
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(converter_test);
@@ -0,0 +1,164 @@
+/**
+ * Writes and reads back coordinate files, and runs the batch
+ * converters straight off the mapped columns
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "coordinate_file.hpp"
+#include "coordinates.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class coordinate_file_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(coordinate_file_test);
+  CPPUNIT_TEST(test_round_trip);
+  CPPUNIT_TEST(test_convert_in_place);
+  CPPUNIT_TEST(test_bad_files);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::string path;
+  std::string path2;
+
+public:
+
+  void setUp()
+  {
+    path = "/tmp/coordinate_file_test." + std::to_string(getpid());
+    path2 = path + ".ecef";
+  }
+
+  void tearDown()
+  {
+    remove(path.c_str());
+    remove(path2.c_str());
+  }
+
+  void test_round_trip()
+  {
+    size_t count = 1001;
+    {
+      fr::coordinates::coordinate_file_writer writer(path, fr::coordinates::coordinate_file::tod_eci_vel_frame, count, true, 1381968000.0, fr::coordinates::GRS80_ELLIPSOID);
+      CPPUNIT_ASSERT_EQUAL((unsigned) 6, writer.columns());
+      for (unsigned c = 0; c < 6; ++c) {
+	double *column = writer.get_column(c);
+	for (size_t i = 0; i < count; ++i) {
+	  column[i] = (double) (c * 100000 + i);
+	}
+      }
+      double *times = writer.get_times();
+      for (size_t i = 0; i < count; ++i) {
+	times[i] = 1381968000.0 + (double) i;
+      }
+      writer.flush();
+    }
+    fr::coordinates::coordinate_file_reader reader(path);
+    CPPUNIT_ASSERT_EQUAL(fr::coordinates::coordinate_file::tod_eci_vel_frame, reader.get_frame());
+    CPPUNIT_ASSERT_EQUAL(count, reader.size());
+    CPPUNIT_ASSERT(reader.has_times());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1381968000.0, reader.get_epoch(), 0.0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(fr::coordinates::GRS80_ELLIPSOID.ee, reader.get_ellipsoid().ee, 0.0);
+    for (unsigned c = 0; c < 6; ++c) {
+      fr::coordinates::column_span column = reader.get_column(c);
+      CPPUNIT_ASSERT_EQUAL(count, column.size);
+      // Columns are aligned for vector loads
+      CPPUNIT_ASSERT((reinterpret_cast<size_t>(column.data) % 64) == 0);
+      for (size_t i = 0; i < count; ++i) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL((double) (c * 100000 + i), column[i], 0.0);
+      }
+    }
+    fr::coordinates::column_span times = reader.get_times();
+    CPPUNIT_ASSERT_EQUAL(count, times.size);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1381968000.0 + 1000.0, times[1000], 0.0);
+  }
+
+  // lat_long file converted into a new ecef file, column to column
+  void test_convert_in_place()
+  {
+    const double lats[] = { 39.75, -33.86, 0.0, 90.0, -90.0, 51.48, 64.2, -12.5 };
+    const double lons[] = { 104.87, 151.21, 0.0, 0.0, 45.0, -0.0015, 180.0, -179.99 };
+    const double alts[] = { 1609.344, 58.0, 0.0, 0.0, -42.0, 45.0, 400000.0, 35786000.0 };
+    {
+      fr::coordinates::coordinate_file_writer writer(path, fr::coordinates::coordinate_file::lat_long_frame, 8);
+      std::copy(lats, lats + 8, writer.get_column(fr::coordinates::coordinate_file::lat));
+      std::copy(lons, lons + 8, writer.get_column(fr::coordinates::coordinate_file::lon));
+      std::copy(alts, alts + 8, writer.get_column(fr::coordinates::coordinate_file::alt));
+      CPPUNIT_ASSERT(writer.get_times() == nullptr);
+    }
+    fr::coordinates::coordinate_file_reader reader(path);
+    CPPUNIT_ASSERT(!reader.has_times());
+    CPPUNIT_ASSERT(reader.get_times().data == nullptr);
+    {
+      fr::coordinates::coordinate_file_writer writer(path2, fr::coordinates::coordinate_file::ecef_position_frame, reader.size());
+      fr::coordinates::batch_converter<fr::coordinates::ecef>()(reader.get_column(fr::coordinates::coordinate_file::lat).data, reader.get_column(fr::coordinates::coordinate_file::lon).data, reader.get_column(fr::coordinates::coordinate_file::alt).data,
+								writer.get_column(fr::coordinates::coordinate_file::x), writer.get_column(fr::coordinates::coordinate_file::y), writer.get_column(fr::coordinates::coordinate_file::z), reader.size(), reader.get_ellipsoid());
+    }
+    fr::coordinates::coordinate_file_reader ecef_reader(path2);
+    for (size_t i = 0; i < 8; ++i) {
+      fr::coordinates::ecef expected = fr::coordinates::converter<fr::coordinates::ecef>()(fr::coordinates::lat_long(lats[i], lons[i], alts[i]));
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_x(), ecef_reader.get_column(fr::coordinates::coordinate_file::x)[i], .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_y(), ecef_reader.get_column(fr::coordinates::coordinate_file::y)[i], .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_z(), ecef_reader.get_column(fr::coordinates::coordinate_file::z)[i], .000001);
+    }
+  }
+
+  void test_bad_files()
+  {
+    CPPUNIT_ASSERT_THROW(fr::coordinates::coordinate_file_reader("/nonexistent/coordinates"), std::runtime_error);
+    {
+      std::ofstream junk(path.c_str());
+      junk << "This is not a coordinate file, but it's long enough that the header check is what catches it. "
+	   << "Padding padding padding padding padding padding padding padding padding." << std::endl;
+    }
+    CPPUNIT_ASSERT_THROW(fr::coordinates::coordinate_file_reader reader(path), std::runtime_error);
+    {
+      fr::coordinates::coordinate_file_writer writer(path, fr::coordinates::coordinate_file::ecef_position_frame, 1000);
+    }
+    // Chop off the end of the last column
+    CPPUNIT_ASSERT_EQUAL(0, truncate(path.c_str(), 128 + 8000 * 2 + 4000));
+    CPPUNIT_ASSERT_THROW(fr::coordinates::coordinate_file_reader reader(path), std::runtime_error);
+
+    // A count big enough to wrap the column stride around to 0
+    {
+      fr::coordinates::coordinate_file_writer writer(path, fr::coordinates::coordinate_file::ecef_position_frame, 1000);
+    }
+    {
+      std::fstream patch(path.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+      uint64_t count = (uint64_t) 1 << 61;
+      patch.seekp(offsetof(fr::coordinates::coordinate_file::header, count));
+      patch.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    }
+    CPPUNIT_ASSERT_THROW(fr::coordinates::coordinate_file_reader reader(path), std::runtime_error);
+
+    // Columns past the end
+    {
+      fr::coordinates::coordinate_file_writer writer(path, fr::coordinates::coordinate_file::ecef_position_frame, 10, true);
+      CPPUNIT_ASSERT_THROW(writer.get_column(3), std::out_of_range);
+      CPPUNIT_ASSERT(writer.get_times() != nullptr);
+    }
+    fr::coordinates::coordinate_file_reader reader(path);
+    CPPUNIT_ASSERT_THROW(reader.get_column(3), std::out_of_range);
+    CPPUNIT_ASSERT(reader.get_times().size == 10);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(coordinate_file_test);
@@ -0,0 +1,223 @@
+/**
+ * Checks ephemeris lookups against finding the bracketing samples by
+ * hand and calling tod_eci_vel::interpolate
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "ephemeris.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+class ephemeris_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(ephemeris_test);
+  CPPUNIT_TEST(test_find);
+  CPPUNIT_TEST(test_interpolate);
+  CPPUNIT_TEST(test_cursor);
+  CPPUNIT_TEST(test_hermite);
+  CPPUNIT_TEST_SUITE_END();
+
+  fr::coordinates::ephemeris eph;
+  std::vector<fr::coordinates::tod_eci_vel> samples;
+  std::vector<double> sample_times;
+
+  // Low earth orbit, one sample a minute for a couple of hours
+  static fr::coordinates::tod_eci_vel orbit(double t)
+  {
+    double r = 6778137.0;
+    double w = 0.00113;
+    double v = r * w;
+    return fr::coordinates::tod_eci_vel(r * cos(w * t), r * sin(w * t) * 0.9, r * sin(w * t) * 0.43589, -v * sin(w * t), v * cos(w * t) * 0.9, v * cos(w * t) * 0.43589);
+  }
+
+  // What the caller had to do before
+  fr::coordinates::tod_eci_vel by_hand(double t)
+  {
+    size_t i = 0;
+    while (i + 2 < sample_times.size() && t >= sample_times[i + 1]) {
+      ++i;
+    }
+    return samples[i].interpolate(sample_times[i], samples[i + 1], sample_times[i + 1], t);
+  }
+
+  static void check(const fr::coordinates::tod_eci_vel &expected, const fr::coordinates::tod_eci_vel_point &got)
+  {
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_x(), got.x, .00001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_y(), got.y, .00001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_z(), got.z, .00001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_dx(), got.dx, .0000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_dy(), got.dy, .0000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_dz(), got.dz, .0000001);
+  }
+
+public:
+
+  void setUp()
+  {
+    eph = fr::coordinates::ephemeris();
+    samples.clear();
+    sample_times.clear();
+    for (int i = 0; i <= 120; ++i) {
+      double t = 1381968000.0 + 60.0 * (double) i;
+      samples.push_back(orbit(t - 1381968000.0));
+      sample_times.push_back(t);
+      eph.push_back(t, samples.back());
+    }
+  }
+
+  void test_find()
+  {
+    CPPUNIT_ASSERT_EQUAL((size_t) 121, eph.size());
+    CPPUNIT_ASSERT_EQUAL((size_t) 120, eph.segments());
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, eph.find(0.0));
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, eph.find(sample_times[0]));
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, eph.find(sample_times[1] - 0.001));
+    CPPUNIT_ASSERT_EQUAL((size_t) 1, eph.find(sample_times[1]));
+    CPPUNIT_ASSERT_EQUAL((size_t) 57, eph.find(sample_times[57] + 30.0));
+    CPPUNIT_ASSERT_EQUAL((size_t) 119, eph.find(sample_times[120]));
+    CPPUNIT_ASSERT_EQUAL((size_t) 119, eph.find(sample_times[120] + 1000.0));
+    // Out of order or repeated samples are rejected and leave it alone
+    CPPUNIT_ASSERT_THROW(eph.push_back(sample_times[120], samples[0]), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(eph.push_back(sample_times[3], samples[0]), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(eph.push_back(NAN, samples[0]), std::invalid_argument);
+    CPPUNIT_ASSERT_EQUAL((size_t) 121, eph.size());
+    // Too few samples to bracket anything
+    fr::coordinates::ephemeris small;
+    CPPUNIT_ASSERT_THROW(small.find(0.0), std::out_of_range);
+    CPPUNIT_ASSERT_THROW(small.interpolate(0.0), std::out_of_range);
+    small.push_back(sample_times[0], samples[0]);
+    CPPUNIT_ASSERT_THROW(small.interpolate(sample_times[0]), std::out_of_range);
+    small.push_back(sample_times[1], samples[1]);
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, small.find(sample_times[0]));
+  }
+
+  void test_interpolate()
+  {
+    // Scattered times, including the samples themselves and a bit off
+    // each end
+    std::vector<double> times;
+    for (int i = 0; i < 500; ++i) {
+      times.push_back(sample_times[0] - 30.0 + (double) ((i * 7919) % 7260));
+    }
+    times.push_back(sample_times[0]);
+    times.push_back(sample_times[60]);
+    times.push_back(sample_times[120]);
+    std::vector<fr::coordinates::tod_eci_vel_point> batch(times.size());
+    eph.interpolate(times.data(), batch.data(), times.size());
+    for (size_t i = 0; i < times.size(); ++i) {
+      fr::coordinates::tod_eci_vel expected = by_hand(times[i]);
+      check(expected, eph.interpolate(times[i]));
+      check(expected, batch[i]);
+    }
+  }
+
+  void test_cursor()
+  {
+    // Monotonic stream, ten lookups per segment
+    fr::coordinates::ephemeris::cursor c(eph);
+    std::vector<double> times;
+    for (int i = 0; i < 1200; ++i) {
+      times.push_back(sample_times[0] + 6.0 * (double) i + 0.5);
+    }
+    for (size_t i = 0; i < times.size(); ++i) {
+      check(by_hand(times[i]), c(times[i]));
+      CPPUNIT_ASSERT_EQUAL(eph.find(times[i]), c.seek(times[i]));
+    }
+    // Going backwards falls back to the binary search
+    check(by_hand(times[3]), c(times[3]));
+    std::vector<fr::coordinates::tod_eci_vel_point> batch(times.size());
+    c(times.data(), batch.data(), times.size());
+    for (size_t i = 0; i < times.size(); ++i) {
+      check(by_hand(times[i]), batch[i]);
+    }
+  }
+
+  // Orbit with eccentricity 0.1, where the slerp interpolation's
+  // linear change in radius isn't good enough
+  static fr::coordinates::tod_eci_vel_point kepler(double t)
+  {
+    double mu = 3.986004418e14;
+    double a = 7500000.0;
+    double e = 0.1;
+    double n = sqrt(mu / (a * a * a));
+    double m = n * t;
+    double ea = m;
+    for (int i = 0; i < 20; ++i) {
+      ea -= (ea - e * sin(ea) - m) / (1.0 - e * cos(ea));
+    }
+    double b = a * sqrt(1.0 - e * e);
+    double d = 1.0 - e * cos(ea);
+    double px = a * (cos(ea) - e);
+    double py = b * sin(ea);
+    double vx = -a * n * sin(ea) / d;
+    double vy = b * n * cos(ea) / d;
+    return fr::coordinates::tod_eci_vel_point(px, py * cos(0.9), py * sin(0.9), vx, vy * cos(0.9), vy * sin(0.9));
+  }
+
+  static double worst_error(const fr::coordinates::ephemeris &e, double &worst_velocity)
+  {
+    double worst = 0.0;
+    worst_velocity = 0.0;
+    for (double t = 0.0; t < 6000.0; t += 7.3) {
+      fr::coordinates::tod_eci_vel_point expected = kepler(t);
+      fr::coordinates::tod_eci_vel_point got = e.interpolate(t);
+      worst = std::max(worst, (got.get_xyz() - expected.get_xyz()).norm());
+      worst_velocity = std::max(worst_velocity, (got.get_deltas() - expected.get_deltas()).norm());
+    }
+    return worst;
+  }
+
+  void test_hermite()
+  {
+    fr::coordinates::ephemeris fine, fine_hermite(fr::coordinates::ephemeris::hermite), coarse_hermite(fr::coordinates::ephemeris::hermite);
+    for (int i = 0; i <= 100; ++i) {
+      fine.push_back(60.0 * (double) i, kepler(60.0 * (double) i));
+      fine_hermite.push_back(60.0 * (double) i, kepler(60.0 * (double) i));
+    }
+    for (int i = 0; i <= 20; ++i) {
+      coarse_hermite.push_back(300.0 * (double) i, kepler(300.0 * (double) i));
+    }
+    // Measured: slerp at 60s is off by 666m and .43m/s, Hermite at 60s
+    // by .5m and .025m/s, Hermite at 300s by 306m and 3.1m/s
+    double fine_velocity, fine_hermite_velocity, coarse_hermite_velocity;
+    double fine_error = worst_error(fine, fine_velocity);
+    double fine_hermite_error = worst_error(fine_hermite, fine_hermite_velocity);
+    double coarse_hermite_error = worst_error(coarse_hermite, coarse_hermite_velocity);
+    CPPUNIT_ASSERT(fine_hermite_error < 1.0);
+    CPPUNIT_ASSERT(fine_hermite_velocity < .05);
+    CPPUNIT_ASSERT(coarse_hermite_error < fine_error);
+    CPPUNIT_ASSERT(fine_hermite_error * 100.0 < fine_error);
+
+    // Batch and cursor lookups go through the same segments
+    std::vector<double> times;
+    for (int i = 0; i < 1000; ++i) {
+      times.push_back((double) ((i * 7919) % 6000));
+    }
+    std::vector<fr::coordinates::tod_eci_vel_point> batch(times.size());
+    coarse_hermite.interpolate(times.data(), batch.data(), times.size());
+    for (size_t i = 0; i < times.size(); ++i) {
+      size_t s = coarse_hermite.find(times[i]);
+      fr::coordinates::tod_eci_vel expected = coarse_hermite.get_hermite_segment(s).interpolate(times[i]);
+      check(expected, batch[i]);
+    }
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ephemeris_test);
@@ -0,0 +1,159 @@
+/**
+ * Tests the fast_math policy against the standard library, and the
+ * kernels that take a math policy
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "coordinates.hpp"
+#include "haversine_distance.hpp"
+#include <cmath>
+#include <vector>
+
+class fast_math_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(fast_math_test);
+  CPPUNIT_TEST(test_trig);
+  CPPUNIT_TEST(test_inverse_trig);
+  CPPUNIT_TEST(test_batch);
+  CPPUNIT_TEST(test_kernels);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+
+  void test_trig()
+  {
+    typedef fr::coordinates::fast_math fm;
+    // A sweep across a few dozen quadrants, then some large arguments.
+    // About 1e-16 at -O2; -ffast-math loosens the range reduction.
+    for (int i = -20000; i <= 20000; ++i) {
+      double x = i * 0.00371;
+      double s, c;
+      fm::sincos(x, s, c);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(std::sin(x), s, 1e-14);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(std::cos(x), c, 1e-14);
+    }
+    for (int i = 0; i < 1000; ++i) {
+      double x = -1e5 + i * 200.3;
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(std::sin(x), fm::sin(x), 1e-10);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(std::cos(x), fm::cos(x), 1e-10);
+    }
+    // Exact where it matters
+    CPPUNIT_ASSERT_EQUAL(0.0, fm::sin(0.0));
+    CPPUNIT_ASSERT_EQUAL(1.0, fm::cos(0.0));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, fm::sin(fr::constants::pi / 2.0), 1e-16);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, fm::cos(fr::constants::pi), 1e-16);
+    // Floats go through the same code
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(std::sin(0.7f), fm::sin(0.7f), 1e-7);
+  }
+
+  void test_inverse_trig()
+  {
+    typedef fr::coordinates::fast_math fm;
+    const double pi = fr::constants::pi;
+    for (int i = 0; i < 360; ++i) {
+      double a = (i - 180) * pi / 180.0 + 0.001;
+      for (double r = 1e-6; r < 1e7; r *= 10.0) {
+	double y = r * std::sin(a);
+	double x = r * std::cos(a);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(std::atan2(y, x), fm::atan2(y, x), 1e-15);
+      }
+    }
+    // Axes and signed zeros, same as the library
+    CPPUNIT_ASSERT_EQUAL(0.0, fm::atan2(0.0, 0.0));
+    CPPUNIT_ASSERT_EQUAL(pi, fm::atan2(0.0, -1.0));
+    CPPUNIT_ASSERT_EQUAL(-pi, fm::atan2(-0.0, -1.0));
+    CPPUNIT_ASSERT_EQUAL(pi / 2.0, fm::atan2(3.0, 0.0));
+    CPPUNIT_ASSERT_EQUAL(-pi / 2.0, fm::atan2(-3.0, 0.0));
+
+    for (int i = -1000; i <= 1000; ++i) {
+      double x = i / 1000.0;
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(std::asin(x), fm::asin(x), 1e-13);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(std::acos(x), fm::acos(x), 1e-13);
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(std::asin(1.0 - 1e-12), fm::asin(1.0 - 1e-12), 1e-13);
+
+    for (double x = 1e-30; x < 1e30; x *= 7.3) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(std::cbrt(x), fm::cbrt(x), std::cbrt(x) * 1e-15);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(-std::cbrt(x), fm::cbrt(-x), std::cbrt(x) * 1e-15);
+    }
+    CPPUNIT_ASSERT_EQUAL(0.0, fm::cbrt(0.0));
+  }
+
+  // The array versions give the scalar results
+  void test_batch()
+  {
+    typedef fr::coordinates::fast_math fm;
+    std::vector<double> x, y, s(1000), c(1000), a(1000);
+    for (int i = 0; i < 1000; ++i) {
+      x.push_back((i - 500) * 0.0173);
+      y.push_back((i % 17) - 8.5);
+    }
+    fm::sincos(x.data(), s.data(), c.data(), x.size());
+    fm::atan2(y.data(), x.data(), a.data(), x.size());
+    for (size_t i = 0; i < x.size(); ++i) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(fm::sin(x[i]), s[i], 1e-15);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(fm::cos(x[i]), c[i], 1e-15);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(fm::atan2(y[i], x[i]), a[i], 1e-15);
+    }
+  }
+
+  // The kernels agree with their precise versions to well under a
+  // millimeter and a nanodegree. Haversine distances near the antipode
+  // are only good to an ulp of the angle times the earth's diameter.
+  void test_kernels()
+  {
+    std::vector<double> lat, lon, alt;
+    for (int i = 0; i < 500; ++i) {
+      lat.push_back(-89.9 + i * 0.3599);
+      lon.push_back(-180.0 + i * 0.7211);
+      alt.push_back(-400.0 + i * 97.0);
+    }
+    size_t n = lat.size();
+    std::vector<double> x(n), y(n), z(n), fx(n), fy(n), fz(n);
+    fr::coordinates::batch_converter<fr::coordinates::ecef> to_ecef;
+    to_ecef(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), n);
+    to_ecef(lat.data(), lon.data(), alt.data(), fx.data(), fy.data(), fz.data(), n, fr::coordinates::WGS84_ELLIPSOID, fr::coordinates::fast_math());
+    for (size_t i = 0; i < n; ++i) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(x[i], fx[i], 1e-8);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(y[i], fy[i], 1e-8);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(z[i], fz[i], 1e-8);
+    }
+
+    std::vector<double> la(n), lo(n), al(n), fla(n), flo(n), fal(n);
+    fr::coordinates::batch_converter<fr::coordinates::lat_long> to_lat_long;
+    to_lat_long(x.data(), y.data(), z.data(), la.data(), lo.data(), al.data(), n);
+    to_lat_long(x.data(), y.data(), z.data(), fla.data(), flo.data(), fal.data(), n, fr::coordinates::WGS84_ELLIPSOID, fr::coordinates::fast_vermeille_solver());
+    for (size_t i = 0; i < n; ++i) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(la[i], fla[i], 1e-12);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(lo[i], flo[i], 1e-12);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(al[i], fal[i], 1e-8);
+    }
+
+    fr::coordinates::lat_long from(38.8977, -77.0365);
+    std::vector<double> d(n), fd(n), b(n), fb(n);
+    fr::coordinates::haversine_distance hd;
+    hd.distances_and_bearings(from, lat.data(), lon.data(), d.data(), b.data(), n);
+    hd.distances_and_bearings(from, lat.data(), lon.data(), fd.data(), fb.data(), n, fr::coordinates::fast_math());
+    for (size_t i = 0; i < n; ++i) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(d[i], fd[i], 1e-7);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(b[i], fb[i], 1e-9);
+    }
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(fast_math_test);
@@ -0,0 +1,135 @@
+/**
+ * Checks the ellipsoidal geodesics against values from GeographicLib
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "geodesic.hpp"
+#include "haversine_distance.hpp"
+#include <cmath>
+#include <vector>
+
+class geodesic_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(geodesic_test);
+  CPPUNIT_TEST(test_inverse);
+  CPPUNIT_TEST(test_direct);
+  CPPUNIT_TEST(test_batch);
+  CPPUNIT_TEST_SUITE_END();
+
+  struct reference {
+    double lat1, lon1, lat2, lon2, s12, azi1, azi2;
+  };
+
+public:
+
+  void test_inverse()
+  {
+    // From GeographicLib 2.1 with the same flattening as WGS84_ELLIPSOID.
+    // The second and third are nearly antipodal, where Vincenty's
+    // method doesn't converge.
+    const reference cases[] = {
+      { -41.32, 174.81, 40.96, -5.5, 19959679.2673538327, 161.0676699862, 18.8251951232 },
+      { 0.0, 0.0, 0.5, 179.7, 19944127.4207504690, 15.5568827935, 164.4425138909 },
+      { -30.0, 0.0, 29.9, 179.8, 19989832.8276095353, 161.8905247363, 18.0907372457 },
+      { 10.0, -105.0, 60.0, -105.0, 5548217.9862561440, 0.0, 0.0 },
+      { 0.0, 10.0, 0.0, 100.0, 10018754.1713946220, 90.0, 90.0 },
+      { 39.75, -104.87, 51.48, -0.0015, 7562156.4950782629, 40.5527898953, 126.6716535556 },
+    };
+    fr::coordinates::geodesic g;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+      const reference &c = cases[i];
+      double s12, azi1, azi2;
+      g.inverse(fr::coordinates::lat_long(c.lat1, c.lon1), fr::coordinates::lat_long(c.lat2, c.lon2), s12, azi1, azi2);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(c.s12, s12, .00001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(c.azi1, azi1, .0000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(c.azi2, azi2, .0000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(c.s12, g.distance(fr::coordinates::lat_long(c.lat2, c.lon2), fr::coordinates::lat_long(c.lat1, c.lon1)), .00001);
+    }
+    CPPUNIT_ASSERT_EQUAL(0.0, g.distance(fr::coordinates::lat_long(45.0, 10.0), fr::coordinates::lat_long(45.0, 10.0)));
+
+    // Haversine is within half a percent, but not within a meter
+    fr::coordinates::haversine_distance haversine;
+    fr::coordinates::lat_long denver(39.75, -104.87), greenwich(51.48, -0.0015);
+    double h = haversine.distance(denver, greenwich);
+    CPPUNIT_ASSERT(std::fabs(h - 7562156.495) < 7562156.495 * 0.005);
+    CPPUNIT_ASSERT(std::fabs(h - 7562156.495) > 1.0);
+  }
+
+  void test_direct()
+  {
+    fr::coordinates::geodesic g;
+    double azi2;
+    fr::coordinates::lat_long p = g.direct(fr::coordinates::lat_long(40.64, -73.78, 12.0), 45.0, 10000000.0, azi2);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(32.621100463726, p.get_lat(), .000000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(49.052487092960, p.get_long(), .000000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(140.405985876801, azi2, .000000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(12.0, p.get_alt(), .000001);
+
+    // Round trip through the inverse problem
+    fr::coordinates::lat_long from(-33.86, 151.21);
+    double s12, azi1, back_azi2;
+    g.inverse(from, p, s12, azi1, back_azi2);
+    fr::coordinates::lat_long there = g.direct(from, azi1, s12);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(p.get_lat(), there.get_lat(), .000000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(p.get_long(), there.get_long(), .000000001);
+  }
+
+  void test_batch()
+  {
+    fr::coordinates::geodesic g;
+    fr::coordinates::lat_long from(64.2, -149.5);
+    std::vector<double> lat, lon;
+    for (int i = 0; i < 50; ++i) {
+      lat.push_back(-89.0 + i * 3.6);
+      lon.push_back(-179.0 + i * 7.3);
+    }
+    lat.push_back(from.get_lat());
+    lon.push_back(from.get_long());
+    size_t count = lat.size();
+
+    std::vector<double> dist(count), s12(count), azi1(count), azi2(count);
+    std::vector<double> from_lat(count, from.get_lat()), from_lon(count, from.get_long());
+    g.distances(from, lat.data(), lon.data(), dist.data(), count);
+    g.inverse(from_lat.data(), from_lon.data(), lat.data(), lon.data(), s12.data(), azi1.data(), azi2.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      double s, a1, a2;
+      g.inverse(from, fr::coordinates::lat_long(lat[i], lon[i]), s, a1, a2);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(s, dist[i], .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(s, s12[i], .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(a1, azi1[i], .000000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(a2, azi2[i], .000000001);
+    }
+    CPPUNIT_ASSERT_EQUAL(0.0, dist[count - 1]);
+
+    // Points along one geodesic against single direct calls
+    std::vector<double> lat2(count), lon2(count), out_azi(count);
+    for (size_t i = 0; i < count; ++i) {
+      s12[i] = i * 400000.0;
+    }
+    g.direct(from, 30.0, s12.data(), lat2.data(), lon2.data(), out_azi.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      double a2;
+      fr::coordinates::lat_long p = g.direct(from, 30.0, s12[i], a2);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(p.get_lat(), lat2[i], .000000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(p.get_long(), lon2[i], .000000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(a2, out_azi[i], .000000001);
+    }
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(geodesic_test);
@@ -0,0 +1,98 @@
+/**
+ * Tests the batch distance and bearing calculations against the
+ * single point ones
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "bearing.hpp"
+#include "haversine_distance.hpp"
+#include <vector>
+
+class geodesy_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(geodesy_test);
+  CPPUNIT_TEST(test_one_to_many);
+  CPPUNIT_TEST(test_many_to_many);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::vector<double> lat, lon;
+
+public:
+
+  void setUp()
+  {
+    const double lats[] = { 39.75, -33.86, 0.0, 89.9, -90.0, 51.48, 64.2, -12.5, 39.7501 };
+    const double lons[] = { 104.87, 151.21, 0.0, 0.0, 45.0, -0.0015, 180.0, -179.99, 104.87 };
+    lat.assign(lats, lats + 9);
+    lon.assign(lons, lons + 9);
+  }
+
+  void test_one_to_many()
+  {
+    fr::coordinates::haversine_distance haversine;
+    fr::coordinates::bearing bear;
+    size_t count = lat.size();
+    std::vector<double> dist(count), dist2(count), bearings(count), bearings2(count);
+    for (size_t r = 0; r < count; ++r) {
+      fr::coordinates::lat_long from(lat[r], lon[r]);
+      haversine.distances(from, lat.data(), lon.data(), dist.data(), count);
+      haversine.distances_and_bearings(from, lat.data(), lon.data(), dist2.data(), bearings2.data(), count);
+      bear(from, lat.data(), lon.data(), bearings.data(), count);
+      for (size_t i = 0; i < count; ++i) {
+	fr::coordinates::lat_long to(lat[i], lon[i]);
+	double expected_dist = haversine.distance(from, to);
+	double expected_bearing = bear(from, to);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(expected_dist, dist[i], .000001);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(expected_dist, dist2[i], .000001);
+	CPPUNIT_ASSERT(bearings[i] >= 0.0 && bearings[i] < 360.0);
+	CPPUNIT_ASSERT(bearings2[i] >= 0.0 && bearings2[i] < 360.0);
+	// Bearing to yourself is arbitrary
+	if (i != r) {
+	  CPPUNIT_ASSERT_DOUBLES_EQUAL(expected_bearing, bearings[i], .000001);
+	  CPPUNIT_ASSERT_DOUBLES_EQUAL(expected_bearing, bearings2[i], .000001);
+	}
+      }
+    }
+  }
+
+  void test_many_to_many()
+  {
+    fr::coordinates::haversine_distance haversine;
+    fr::coordinates::bearing bear;
+    size_t n1 = 3;
+    size_t n2 = lat.size();
+    std::vector<double> dist(n1 * n2), dist2(n1 * n2), bearings(n1 * n2), bearings2(n1 * n2);
+    haversine.distances(lat.data(), lon.data(), n1, lat.data(), lon.data(), n2, dist.data());
+    haversine.distances_and_bearings(lat.data(), lon.data(), n1, lat.data(), lon.data(), n2, dist2.data(), bearings2.data());
+    bear(lat.data(), lon.data(), n1, lat.data(), lon.data(), n2, bearings.data());
+    for (size_t r = 0; r < n1; ++r) {
+      for (size_t i = 0; i < n2; ++i) {
+	fr::coordinates::lat_long from(lat[r], lon[r]);
+	fr::coordinates::lat_long to(lat[i], lon[i]);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(haversine.distance(from, to), dist[r * n2 + i], .000001);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(haversine.distance(from, to), dist2[r * n2 + i], .000001);
+	if (i != r) {
+	  CPPUNIT_ASSERT_DOUBLES_EQUAL(bear(from, to), bearings[r * n2 + i], .000001);
+	  CPPUNIT_ASSERT_DOUBLES_EQUAL(bear(from, to), bearings2[r * n2 + i], .000001);
+	}
+      }
+    }
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(geodesy_test);
@@ -0,0 +1,374 @@
+/**
+ * Tests geofence containment, including fences over the antimeridian
+ * and around the poles, and checks geofence_index against testing
+ * every fence
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "geofence.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+class geofence_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(geofence_test);
+  CPPUNIT_TEST(test_contains);
+  CPPUNIT_TEST(test_antimeridian);
+  CPPUNIT_TEST(test_poles);
+  CPPUNIT_TEST(test_great_circle_edges);
+  CPPUNIT_TEST(test_many_vertices);
+  CPPUNIT_TEST(test_circles);
+  CPPUNIT_TEST(test_bad_polygons);
+  CPPUNIT_TEST(test_index);
+  CPPUNIT_TEST_SUITE_END();
+
+  static double uniform(double lo, double hi)
+  {
+    return lo + (hi - lo) * (rand() / (double) RAND_MAX);
+  }
+
+  static fr::coordinates::lat_long ll(double lat, double lon)
+  {
+    return fr::coordinates::lat_long(lat, lon);
+  }
+
+  static fr::coordinates::lat_long_polygon box(double south, double west, double north, double east)
+  {
+    std::vector<fr::coordinates::lat_long> v;
+    v.push_back(ll(south, west));
+    v.push_back(ll(south, east));
+    v.push_back(ll(north, east));
+    v.push_back(ll(north, west));
+    return fr::coordinates::lat_long_polygon(v);
+  }
+
+  // Where you end up going distance along a great circle from center
+  static fr::coordinates::lat_long destination(const fr::coordinates::lat_long &center, double bearing, double distance)
+  {
+    const double to_rad = M_PI / 180.0;
+    double d = distance / fr::coordinates::WGS84_ELLIPSOID.ae;
+    double lat1 = center.get_lat() * to_rad;
+    double lon1 = center.get_long() * to_rad;
+    double b = bearing * to_rad;
+    double lat2 = asin(sin(lat1) * cos(d) + cos(lat1) * sin(d) * cos(b));
+    double lon2 = lon1 + atan2(sin(b) * sin(d) * cos(lat1), cos(d) - sin(lat1) * sin(lat2));
+    return ll(lat2 / to_rad, fr::coordinates::wrap_longitude(lon2 / to_rad));
+  }
+
+  // A ring of count vertices radius from center
+  static fr::coordinates::lat_long_polygon circle(const fr::coordinates::lat_long &center, double radius, size_t count)
+  {
+    std::vector<fr::coordinates::lat_long> v;
+    for (size_t i = 0; i < count; ++i) {
+      v.push_back(destination(center, 360.0 * i / count, radius));
+    }
+    return fr::coordinates::lat_long_polygon(v);
+  }
+
+  // Ring of vertices at one latitude, going east or west
+  static fr::coordinates::lat_long_polygon cap(double lat, bool east)
+  {
+    std::vector<fr::coordinates::lat_long> v;
+    for (int i = 0; i < 8; ++i) {
+      v.push_back(ll(lat, (east ? 45.0 : -45.0) * i));
+    }
+    return fr::coordinates::lat_long_polygon(v);
+  }
+
+  static bool hit_less(const fr::coordinates::geofence_index::hit &a, const fr::coordinates::geofence_index::hit &b)
+  {
+    return a.point < b.point || (a.point == b.point && a.fence < b.fence);
+  }
+
+public:
+
+  void test_contains()
+  {
+    fr::coordinates::lat_long_polygon colorado = box(37.0, -109.05, 41.0, -102.05);
+    CPPUNIT_ASSERT(colorado.size() == 4);
+    CPPUNIT_ASSERT(colorado.contains(ll(39.75, -104.87)));
+    CPPUNIT_ASSERT(colorado.contains(39.75, -104.87));
+    CPPUNIT_ASSERT(!colorado.contains(ll(39.75, -100.0)));
+    CPPUNIT_ASSERT(!colorado.contains(ll(36.0, -104.87)));
+    CPPUNIT_ASSERT(!colorado.contains(ll(-39.75, 75.13)));
+
+    // Same answers going the other way around, or closing the ring
+    std::vector<fr::coordinates::lat_long> v;
+    v.push_back(ll(37.0, -109.05));
+    v.push_back(ll(41.0, -109.05));
+    v.push_back(ll(41.0, -102.05));
+    v.push_back(ll(37.0, -102.05));
+    v.push_back(ll(37.0, -109.05));
+    fr::coordinates::lat_long_polygon backwards(v);
+    CPPUNIT_ASSERT(backwards.size() == 4);
+    CPPUNIT_ASSERT(backwards.contains(ll(39.75, -104.87)));
+    CPPUNIT_ASSERT(!backwards.contains(ll(39.75, -100.0)));
+
+    // A one degree square on the equator
+    const double degree = fr::coordinates::WGS84_ELLIPSOID.ae * M_PI / 180.0;
+    fr::coordinates::lat_long_polygon square = box(0.0, 0.0, 1.0, 1.0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(degree * degree, square.area(), degree * degree * 0.001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(colorado.area(), backwards.area(), 1.0);
+
+    std::vector<double> lat, lon;
+    lat.push_back(39.75); lon.push_back(-104.87);
+    lat.push_back(39.75); lon.push_back(-100.0);
+    lat.push_back(40.0); lon.push_back(-108.0);
+    bool out[3];
+    colorado.contains(lat.data(), lon.data(), out, 3);
+    CPPUNIT_ASSERT(out[0] && !out[1] && out[2]);
+  }
+
+  void test_antimeridian()
+  {
+    // Fiji, more or less
+    fr::coordinates::lat_long_polygon fiji = box(-21.0, 176.0, -12.0, -178.0);
+    CPPUNIT_ASSERT(fiji.contains(ll(-17.7, 178.0)));
+    CPPUNIT_ASSERT(fiji.contains(ll(-16.5, 180.0)));
+    CPPUNIT_ASSERT(fiji.contains(ll(-16.5, -180.0)));
+    CPPUNIT_ASSERT(fiji.contains(ll(-16.5, -179.0)));
+    CPPUNIT_ASSERT(fiji.contains(ll(-16.5, 181.0)));
+    CPPUNIT_ASSERT(!fiji.contains(ll(-16.5, 175.0)));
+    CPPUNIT_ASSERT(!fiji.contains(ll(-16.5, -177.0)));
+    CPPUNIT_ASSERT(!fiji.contains(ll(-16.5, 0.0)));
+    CPPUNIT_ASSERT(!fiji.contains(ll(-25.0, 179.0)));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(176.0, fiji.bounds().west, 1e-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(6.0, fiji.bounds().extent, 1e-9);
+  }
+
+  void test_poles()
+  {
+    const double r = fr::coordinates::WGS84_ELLIPSOID.ae;
+    bool directions[2] = { true, false };
+    for (int d = 0; d < 2; ++d) {
+      fr::coordinates::lat_long_polygon arctic = cap(80.0, directions[d]);
+      CPPUNIT_ASSERT(arctic.contains(ll(89.9, 0.0)));
+      CPPUNIT_ASSERT(arctic.contains(ll(85.0, 37.0)));
+      CPPUNIT_ASSERT(arctic.contains(ll(85.0, -163.0)));
+      CPPUNIT_ASSERT(!arctic.contains(ll(70.0, 10.0)));
+      CPPUNIT_ASSERT(!arctic.contains(ll(0.0, 0.0)));
+      CPPUNIT_ASSERT(!arctic.contains(ll(-89.9, 0.0)));
+      CPPUNIT_ASSERT(arctic.bounds().north == 90.0);
+      CPPUNIT_ASSERT(arctic.bounds().extent == 360.0);
+      // Straight edges cut a little off a cap at 80 north
+      double cap_area = 2.0 * M_PI * r * r * (1.0 - sin(80.0 * M_PI / 180.0));
+      CPPUNIT_ASSERT(arctic.area() < cap_area && arctic.area() > cap_area * 0.9);
+
+      fr::coordinates::lat_long_polygon rest = arctic.complement();
+      CPPUNIT_ASSERT(!rest.contains(ll(89.9, 0.0)));
+      CPPUNIT_ASSERT(rest.contains(ll(0.0, 0.0)));
+      CPPUNIT_ASSERT(rest.contains(ll(-89.9, 0.0)));
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0 * M_PI * r * r, arctic.area() + rest.area(), 1.0);
+
+      fr::coordinates::lat_long_polygon antarctic = cap(-70.0, directions[d]);
+      CPPUNIT_ASSERT(antarctic.contains(ll(-89.9, 123.0)));
+      CPPUNIT_ASSERT(antarctic.contains(ll(-75.0, -60.0)));
+      CPPUNIT_ASSERT(!antarctic.contains(ll(-60.0, -60.0)));
+      CPPUNIT_ASSERT(!antarctic.contains(ll(89.9, 0.0)));
+      CPPUNIT_ASSERT(antarctic.bounds().south == -90.0);
+    }
+
+    // Going over the pole takes a vertex on either side of it
+    std::vector<fr::coordinates::lat_long> v;
+    v.push_back(ll(80.0, 0.0));
+    v.push_back(ll(89.0, 90.0));
+    v.push_back(ll(80.0, 180.0));
+    v.push_back(ll(70.0, 90.0));
+    fr::coordinates::lat_long_polygon over(v);
+    CPPUNIT_ASSERT(over.contains(ll(85.0, 90.0)));
+    CPPUNIT_ASSERT(!over.contains(ll(85.0, -90.0)));
+    CPPUNIT_ASSERT(!over.contains(ll(89.9, 0.0)));
+  }
+
+  void test_great_circle_edges()
+  {
+    // The top edge bows north of 60 halfway along
+    std::vector<fr::coordinates::lat_long> v;
+    v.push_back(ll(0.0, -80.0));
+    v.push_back(ll(0.0, 80.0));
+    v.push_back(ll(60.0, 80.0));
+    v.push_back(ll(60.0, -80.0));
+    fr::coordinates::lat_long_polygon wide(v);
+    CPPUNIT_ASSERT(wide.contains(ll(70.0, 0.0)));
+    CPPUNIT_ASSERT(wide.contains(ll(80.0, 0.0)));
+    CPPUNIT_ASSERT(!wide.contains(ll(86.0, 0.0)));
+    CPPUNIT_ASSERT(!wide.contains(ll(65.0, 79.0)));
+    CPPUNIT_ASSERT(wide.contains(ll(62.0, 79.0)));
+    double top = atan(tan(60.0 * M_PI / 180.0) / cos(80.0 * M_PI / 180.0)) * 180.0 / M_PI;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(top, wide.bounds().north, 1e-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, wide.bounds().south, 1e-9);
+  }
+
+  void test_many_vertices()
+  {
+    // Enough vertices to spread the edges over slabs. Points well
+    // clear of the edge have to agree with haversine_distance.
+    const double radius = 200000.0;
+    fr::coordinates::lat_long centers[3] = { ll(39.75, -104.87), ll(0.0, 179.5), ll(-60.0, -10.0) };
+    fr::coordinates::haversine_distance haversine;
+    srand(1);
+    for (int c = 0; c < 3; ++c) {
+      fr::coordinates::lat_long_polygon round = circle(centers[c], radius, 1000);
+      for (int i = 0; i < 2000; ++i) {
+	fr::coordinates::lat_long p = destination(centers[c], uniform(0.0, 360.0), uniform(0.0, 2.0 * radius));
+	double d = haversine.distance(centers[c], p);
+	if (fabs(d - radius) > 100.0) {
+	  CPPUNIT_ASSERT(round.contains(p) == (d < radius));
+	}
+      }
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(M_PI * radius * radius, round.area(), M_PI * radius * radius * 0.001);
+    }
+  }
+
+  void test_circles()
+  {
+    const double degree = fr::coordinates::WGS84_ELLIPSOID.ae * M_PI / 180.0;
+    fr::coordinates::lat_long_polygon square = box(0.0, 0.0, 1.0, 1.0);
+    fr::coordinates::lat_long center = ll(0.25, 0.5);
+    // Closest to the bottom edge, along the equator
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.25 * degree, square.distance_to_boundary(center), 1e-6);
+    CPPUNIT_ASSERT(square.contains(center, 0.2 * degree));
+    CPPUNIT_ASSERT(!square.contains(center, 0.3 * degree));
+    // Outside the corner, the closest thing is the vertex
+    fr::coordinates::haversine_distance haversine;
+    fr::coordinates::lat_long outside = ll(-0.5, -0.5);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(haversine.distance(outside, ll(0.0, 0.0)), square.distance_to_boundary(outside), 1e-6);
+    CPPUNIT_ASSERT(!square.contains(outside, 1.0));
+
+    // Circles around a pole
+    fr::coordinates::lat_long_polygon arctic = cap(80.0, true);
+    CPPUNIT_ASSERT(arctic.contains(ll(90.0 - 1e-9, 0.0), 5.0 * degree));
+    CPPUNIT_ASSERT(!arctic.contains(ll(90.0 - 1e-9, 0.0), 11.0 * degree));
+  }
+
+  void test_bad_polygons()
+  {
+    std::vector<fr::coordinates::lat_long> v;
+    v.push_back(ll(0.0, 0.0));
+    v.push_back(ll(1.0, 0.0));
+    v.push_back(ll(0.0, 0.0));
+    CPPUNIT_ASSERT_THROW(fr::coordinates::lat_long_polygon p(v), std::invalid_argument);
+    v.push_back(ll(90.0, 0.0));
+    CPPUNIT_ASSERT_THROW(fr::coordinates::lat_long_polygon p(v), std::invalid_argument);
+    v.clear();
+    v.push_back(ll(0.0, 0.0));
+    v.push_back(ll(10.0, 180.0));
+    v.push_back(ll(10.0, 90.0));
+    CPPUNIT_ASSERT_THROW(fr::coordinates::lat_long_polygon p(v), std::invalid_argument);
+    v.back() = ll(10.0, NAN);
+    CPPUNIT_ASSERT_THROW(fr::coordinates::lat_long_polygon p(v), std::invalid_argument);
+
+    // Nor can the points tested against them
+    fr::coordinates::lat_long_polygon square = box(0.0, 0.0, 10.0, 10.0);
+    CPPUNIT_ASSERT_THROW(square.contains(5.0, NAN), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(square.contains(INFINITY, 5.0), std::invalid_argument);
+    fr::coordinates::geofence_index index;
+    index.insert(square);
+    CPPUNIT_ASSERT_THROW(index.containing(ll(5.0, NAN)), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(index.containing(ll(5.0, -INFINITY)), std::invalid_argument);
+    double lat[] = { 5.0, NAN };
+    double lon[] = { 5.0, 5.0 };
+    std::vector<fr::coordinates::geofence_index::hit> hits;
+    CPPUNIT_ASSERT_THROW(index.containing(lat, lon, 2, hits), std::invalid_argument);
+    CPPUNIT_ASSERT(hits.empty());
+  }
+
+  void test_index()
+  {
+    check_index(1.0);
+    // Coarse enough that the batch query sorts the points by cell
+    check_index(30.0);
+  }
+
+  void check_index(double cell_degrees)
+  {
+    srand(2);
+    fr::coordinates::geofence_index index(cell_degrees);
+    std::vector<fr::coordinates::lat_long_polygon> fences;
+    for (int i = 0; i < 300; ++i) {
+      double lat = uniform(-80.0, 80.0);
+      double lon = uniform(-180.0, 180.0);
+      fences.push_back(circle(ll(lat, lon), uniform(10000.0, 1000000.0), 12));
+    }
+    fences.push_back(box(-21.0, 176.0, -12.0, -178.0));
+    fences.push_back(cap(80.0, true));
+    fences.push_back(cap(-70.0, false));
+    fences.push_back(cap(-70.0, false).complement());
+    for (size_t i = 0; i < fences.size(); ++i) {
+      CPPUNIT_ASSERT(index.insert(fences[i]) == i);
+    }
+    CPPUNIT_ASSERT(index.size() == fences.size());
+
+    std::vector<bool> alive(fences.size(), true);
+    for (int pass = 0; pass < 2; ++pass) {
+      std::vector<double> lat, lon;
+      for (int i = 0; i < 2000; ++i) {
+	lat.push_back(uniform(-90.0, 90.0));
+	lon.push_back(uniform(-180.0, 180.0));
+      }
+      lat.push_back(-16.5);
+      lon.push_back(180.0);
+      std::vector<fr::coordinates::geofence_index::hit> hits;
+      index.containing(lat.data(), lon.data(), lat.size(), hits);
+      std::sort(hits.begin(), hits.end(), hit_less);
+
+      size_t h = 0;
+      for (size_t i = 0; i < lat.size(); ++i) {
+	std::vector<size_t> expected;
+	for (size_t f = 0; f < fences.size(); ++f) {
+	  if (alive[f] && fences[f].contains(lat[i], lon[i])) {
+	    expected.push_back(f);
+	  }
+	}
+	std::vector<size_t> found = index.containing(ll(lat[i], lon[i]));
+	std::sort(found.begin(), found.end());
+	CPPUNIT_ASSERT(found == expected);
+	std::vector<size_t> batch;
+	while (h < hits.size() && hits[h].point == i) {
+	  batch.push_back(hits[h++].fence);
+	}
+	std::sort(batch.begin(), batch.end());
+	CPPUNIT_ASSERT(batch == expected);
+      }
+      CPPUNIT_ASSERT(h == hits.size());
+
+      // Take out every third fence and go again
+      for (size_t f = 0; f < fences.size(); f += 3) {
+	CPPUNIT_ASSERT(index.remove(f) == alive[f]);
+	alive[f] = false;
+      }
+    }
+    CPPUNIT_ASSERT(!index.contains(0));
+    CPPUNIT_ASSERT(index.contains(1));
+    // Removed fences don't hold on to their vertices
+    CPPUNIT_ASSERT(index.get(0).size() == 0);
+
+    // Circles around the pole against the arctic cap
+    std::vector<size_t> found;
+    index.containing(ll(89.0, 0.0), 100000.0, found);
+    CPPUNIT_ASSERT(std::find(found.begin(), found.end(), (size_t) 301) != found.end());
+    found.clear();
+    index.containing(ll(89.0, 0.0), 2000000.0, found);
+    CPPUNIT_ASSERT(std::find(found.begin(), found.end(), (size_t) 301) == found.end());
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(geofence_test);
@@ -0,0 +1,203 @@
+/**
+ * Tests the J2000/TEME frame chain
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "coordinates.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+class inertial_frames_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(inertial_frames_test);
+  CPPUNIT_TEST(test_reduction);
+  CPPUNIT_TEST(test_frames);
+  CPPUNIT_TEST(test_chain);
+  CPPUNIT_TEST(test_chain_nan);
+  CPPUNIT_TEST(test_batch);
+  CPPUNIT_TEST_SUITE_END();
+
+  // Vallado, Fundamentals of Astrodynamics and Applications, example
+  // 3-15: 2004 April 6 07:51:28.386009 UTC, passed in as UT1 with TT -
+  // UT1 as the offset. Positions in km.
+  static double example_time() { return 1081237887.946047; }
+
+  static fr::coordinates::earth_orientation example_eop(bool corrections = true)
+  {
+    return fr::coordinates::earth_orientation(-0.140682, 0.333309, corrections ? -0.052195 : 0.0, corrections ? -0.003875 : 0.0, 64.184 + 0.4399619);
+  }
+
+  static fr::coordinates::ecef_point example_itrf()
+  {
+    return fr::coordinates::ecef_point(-1033.4793830, 7901.2952754, 6380.3565958);
+  }
+
+  template <typename point>
+  static void check(double x, double y, double z, const point &p, double tolerance)
+  {
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(x, p.x, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(y, p.y, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(z, p.z, tolerance);
+  }
+
+public:
+
+  void test_reduction()
+  {
+    fr::coordinates::frame_rotation r(example_time(), example_eop());
+    fr::coordinates::converter<fr::coordinates::j2000_point> to_j2000;
+    fr::coordinates::converter<fr::coordinates::teme_point> to_teme;
+    // GCRF with the nutation corrections, J2000 without
+    check(5102.508958, 6123.011401, 6378.136928, to_j2000(example_itrf(), r), 0.000001);
+    fr::coordinates::frame_rotation uncorrected(example_time(), example_eop(false));
+    check(5102.5096, 6123.01152, 6378.1363, to_j2000(example_itrf(), uncorrected), 0.0001);
+    check(5094.18016210, 6127.64465950, 6380.34453270, to_teme(example_itrf(), r), 0.000001);
+
+    // And back
+    fr::coordinates::ecef_point back = fr::coordinates::converter<fr::coordinates::ecef_point>()(to_j2000(example_itrf(), r), r);
+    check(example_itrf().x, example_itrf().y, example_itrf().z, back, 0.000000001);
+
+    // The angles themselves, against the IAU series evaluated by SOFA
+    fr::coordinates::precession_nutation pn(946684800.0, fr::coordinates::earth_orientation(0.0, 0.0, 0.0, 0.0, 0.0));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.40909280732931763, pn.get_mean_obliquity(), 1e-15);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(-6.750147837648539e-05, pn.get_dpsi(), 1e-15);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(-2.794464363468216e-05, pn.get_deps(), 1e-15);
+  }
+
+  void test_frames()
+  {
+    double t = example_time();
+    fr::coordinates::frame_rotation r(t);
+    fr::coordinates::teme_point teme(6524.834, 6862.875, 6448.296);
+
+    // TEME and true of date share the pole; they differ by the
+    // equation of the equinoxes about z
+    fr::coordinates::tod_eci_point tod = fr::coordinates::converter<fr::coordinates::tod_eci_point>()(teme, r);
+    double eqe = fr::coordinates::precession_nutation(t).get_equation_of_equinoxes();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(teme.z, tod.z, 0.000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(eqe, std::atan2(tod.y, tod.x) - std::atan2(teme.y, teme.x), 1e-12);
+
+    // Without polar motion, TEME to ECEF is the mean sidereal time
+    // rotation eci_ecef_rotation does
+    fr::coordinates::eci_ecef_rotation old(t);
+    CPPUNIT_ASSERT((r.to_ecef(fr::coordinates::teme_frame()) - old.get()).cwiseAbs().maxCoeff() < 1e-15);
+
+    // Round trips through every frame
+    fr::coordinates::j2000_point j = fr::coordinates::converter<fr::coordinates::j2000_point>()(teme, r);
+    fr::coordinates::ecef_point e = fr::coordinates::converter<fr::coordinates::ecef_point>()(j, r);
+    fr::coordinates::tod_eci_point d = fr::coordinates::converter<fr::coordinates::tod_eci_point>()(e, r);
+    // True of date only goes back in through the rotation itself, since
+    // the converters take a tod_eci_point to be eci_ecef_rotation's
+    CPPUNIT_ASSERT(!fr::coordinates::is_chain_position<fr::coordinates::tod_eci_point>::value);
+    CPPUNIT_ASSERT(!fr::coordinates::is_chain_position<fr::coordinates::tod_eci>::value);
+    CPPUNIT_ASSERT(fr::coordinates::is_chain_position<fr::coordinates::teme_point>::value);
+    fr::coordinates::teme_point back;
+    back.map_xyz() = r.rotate<fr::coordinates::tod_eci_frame, fr::coordinates::teme_frame>(d.map_xyz());
+    check(teme.x, teme.y, teme.z, back, 0.000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(teme.get_xyz().norm(), j.get_xyz().norm(), 0.000001);
+
+    // Passing the time builds the same rotation
+    fr::coordinates::j2000_point j2 = fr::coordinates::converter<fr::coordinates::j2000_point>()(teme, t);
+    check(j.x, j.y, j.z, j2, 0.0);
+  }
+
+  // The chain's interpolated rotations against exact ones, and the
+  // series only being evaluated once per step for sorted times
+  void test_chain()
+  {
+    fr::coordinates::earth_orientation eop = example_eop();
+    fr::coordinates::frame_chain chain(eop);
+    double t0 = example_time();
+    for (double t = t0; t < t0 + 86400.0; t += 61.7) {
+      Eigen::Matrix3d a = chain(t).get<fr::coordinates::j2000_frame, fr::coordinates::ecef_frame>();
+      Eigen::Matrix3d b = fr::coordinates::frame_rotation(t, eop).get<fr::coordinates::j2000_frame, fr::coordinates::ecef_frame>();
+      // Mostly the rounding in sidereal time; the interpolation itself
+      // is good to 1e-10
+      CPPUNIT_ASSERT((a - b).cwiseAbs().maxCoeff() < 1e-8);
+    }
+    CPPUNIT_ASSERT_EQUAL((size_t) 26, chain.get_evaluations());
+
+    // Stepping backwards reuses the shared anchor too
+    chain(t0 - 3600.0);
+    CPPUNIT_ASSERT_EQUAL((size_t) 28, chain.get_evaluations());
+    chain(t0 - 7200.0);
+    CPPUNIT_ASSERT_EQUAL((size_t) 29, chain.get_evaluations());
+  }
+
+  // A leading NaN used to anchor the chain at NaN for good
+  void test_chain_nan()
+  {
+    fr::coordinates::earth_orientation eop = example_eop();
+    fr::coordinates::frame_chain chain(eop);
+    double t0 = example_time();
+    CPPUNIT_ASSERT_THROW(chain(NAN), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(chain(-INFINITY), std::invalid_argument);
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, chain.get_evaluations());
+    for (double t = t0; t < t0 + 120.0; t += 60.0) {
+      Eigen::Matrix3d a = chain(t).get<fr::coordinates::j2000_frame, fr::coordinates::ecef_frame>();
+      Eigen::Matrix3d b = fr::coordinates::frame_rotation(t, eop).get<fr::coordinates::j2000_frame, fr::coordinates::ecef_frame>();
+      CPPUNIT_ASSERT((a - b).cwiseAbs().maxCoeff() < 1e-8);
+    }
+    CPPUNIT_ASSERT_THROW(chain(NAN), std::invalid_argument);
+
+    // Same through the batch converter
+    fr::coordinates::frame_chain batch_chain(eop);
+    std::vector<fr::coordinates::j2000_point> in(3, fr::coordinates::j2000_point(7000000.0, 100.0, 2000.0));
+    std::vector<fr::coordinates::teme_point> out(in.size());
+    double times[] = { NAN, t0, t0 + 60.0 };
+    CPPUNIT_ASSERT_THROW(fr::coordinates::batch_converter<fr::coordinates::teme_point>()(in.data(), times, out.data(), in.size(), batch_chain), std::invalid_argument);
+    fr::coordinates::batch_converter<fr::coordinates::teme_point>()(in.data(), times + 1, out.data(), 2, batch_chain);
+    fr::coordinates::converter<fr::coordinates::teme_point> to_teme;
+    for (size_t i = 0; i < 2; ++i) {
+      fr::coordinates::teme_point expected = to_teme(in[i], fr::coordinates::frame_rotation(times[i + 1], eop));
+      check(expected.x, expected.y, expected.z, out[i], 0.001);
+    }
+  }
+
+  void test_batch()
+  {
+    double t0 = example_time();
+    fr::coordinates::frame_rotation r(t0, example_eop());
+    std::vector<fr::coordinates::j2000_point> in;
+    std::vector<double> times;
+    for (int i = 0; i < 200; ++i) {
+      in.push_back(fr::coordinates::j2000_point(7000000.0 - i * 1000.0, i * 3000.0, 1000000.0 + i * 500.0));
+      times.push_back(t0 + (i / 4) * 90.0);
+    }
+    std::vector<fr::coordinates::ecef_point> out(in.size());
+    fr::coordinates::batch_converter<fr::coordinates::ecef_point>()(in.data(), out.data(), in.size(), r);
+    fr::coordinates::converter<fr::coordinates::ecef_point> to_ecef;
+    for (size_t i = 0; i < in.size(); ++i) {
+      fr::coordinates::ecef_point expected = to_ecef(in[i], r);
+      check(expected.x, expected.y, expected.z, out[i], 0.000001);
+    }
+
+    std::vector<fr::coordinates::teme_point> teme(in.size());
+    fr::coordinates::frame_chain chain(example_eop());
+    fr::coordinates::batch_converter<fr::coordinates::teme_point>()(in.data(), times.data(), teme.data(), in.size(), chain);
+    fr::coordinates::converter<fr::coordinates::teme_point> to_teme;
+    for (size_t i = 0; i < in.size(); ++i) {
+      fr::coordinates::teme_point expected = to_teme(in[i], fr::coordinates::frame_rotation(times[i], example_eop()));
+      // 1e-10 radians of interpolation at 7000 km
+      check(expected.x, expected.y, expected.z, teme[i], 0.001);
+    }
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(inertial_frames_test);
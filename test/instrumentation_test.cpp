@@ -0,0 +1,238 @@
+/**
+ * Tests the instrumentation counters and histograms. The Makefile
+ * builds this file twice: into run_tests without
+ * FR_COORDINATES_INSTRUMENT, to check that nothing is counted, and
+ * into run_instrumented_tests with it, so the library's own calls are
+ * counted.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "coordinates.hpp"
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class instrumentation_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(instrumentation_test);
+#ifdef FR_COORDINATES_INSTRUMENT
+  CPPUNIT_TEST(test_converters);
+  CPPUNIT_TEST(test_chained_converters);
+  CPPUNIT_TEST(test_solver);
+  CPPUNIT_TEST(test_rotations);
+  CPPUNIT_TEST(test_batch);
+  CPPUNIT_TEST(test_threads);
+#else
+  CPPUNIT_TEST(test_compiled_out);
+#endif
+  CPPUNIT_TEST(test_write);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+
+  void test_converters()
+  {
+    using namespace fr::coordinates;
+    CPPUNIT_ASSERT(instrumentation::enabled());
+    instrumentation_snapshot before = instrumentation::snapshot();
+    lat_long denver(39.75, -104.87, 1609.344);
+    ecef e = converter<ecef>()(denver);
+    lat_long back = converter<lat_long>()(e);
+    instrumentation_snapshot used = instrumentation::snapshot() - before;
+    CPPUNIT_ASSERT(used.get(instrument_to_ecef) == 1);
+    CPPUNIT_ASSERT(used.get(instrument_to_lat_long) == 1);
+    CPPUNIT_ASSERT(used.get(instrument_to_tod_eci) == 0);
+    CPPUNIT_ASSERT(used.get(instrument_batch_calls) == 0);
+  }
+
+  // A converter that goes through another type counts once for each
+  // destination type, however many overloads it delegates through
+  void test_chained_converters()
+  {
+    using namespace fr::coordinates;
+    tod_eci_vel sat(7000000.0, 100.0, 2000.0, 10.0, 7500.0, 5.0);
+    instrumentation_snapshot before = instrumentation::snapshot();
+    converter<lat_long>()(sat, 1000.0);
+    instrumentation_snapshot used = instrumentation::snapshot() - before;
+    CPPUNIT_ASSERT(used.get(instrument_to_lat_long) == 1);
+    CPPUNIT_ASSERT(used.get(instrument_to_ecef_vel) == 1);
+    CPPUNIT_ASSERT(used.get(instrument_to_ecef) == 1);
+
+    ecef_vel ground(-1260484.206487, 4747249.668167, 4057711.884932, 1.0, 2.0, 3.0);
+    before = instrumentation::snapshot();
+    converter<lat_long>()(ground);
+    used = instrumentation::snapshot() - before;
+    CPPUNIT_ASSERT(used.get(instrument_to_lat_long) == 1);
+    CPPUNIT_ASSERT(used.get(instrument_to_ecef) == 1);
+
+    eci_ecef_rotation r(1000.0);
+    before = instrumentation::snapshot();
+    converter<lat_long>()(sat, r);
+    used = instrumentation::snapshot() - before;
+    CPPUNIT_ASSERT(used.get(instrument_to_lat_long) == 1);
+    CPPUNIT_ASSERT(used.get(instrument_to_ecef) == 0);
+  }
+
+  void test_solver()
+  {
+    using namespace fr::coordinates;
+    ecef e = converter<ecef>()(lat_long(39.75, -104.87, 1609.344));
+    instrumentation_snapshot before = instrumentation::snapshot();
+    for (int i = 0; i < 10; ++i) {
+      converter<lat_long>()(e, WGS84_ELLIPSOID, iterative_solver());
+    }
+    instrumentation_snapshot used = instrumentation::snapshot() - before;
+    CPPUNIT_ASSERT(used.get(instrument_geodetic_solves) == 10);
+    CPPUNIT_ASSERT(used.get_count(instrument_solver_iterations) == 10);
+    // Every call does the same number of iterations, at least two
+    // since the first never converges
+    CPPUNIT_ASSERT(used.get_sum(instrument_solver_iterations) % 10 == 0);
+    CPPUNIT_ASSERT(used.get_sum(instrument_solver_iterations) >= 20);
+    uint64_t each = used.get_sum(instrument_solver_iterations) / 10;
+    CPPUNIT_ASSERT(used.buckets[instrument_solver_iterations][each] == 10);
+
+    // The closed form solvers don't count as solves
+    before = instrumentation::snapshot();
+    converter<lat_long>()(e, WGS84_ELLIPSOID, bowring_solver<>());
+    used = instrumentation::snapshot() - before;
+    CPPUNIT_ASSERT(used.get(instrument_geodetic_solves) == 0);
+    CPPUNIT_ASSERT(used.get(instrument_to_lat_long) == 1);
+  }
+
+  void test_rotations()
+  {
+    using namespace fr::coordinates;
+    instrumentation_snapshot before = instrumentation::snapshot();
+    eci_to_ecef m(1000.0);
+    eci_ecef_rotation r(1000.0);
+    instrumentation_snapshot used = instrumentation::snapshot() - before;
+    // The rotation context builds its matrices with an eci_to_ecef
+    CPPUNIT_ASSERT(used.get(instrument_eci_to_ecef_built) == 2);
+    CPPUNIT_ASSERT(used.get(instrument_eci_ecef_rotation_built) == 1);
+    CPPUNIT_ASSERT(used.get(instrument_gmst_evaluations) == 2);
+
+    // Converting with a prebuilt context doesn't evaluate GMST again
+    before = instrumentation::snapshot();
+    tod_eci_point p(6378137.0, 1000.0, 2000.0);
+    ecef_point out = converter<ecef_point>()(p, r);
+    used = instrumentation::snapshot() - before;
+    CPPUNIT_ASSERT(used.get(instrument_gmst_evaluations) == 0);
+    CPPUNIT_ASSERT(used.get(instrument_to_ecef_point) == 1);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(p.map_xyz().norm(), out.map_xyz().norm(), .000001);
+  }
+
+  void test_batch()
+  {
+    using namespace fr::coordinates;
+    std::vector<double> lat(100, 39.75), lon(100, -104.87), alt(100, 1609.344);
+    std::vector<double> x(100), y(100), z(100);
+    instrumentation_snapshot before = instrumentation::snapshot();
+    batch_converter<ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), 100);
+    batch_converter<ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), 3);
+    instrumentation_snapshot used = instrumentation::snapshot() - before;
+    CPPUNIT_ASSERT(used.get(instrument_batch_calls) == 2);
+    CPPUNIT_ASSERT(used.get(instrument_batch_points) == 103);
+    CPPUNIT_ASSERT(used.get_count(instrument_batch_size) == 2);
+    CPPUNIT_ASSERT(used.get_sum(instrument_batch_size) == 103);
+    // 3 goes in the up to 4 bucket, 100 in the up to 128 one
+    CPPUNIT_ASSERT(used.buckets[instrument_batch_size][2] == 1);
+    CPPUNIT_ASSERT(used.buckets[instrument_batch_size][7] == 1);
+    // The per point converters weren't called
+    CPPUNIT_ASSERT(used.get(instrument_to_ecef) == 0);
+  }
+
+  // Without FR_COORDINATES_INSTRUMENT the macros are empty statements,
+  // so the same calls as above leave every counter alone
+  void test_compiled_out()
+  {
+    using namespace fr::coordinates;
+    CPPUNIT_ASSERT(!instrumentation::enabled());
+    instrumentation_snapshot before = instrumentation::snapshot();
+    ecef e = converter<ecef>()(lat_long(39.75, -104.87, 1609.344));
+    lat_long back = converter<lat_long>()(e, WGS84_ELLIPSOID, iterative_solver());
+    eci_ecef_rotation r(1000.0);
+    ecef_point out = converter<ecef_point>()(tod_eci_point(6378137.0, 1000.0, 2000.0), r);
+    std::vector<double> lat(100, 39.75), lon(100, -104.87), alt(100, 1609.344);
+    std::vector<double> x(100), y(100), z(100);
+    batch_converter<ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), 100);
+    instrumentation_snapshot used = instrumentation::snapshot() - before;
+    for (size_t i = 0; i < instrument_counter_count; ++i) {
+      CPPUNIT_ASSERT(used.counters[i] == 0);
+    }
+    for (size_t h = 0; h < instrument_histogram_count; ++h) {
+      CPPUNIT_ASSERT(used.get_count((instrument_histogram) h) == 0);
+    }
+    // And the conversions still happened
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(39.75, back.get_lat(), .0000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(e.get_x(), x[99], .000001);
+    CPPUNIT_ASSERT(out.map_xyz().norm() > 6378137.0);
+  }
+
+  static void convert_some(int count)
+  {
+    using namespace fr::coordinates;
+    for (int i = 0; i < count; ++i) {
+      converter<ecef>()(lat_long(39.75, -104.87, (double) i));
+    }
+  }
+
+  void test_threads()
+  {
+    using namespace fr::coordinates;
+    instrumentation_snapshot before = instrumentation::snapshot();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.push_back(std::thread(convert_some, 250));
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+      threads[i].join();
+    }
+    convert_some(1);
+    // The threads have exited, so their counts come from the retired
+    // totals
+    instrumentation_snapshot used = instrumentation::snapshot() - before;
+    CPPUNIT_ASSERT(used.get(instrument_to_ecef) == 1001);
+  }
+
+  void test_write()
+  {
+    using namespace fr::coordinates;
+    instrumentation_snapshot s;
+    s.counters[instrument_to_ecef] = 5;
+    s.buckets[instrument_batch_size][0] = 1;
+    s.buckets[instrument_batch_size][3] = 2;
+    s.buckets[instrument_batch_size][instrument_buckets - 1] = 1;
+    s.sums[instrument_batch_size] = 1 + 8 + 8 + 5000000000ULL;
+    std::ostringstream out;
+    s.write(out);
+    std::string text = out.str();
+    CPPUNIT_ASSERT(text.find("# TYPE fr_coordinates_to_ecef counter\nfr_coordinates_to_ecef 5\n") != std::string::npos);
+    CPPUNIT_ASSERT(text.find("fr_coordinates_to_lat_long 0\n") != std::string::npos);
+    CPPUNIT_ASSERT(text.find("# TYPE fr_coordinates_batch_size histogram\n") != std::string::npos);
+    CPPUNIT_ASSERT(text.find("fr_coordinates_batch_size_bucket{le=\"1\"} 1\n") != std::string::npos);
+    CPPUNIT_ASSERT(text.find("fr_coordinates_batch_size_bucket{le=\"4\"} 1\n") != std::string::npos);
+    CPPUNIT_ASSERT(text.find("fr_coordinates_batch_size_bucket{le=\"8\"} 3\n") != std::string::npos);
+    CPPUNIT_ASSERT(text.find("fr_coordinates_batch_size_bucket{le=\"+Inf\"} 4\n") != std::string::npos);
+    CPPUNIT_ASSERT(text.find("fr_coordinates_batch_size_sum 5000000017\n") != std::string::npos);
+    CPPUNIT_ASSERT(text.find("fr_coordinates_batch_size_count 4\n") != std::string::npos);
+    CPPUNIT_ASSERT(text.find("fr_coordinates_solver_iterations_bucket{le=\"0\"} 0\n") != std::string::npos);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(instrumentation_test);
@@ -0,0 +1,132 @@
+/**
+ * Checks the precomputed segment interpolators against the
+ * interpolate methods on tod_eci and tod_eci_vel
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "interpolator.hpp"
+#include <vector>
+
+class interpolator_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(interpolator_test);
+  CPPUNIT_TEST(test_tod_eci);
+  CPPUNIT_TEST(test_tod_eci_vel);
+  CPPUNIT_TEST(test_parallel);
+  CPPUNIT_TEST(test_hermite);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::vector<double> times;
+
+public:
+
+  void setUp()
+  {
+    // Includes both endpoints and a little extrapolation off each end
+    times.clear();
+    for (int i = -10; i <= 1010; ++i) {
+      times.push_back(1000.0 + 0.06 * (double) i);
+    }
+  }
+
+  void test_tod_eci()
+  {
+    fr::coordinates::tod_eci now(6678137.0, 0.0, 0.0);
+    fr::coordinates::tod_eci next(6670000.0, 418000.0, 120000.0);
+    fr::coordinates::tod_eci_segment segment(now, 1000.0, next, 1060.0);
+    std::vector<fr::coordinates::tod_eci_point> batch(times.size());
+    segment.interpolate(times.data(), batch.data(), times.size());
+    for (size_t i = 0; i < times.size(); ++i) {
+      fr::coordinates::tod_eci expected = now.interpolate(1000.0, next, 1060.0, times[i]);
+      fr::coordinates::tod_eci single = segment.interpolate(times[i]);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_x(), single.get_x(), .00001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_y(), single.get_y(), .00001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_z(), single.get_z(), .00001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_x(), batch[i].x, .00001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_y(), batch[i].y, .00001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_z(), batch[i].z, .00001);
+    }
+  }
+
+  void test_tod_eci_vel()
+  {
+    fr::coordinates::tod_eci_vel now(6678137.0, 0.0, 0.0, 0.0, 7700.0, 1000.0);
+    fr::coordinates::tod_eci_vel next(6670000.0, 418000.0, 120000.0, -480.0, 7680.0, 990.0);
+    fr::coordinates::tod_eci_vel_segment segment(now, 1000.0, next, 1060.0);
+    std::vector<fr::coordinates::tod_eci_vel_point> batch(times.size());
+    segment.interpolate(times.data(), batch.data(), times.size());
+    for (size_t i = 0; i < times.size(); ++i) {
+      fr::coordinates::tod_eci_vel expected = now.interpolate(1000.0, next, 1060.0, times[i]);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_x(), batch[i].x, .00001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_y(), batch[i].y, .00001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_z(), batch[i].z, .00001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_dx(), batch[i].dx, .0000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_dy(), batch[i].dy, .0000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_dz(), batch[i].dz, .0000001);
+    }
+  }
+
+  // Same direction, different lengths. interpolate_3x3 has no rotation
+  // axis to work with here, so just check the length scales linearly
+  void test_parallel()
+  {
+    fr::coordinates::tod_eci_point now(7000000.0, 0.0, 0.0);
+    fr::coordinates::tod_eci_point next(8000000.0, 0.0, 0.0);
+    fr::coordinates::tod_eci_segment segment(now, 0.0, next, 10.0);
+    fr::coordinates::tod_eci half = segment.interpolate(5.0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(7500000.0, half.get_x(), .00001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, half.get_y(), .00001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, half.get_z(), .00001);
+  }
+
+  // Hermite interpolation is exact for any cubic path, and has to hit
+  // both endpoints exactly
+  static fr::coordinates::tod_eci_vel cubic(double t)
+  {
+    return fr::coordinates::tod_eci_vel(7000000.0 + 20.0 * t - 3.0 * t * t + 0.01 * t * t * t, 7500.0 * t + 0.5 * t * t, -1000.0 + 0.02 * t * t * t,
+					20.0 - 6.0 * t + 0.03 * t * t, 7500.0 + t, 0.06 * t * t);
+  }
+
+  void test_hermite()
+  {
+    fr::coordinates::tod_eci_vel_hermite_segment segment(cubic(0.0), 1000.0, cubic(300.0), 1300.0);
+    std::vector<double> at;
+    for (size_t i = 0; i < times.size(); ++i) {
+      at.push_back(1000.0 + 5.0 * (times[i] - 1000.0));
+    }
+    std::vector<fr::coordinates::tod_eci_vel_point> batch(at.size());
+    segment.interpolate(at.data(), batch.data(), at.size());
+    for (size_t i = 0; i < at.size(); ++i) {
+      fr::coordinates::tod_eci_vel expected = cubic(at[i] - 1000.0);
+      fr::coordinates::tod_eci_vel single = segment.interpolate(at[i]);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_x(), batch[i].x, .0001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_y(), batch[i].y, .0001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_z(), batch[i].z, .0001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_dx(), batch[i].dx, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_dy(), batch[i].dy, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_dz(), batch[i].dz, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(batch[i].x, single.get_x(), .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(batch[i].dz, single.get_dz(), .000001);
+    }
+    fr::coordinates::tod_eci_vel end = segment.interpolate(1300.0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(cubic(300.0).get_x(), end.get_x(), .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(cubic(300.0).get_dy(), end.get_dy(), .000001);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(interpolator_test);
@@ -0,0 +1,155 @@
+/**
+ * Tests the ENU and NED local frames
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "coordinates.hpp"
+#include <vector>
+
+class local_frame_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(local_frame_test);
+  CPPUNIT_TEST(test_axes);
+  CPPUNIT_TEST(test_round_trip);
+  CPPUNIT_TEST(test_ned);
+  CPPUNIT_TEST(test_batch);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+
+  // At 0,0 east is +y, north is +z and up is +x in ECEF
+  void test_axes()
+  {
+    fr::coordinates::local_frame f(fr::coordinates::lat_long(0.0, 0.0, 0.0));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(fr::coordinates::WGS84_ELLIPSOID.ae, f.get_origin().x, .000001);
+    fr::coordinates::converter<fr::coordinates::enu_point> to_enu;
+    fr::coordinates::enu_point p = to_enu(fr::coordinates::ecef_point(fr::coordinates::WGS84_ELLIPSOID.ae + 100.0, 10.0, 20.0), f);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(10.0, p.x, .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(20.0, p.y, .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(100.0, p.z, .000001);
+
+    // A point straight up from the origin is all up, anywhere
+    fr::coordinates::local_frame denver(fr::coordinates::lat_long(39.7392, -104.9903, 1609.0));
+    fr::coordinates::enu_point above = to_enu(fr::coordinates::lat_long(39.7392, -104.9903, 2609.0), denver);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, above.x, .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, above.y, .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1000.0, above.z, .000001);
+
+    // A little north and east of it is north and east
+    fr::coordinates::enu_point ne = to_enu(fr::coordinates::lat_long(39.75, -104.98, 1609.0), denver);
+    CPPUNIT_ASSERT(ne.x > 800.0 && ne.x < 900.0);
+    CPPUNIT_ASSERT(ne.y > 1100.0 && ne.y < 1300.0);
+    CPPUNIT_ASSERT(ne.z < 0.0);
+
+    // Building the frame from ECEF gets the same one
+    fr::coordinates::local_frame denver2(denver.get_origin());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(39.7392, denver2.get_origin_lat_long().get_lat(), .0000000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1609.0, denver2.get_origin_lat_long().get_alt(), .000001);
+    CPPUNIT_ASSERT((denver.get_rotation(fr::coordinates::enu_frame()) - denver2.get_rotation(fr::coordinates::enu_frame())).norm() < 1e-12);
+  }
+
+  void test_round_trip()
+  {
+    fr::coordinates::local_frame f(fr::coordinates::lat_long(-33.86, 151.21, 58.0));
+    fr::coordinates::lat_long target(-33.5, 151.9, 10000.0);
+    fr::coordinates::enu_point p = fr::coordinates::converter<fr::coordinates::enu_point>()(target, f);
+    fr::coordinates::lat_long back = fr::coordinates::converter<fr::coordinates::lat_long>()(p, f);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target.get_lat(), back.get_lat(), .0000000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target.get_long(), back.get_long(), .0000000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target.get_alt(), back.get_alt(), .00001);
+
+    fr::coordinates::ecef e = fr::coordinates::converter<fr::coordinates::ecef>()(p, f);
+    fr::coordinates::ecef expected = fr::coordinates::converter<fr::coordinates::ecef>()(target);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_x(), e.get_x(), .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_y(), e.get_y(), .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_z(), e.get_z(), .000001);
+
+    // Distance is preserved
+    fr::coordinates::ecef_point origin = f.get_origin();
+    double range = (expected.get_xyz() - origin.get_xyz()).norm();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(range, p.get_xyz().norm(), .000001);
+  }
+
+  void test_ned()
+  {
+    fr::coordinates::local_frame f(fr::coordinates::lat_long(51.48, -0.0015, 45.0));
+    fr::coordinates::lat_long target(51.5, 0.1, 500.0);
+    fr::coordinates::enu_point enu = fr::coordinates::converter<fr::coordinates::enu_point>()(target, f);
+    fr::coordinates::ned_point ned = fr::coordinates::converter<fr::coordinates::ned_point>()(target, f);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(enu.y, ned.x, .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(enu.x, ned.y, .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(-enu.z, ned.z, .000001);
+
+    fr::coordinates::ned_point swapped = fr::coordinates::converter<fr::coordinates::ned_point>()(enu);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(ned.x, swapped.x, .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(ned.y, swapped.y, .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(ned.z, swapped.z, .000001);
+
+    fr::coordinates::ecef_point from_ned = fr::coordinates::converter<fr::coordinates::ecef_point>()(ned, f);
+    fr::coordinates::ecef_point from_enu = fr::coordinates::converter<fr::coordinates::ecef_point>()(enu, f);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(from_enu.x, from_ned.x, .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(from_enu.y, from_ned.y, .000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(from_enu.z, from_ned.z, .000001);
+  }
+
+  // Batches against the single point converters
+  template <typename point_type>
+  void check_batch(const fr::coordinates::local_frame &f, const std::vector<double> &lat, const std::vector<double> &lon, const std::vector<double> &alt)
+  {
+    size_t count = lat.size();
+    std::vector<fr::coordinates::ecef_point> ecef(count), ecef2(count);
+    std::vector<point_type> from_ecef(count), from_lat_long(count);
+    std::vector<double> lat2(count), lon2(count), alt2(count);
+    for (size_t i = 0; i < count; ++i) {
+      ecef[i] = fr::coordinates::converter<fr::coordinates::ecef_point>()(fr::coordinates::lat_long(lat[i], lon[i], alt[i]));
+    }
+    fr::coordinates::batch_converter<point_type>()(ecef.data(), from_ecef.data(), count, f);
+    fr::coordinates::batch_converter<point_type>()(lat.data(), lon.data(), alt.data(), from_lat_long.data(), count, f);
+    fr::coordinates::batch_converter<fr::coordinates::ecef_point>()(from_ecef.data(), ecef2.data(), count, f);
+    fr::coordinates::batch_converter<fr::coordinates::lat_long>()(from_ecef.data(), lat2.data(), lon2.data(), alt2.data(), count, f);
+    for (size_t i = 0; i < count; ++i) {
+      point_type expected = fr::coordinates::converter<point_type>()(ecef[i], f);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.x, from_ecef[i].x, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.y, from_ecef[i].y, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.z, from_ecef[i].z, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.x, from_lat_long[i].x, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.y, from_lat_long[i].y, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.z, from_lat_long[i].z, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].x, ecef2[i].x, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].y, ecef2[i].y, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(ecef[i].z, ecef2[i].z, .000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(lat[i], lat2[i], .0000000001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(alt[i], alt2[i], .00001);
+    }
+  }
+
+  void test_batch()
+  {
+    fr::coordinates::local_frame f(fr::coordinates::lat_long(64.2, -149.5, 200.0));
+    std::vector<double> lat, lon, alt;
+    for (int i = 0; i < 100; ++i) {
+      lat.push_back(63.0 + i * 0.025);
+      lon.push_back(-151.0 + i * 0.03);
+      alt.push_back(100.0 * i);
+    }
+    check_batch<fr::coordinates::enu_point>(f, lat, lon, alt);
+    check_batch<fr::coordinates::ned_point>(f, lat, lon, alt);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(local_frame_test);
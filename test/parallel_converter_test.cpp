@@ -0,0 +1,175 @@
+/**
+ * Checks that the parallel converters give exactly the same output as
+ * the serial batch converters
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "parallel_converts.hpp"
+#include "simd_dispatch.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+class parallel_converter_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(parallel_converter_test);
+  CPPUNIT_TEST(test_slices);
+  CPPUNIT_TEST(test_lat_long_ecef);
+  CPPUNIT_TEST(test_eci_ecef);
+  CPPUNIT_TEST(test_exceptions);
+  CPPUNIT_TEST_SUITE_END();
+
+  // Big enough to be split, and not a multiple of the slice grain
+  enum { count = 100003 };
+
+  std::vector<double> lat, lon, alt, times;
+  std::vector<fr::coordinates::tod_eci_vel_point> states;
+  std::vector<fr::coordinates::tod_eci_point> positions;
+
+  template <typename T>
+  static bool same(const std::vector<T> &a, const std::vector<T> &b)
+  {
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+  }
+
+public:
+
+  void setUp()
+  {
+    lat.resize(count);
+    lon.resize(count);
+    alt.resize(count);
+    times.resize(count);
+    states.resize(count);
+    positions.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      lat[i] = -90.0 + 180.0 * (double) ((i * 7919) % count) / (double) count;
+      lon[i] = -180.0 + 360.0 * (double) ((i * 104729) % count) / (double) count;
+      alt[i] = (double) (i % 40000) * 1000.0;
+      times[i] = 1381968000.0 + (double) i * 0.5;
+      double phase = (double) i * 0.001;
+      states[i] = fr::coordinates::tod_eci_vel_point(7000000.0 * cos(phase), 7000000.0 * sin(phase), (double) (i % 1000), -7500.0 * sin(phase), 7500.0 * cos(phase), 1.0);
+      positions[i] = fr::coordinates::tod_eci_point(states[i].x, states[i].y, states[i].z);
+    }
+  }
+
+  void test_slices()
+  {
+    // Slices cover every point once and start on the grain
+    const size_t counts[] = { 0, 1, 63, 64, 65, 100003 };
+    for (size_t c = 0; c < 6; ++c) {
+      for (size_t workers = 1; workers < 9; ++workers) {
+	size_t next = 0;
+	for (size_t w = 0; w < workers; ++w) {
+	  size_t begin, end;
+	  fr::coordinates::slice_bounds(counts[c], workers, w, begin, end);
+	  CPPUNIT_ASSERT_EQUAL(next, begin);
+	  CPPUNIT_ASSERT(begin % fr::coordinates::slice_grain == 0 || begin == counts[c]);
+	  next = end;
+	}
+	CPPUNIT_ASSERT_EQUAL(counts[c], next);
+      }
+    }
+  }
+
+  void test_lat_long_ecef()
+  {
+    fr::coordinates::thread_pool pool(4);
+    CPPUNIT_ASSERT_EQUAL((size_t) 4, pool.size());
+    fr::coordinates::parallel_converter<fr::coordinates::ecef> to_ecef(pool);
+    fr::coordinates::parallel_converter<fr::coordinates::lat_long> to_lat_long(pool);
+    std::vector<double> x(count), y(count), z(count), px(count), py(count), pz(count);
+    fr::coordinates::batch_converter<fr::coordinates::ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count);
+    to_ecef(lat.data(), lon.data(), alt.data(), px.data(), py.data(), pz.data(), count);
+    CPPUNIT_ASSERT(same(x, px) && same(y, py) && same(z, pz));
+
+    std::vector<double> lat2(count), lon2(count), alt2(count), plat(count), plon(count), palt(count);
+    fr::coordinates::batch_converter<fr::coordinates::lat_long>()(x.data(), y.data(), z.data(), lat2.data(), lon2.data(), alt2.data(), count);
+    to_lat_long(x.data(), y.data(), z.data(), plat.data(), plon.data(), palt.data(), count);
+    CPPUNIT_ASSERT(same(lat2, plat) && same(lon2, plon) && same(alt2, palt));
+    to_lat_long(x.data(), y.data(), z.data(), plat.data(), plon.data(), palt.data(), count, fr::coordinates::WGS84_ELLIPSOID, fr::coordinates::bowring_solver<2>());
+    fr::coordinates::batch_converter<fr::coordinates::lat_long>()(x.data(), y.data(), z.data(), lat2.data(), lon2.data(), alt2.data(), count, fr::coordinates::WGS84_ELLIPSOID, fr::coordinates::bowring_solver<2>());
+    CPPUNIT_ASSERT(same(lat2, plat) && same(lon2, plon) && same(alt2, palt));
+
+    // Math policies go through to the batch converter, dispatched
+    // kernels included
+    fr::coordinates::batch_converter<fr::coordinates::ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count, fr::coordinates::WGS84_ELLIPSOID, fr::coordinates::fast_math());
+    to_ecef(lat.data(), lon.data(), alt.data(), px.data(), py.data(), pz.data(), count, fr::coordinates::WGS84_ELLIPSOID, fr::coordinates::fast_math());
+    CPPUNIT_ASSERT(same(x, px) && same(y, py) && same(z, pz));
+    fr::coordinates::dispatched<fr::coordinates::fast_math> dispatch;
+    fr::coordinates::batch_converter<fr::coordinates::ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count, fr::coordinates::WGS84_ELLIPSOID, dispatch);
+    to_ecef(lat.data(), lon.data(), alt.data(), px.data(), py.data(), pz.data(), count, fr::coordinates::WGS84_ELLIPSOID, dispatch);
+    CPPUNIT_ASSERT(same(x, px) && same(y, py) && same(z, pz));
+    fr::coordinates::batch_converter<fr::coordinates::lat_long>()(x.data(), y.data(), z.data(), lat2.data(), lon2.data(), alt2.data(), count, fr::coordinates::WGS84_ELLIPSOID, dispatch);
+    to_lat_long(x.data(), y.data(), z.data(), plat.data(), plon.data(), palt.data(), count, fr::coordinates::WGS84_ELLIPSOID, dispatch);
+    CPPUNIT_ASSERT(same(lat2, plat) && same(lon2, plon) && same(alt2, palt));
+  }
+
+  void test_eci_ecef()
+  {
+    fr::coordinates::thread_pool pool(3);
+    fr::coordinates::parallel_converter<fr::coordinates::ecef_point> to_ecef_point(pool);
+    fr::coordinates::parallel_converter<fr::coordinates::tod_eci_point> to_eci_point(pool);
+    fr::coordinates::parallel_converter<fr::coordinates::ecef_vel_point> to_ecef_vel(pool);
+    fr::coordinates::parallel_converter<fr::coordinates::tod_eci_vel_point> to_eci_vel(pool);
+    double t = 1381968000.0;
+    std::vector<fr::coordinates::ecef_point> ecef(count), pecef(count);
+    fr::coordinates::batch_converter<fr::coordinates::ecef_point>()(positions.data(), ecef.data(), count, t);
+    to_ecef_point(positions.data(), pecef.data(), count, t);
+    CPPUNIT_ASSERT(same(ecef, pecef));
+    fr::coordinates::batch_converter<fr::coordinates::ecef_point>()(positions.data(), times.data(), ecef.data(), count);
+    to_ecef_point(positions.data(), times.data(), pecef.data(), count);
+    CPPUNIT_ASSERT(same(ecef, pecef));
+
+    std::vector<fr::coordinates::tod_eci_point> eci(count), peci(count);
+    fr::coordinates::batch_converter<fr::coordinates::tod_eci_point>()(ecef.data(), eci.data(), count, t);
+    to_eci_point(ecef.data(), peci.data(), count, t);
+    CPPUNIT_ASSERT(same(eci, peci));
+
+    std::vector<fr::coordinates::ecef_vel_point> ecef_vel(count), pecef_vel(count);
+    fr::coordinates::batch_converter<fr::coordinates::ecef_vel_point>()(states.data(), ecef_vel.data(), count, t);
+    to_ecef_vel(states.data(), pecef_vel.data(), count, t);
+    CPPUNIT_ASSERT(same(ecef_vel, pecef_vel));
+    fr::coordinates::batch_converter<fr::coordinates::ecef_vel_point>()(states.data(), times.data(), ecef_vel.data(), count);
+    to_ecef_vel(states.data(), times.data(), pecef_vel.data(), count);
+    CPPUNIT_ASSERT(same(ecef_vel, pecef_vel));
+
+    std::vector<fr::coordinates::tod_eci_vel_point> eci_vel(count), peci_vel(count);
+    fr::coordinates::batch_converter<fr::coordinates::tod_eci_vel_point>()(ecef_vel.data(), eci_vel.data(), count, t);
+    to_eci_vel(ecef_vel.data(), peci_vel.data(), count, t);
+    CPPUNIT_ASSERT(same(eci_vel, peci_vel));
+  }
+
+  void test_exceptions()
+  {
+    fr::coordinates::thread_pool pool(4);
+    CPPUNIT_ASSERT_THROW(pool.run([](size_t index) {
+	  if (index == 2) {
+	    throw std::runtime_error("worker failed");
+	  }
+	}), std::runtime_error);
+    // Pool still works afterward
+    std::vector<int> ran(pool.size(), 0);
+    pool.run([&](size_t index) { ran[index] = 1; });
+    for (size_t i = 0; i < ran.size(); ++i) {
+      CPPUNIT_ASSERT_EQUAL(1, ran[i]);
+    }
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(parallel_converter_test);
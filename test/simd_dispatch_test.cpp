@@ -0,0 +1,136 @@
+/**
+ * Tests that every SIMD backend this CPU supports gives the same
+ * answers as the kernels called directly
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "simd_dispatch.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+class simd_dispatch_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(simd_dispatch_test);
+  CPPUNIT_TEST(test_selection);
+  CPPUNIT_TEST(test_kernels);
+  CPPUNIT_TEST_SUITE_END();
+
+  // Same spread of points as the benchmarks
+  void fill(size_t count, std::vector<double> &lat, std::vector<double> &lon, std::vector<double> &alt)
+  {
+    lat.resize(count);
+    lon.resize(count);
+    alt.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      lat[i] = -89.0 + 178.0 * (double) ((i * 7919) % count) / (double) count;
+      lon[i] = -180.0 + 360.0 * (double) ((i * 104729) % count) / (double) count;
+      alt[i] = (double) (i % 10000);
+    }
+  }
+
+  template <typename math>
+  void check_backend(fr::coordinates::simd_backend b)
+  {
+    using namespace fr::coordinates;
+    simd_dispatch::force(b);
+    CPPUNIT_ASSERT(simd_dispatch::active() == b);
+
+    // Not a multiple of any vector width, so the tails get run too
+    const size_t count = 1001;
+    std::vector<double> lat, lon, alt;
+    fill(count, lat, lon, alt);
+    std::vector<double> x(count), y(count), z(count), x2(count), y2(count), z2(count);
+    batch_converter<ecef>()(lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data(), count, WGS84_ELLIPSOID, math());
+    batch_converter<ecef>()(lat.data(), lon.data(), alt.data(), x2.data(), y2.data(), z2.data(), count, WGS84_ELLIPSOID, dispatched<math>());
+    for (size_t i = 0; i < count; ++i) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(x[i], x2[i], 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(y[i], y2[i], 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(z[i], z2[i], 1e-6);
+    }
+
+    std::vector<double> lat2(count), lon2(count), alt2(count), lat3(count), lon3(count), alt3(count);
+    batch_converter<lat_long>()(x.data(), y.data(), z.data(), lat2.data(), lon2.data(), alt2.data(), count, WGS84_ELLIPSOID, basic_vermeille_solver<math>());
+    batch_converter<lat_long>()(x.data(), y.data(), z.data(), lat3.data(), lon3.data(), alt3.data(), count, WGS84_ELLIPSOID, dispatched<math>());
+    for (size_t i = 0; i < count; ++i) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(lat2[i], lat3[i], 1e-11);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(lon2[i], lon3[i], 1e-11);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(alt2[i], alt3[i], 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(lat[i], lat3[i], 1e-9);
+    }
+
+    lat_long from(39.75, -104.87);
+    haversine_distance h;
+    std::vector<double> d(count), d2(count), b1(count), b2(count), d3(count), b3(count);
+    h.distances(from, lat.data(), lon.data(), d.data(), count, math());
+    h.distances(from, lat.data(), lon.data(), d2.data(), count, dispatched<math>());
+    bearing()(from, lat.data(), lon.data(), b1.data(), count, math());
+    bearing()(from, lat.data(), lon.data(), b2.data(), count, dispatched<math>());
+    h.distances_and_bearings(from, lat.data(), lon.data(), d3.data(), b3.data(), count, dispatched<math>());
+    for (size_t i = 0; i < count; ++i) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(d[i], d2[i], 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(d[i], d3[i], 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(b1[i], b2[i], 1e-9);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(b1[i], b3[i], 1e-9);
+    }
+
+    // Many to many goes through the same kernels
+    std::vector<double> grid(4 * count);
+    h.distances(lat.data(), lon.data(), 4, lat.data(), lon.data(), count, grid.data(), dispatched<math>());
+    for (size_t i = 0; i < count; ++i) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(h.distance(lat_long(lat[3], lon[3]), lat_long(lat[i], lon[i])), grid[3 * count + i], 1e-6);
+    }
+  }
+
+public:
+
+  void test_selection()
+  {
+    using namespace fr::coordinates;
+    CPPUNIT_ASSERT(simd_dispatch::supported(simd_scalar));
+    CPPUNIT_ASSERT(simd_dispatch::supported(simd_dispatch::best()));
+    CPPUNIT_ASSERT(!simd_dispatch::supported(simd_backend_count));
+    CPPUNIT_ASSERT_THROW(simd_dispatch::force(simd_backend_count), std::invalid_argument);
+    for (int i = simd_scalar; i < simd_backend_count; ++i) {
+      simd_backend b = simd_scalar;
+      CPPUNIT_ASSERT(simd_dispatch::parse(simd_dispatch::name((simd_backend) i), b));
+      CPPUNIT_ASSERT_EQUAL(i, (int) b);
+    }
+    simd_backend b = simd_avx2;
+    CPPUNIT_ASSERT(!simd_dispatch::parse("altivec", b));
+    CPPUNIT_ASSERT(b == simd_avx2);
+#if defined(__x86_64__)
+    CPPUNIT_ASSERT(simd_dispatch::best() >= simd_sse2);
+#endif
+  }
+
+  void test_kernels()
+  {
+    using namespace fr::coordinates;
+    simd_backend was = simd_dispatch::active();
+    for (int i = simd_scalar; i < simd_backend_count; ++i) {
+      if (simd_dispatch::supported((simd_backend) i)) {
+	check_backend<precise_math>((simd_backend) i);
+	check_backend<fast_math>((simd_backend) i);
+      }
+    }
+    simd_dispatch::force(was);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(simd_dispatch_test);
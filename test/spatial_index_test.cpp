@@ -0,0 +1,228 @@
+/**
+ * Checks the spatial index against a brute force haversine scan
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "converts.hpp"
+#include "haversine_distance.hpp"
+#include "spatial_index.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+class spatial_index_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(spatial_index_test);
+  CPPUNIT_TEST(test_within);
+  CPPUNIT_TEST(test_nearest);
+  CPPUNIT_TEST(test_insert_remove);
+  CPPUNIT_TEST(test_sorted_inserts);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::vector<double> lat, lon;
+  std::vector<fr::coordinates::lat_long> queries;
+
+  static double uniform(double lo, double hi)
+  {
+    return lo + (hi - lo) * (rand() / (double) RAND_MAX);
+  }
+
+  // Brute force equivalent of within, sorted by id
+  std::vector<size_t> scan(const fr::coordinates::lat_long &center, double radius, const std::vector<bool> &alive)
+  {
+    fr::coordinates::haversine_distance haversine;
+    std::vector<double> dist(lat.size());
+    haversine.distances(center, lat.data(), lon.data(), dist.data(), lat.size());
+    std::vector<size_t> retval;
+    for (size_t i = 0; i < dist.size(); ++i) {
+      if (alive[i] && dist[i] <= radius) {
+	retval.push_back(i);
+      }
+    }
+    return retval;
+  }
+
+  static std::vector<size_t> ids(const std::vector<fr::coordinates::lat_long_index::neighbor> &found)
+  {
+    std::vector<size_t> retval;
+    for (size_t i = 0; i < found.size(); ++i) {
+      retval.push_back(found[i].id);
+    }
+    std::sort(retval.begin(), retval.end());
+    return retval;
+  }
+
+public:
+
+  void setUp()
+  {
+    srand(42);
+    lat.clear();
+    lon.clear();
+    queries.clear();
+    for (int i = 0; i < 5000; ++i) {
+      lat.push_back(asin(uniform(-1.0, 1.0)) * 180.0 / fr::constants::pi);
+      lon.push_back(uniform(-180.0, 180.0));
+    }
+    // A cluster, so some queries have a lot of close together points
+    for (int i = 0; i < 500; ++i) {
+      lat.push_back(uniform(39.0, 40.0));
+      lon.push_back(uniform(-105.5, -104.5));
+    }
+    // Poles and the antimeridian
+    queries.push_back(fr::coordinates::lat_long(39.5, -105.0));
+    queries.push_back(fr::coordinates::lat_long(90.0, 0.0));
+    queries.push_back(fr::coordinates::lat_long(-90.0, 0.0));
+    queries.push_back(fr::coordinates::lat_long(10.0, 180.0));
+    queries.push_back(fr::coordinates::lat_long(-10.0, -179.9));
+    for (int i = 0; i < 20; ++i) {
+      queries.push_back(fr::coordinates::lat_long(uniform(-90.0, 90.0), uniform(-180.0, 180.0)));
+    }
+  }
+
+  void test_within()
+  {
+    fr::coordinates::lat_long_index index;
+    index.build(lat.data(), lon.data(), lat.size());
+    CPPUNIT_ASSERT_EQUAL(lat.size(), index.size());
+    std::vector<bool> alive(lat.size(), true);
+    fr::coordinates::haversine_distance haversine;
+    const double radii[] = { 1000.0, 50000.0, 1000000.0, 30000000.0 };
+    for (size_t q = 0; q < queries.size(); ++q) {
+      for (int r = 0; r < 4; ++r) {
+	std::vector<fr::coordinates::lat_long_index::neighbor> found = index.within(queries[q], radii[r]);
+	// Anything right on the edge could go either way from rounding
+	std::vector<size_t> expected = scan(queries[q], radii[r] - 0.001, alive);
+	std::vector<size_t> loose = scan(queries[q], radii[r] + 0.001, alive);
+	std::vector<size_t> got = ids(found);
+	CPPUNIT_ASSERT(std::includes(got.begin(), got.end(), expected.begin(), expected.end()));
+	CPPUNIT_ASSERT(std::includes(loose.begin(), loose.end(), got.begin(), got.end()));
+	for (size_t i = 0; i < found.size(); ++i) {
+	  double expected_dist = haversine.distance(queries[q], index.get(found[i].id));
+	  CPPUNIT_ASSERT_DOUBLES_EQUAL(expected_dist, found[i].distance, .001);
+	}
+      }
+    }
+  }
+
+  void test_nearest()
+  {
+    fr::coordinates::lat_long_index index;
+    index.build(lat.data(), lon.data(), lat.size());
+    fr::coordinates::haversine_distance haversine;
+    std::vector<double> dist(lat.size());
+    for (size_t q = 0; q < queries.size(); ++q) {
+      haversine.distances(queries[q], lat.data(), lon.data(), dist.data(), lat.size());
+      std::sort(dist.begin(), dist.end());
+      std::vector<fr::coordinates::lat_long_index::neighbor> found = index.nearest(queries[q], 10);
+      CPPUNIT_ASSERT_EQUAL((size_t) 10, found.size());
+      for (size_t i = 0; i < found.size(); ++i) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(dist[i], found[i].distance, .001);
+      }
+    }
+    std::vector<fr::coordinates::lat_long_index::neighbor> all = index.nearest(queries[0], lat.size() + 10);
+    CPPUNIT_ASSERT_EQUAL(lat.size(), all.size());
+    CPPUNIT_ASSERT(index.nearest(queries[0], 0).empty());
+  }
+
+  void test_insert_remove()
+  {
+    fr::coordinates::lat_long_index index;
+    std::vector<bool> alive(lat.size(), true);
+    // Half by bulk load, half one at a time
+    size_t half = lat.size() / 2;
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, index.build(lat.data(), lon.data(), half));
+    for (size_t i = half; i < lat.size(); ++i) {
+      CPPUNIT_ASSERT_EQUAL(i, index.insert(fr::coordinates::lat_long(lat[i], lon[i])));
+    }
+    for (size_t i = 0; i < lat.size(); i += 3) {
+      CPPUNIT_ASSERT(index.remove(i));
+      alive[i] = false;
+    }
+    CPPUNIT_ASSERT(!index.remove(0));
+    CPPUNIT_ASSERT(!index.remove(lat.size()));
+    CPPUNIT_ASSERT(!index.contains(3));
+    CPPUNIT_ASSERT(index.contains(4));
+    for (size_t q = 0; q < queries.size(); ++q) {
+      std::vector<size_t> got = ids(index.within(queries[q], 2000000.0));
+      std::vector<size_t> expected = scan(queries[q], 2000000.0 - 0.001, alive);
+      CPPUNIT_ASSERT(std::includes(got.begin(), got.end(), expected.begin(), expected.end()));
+      std::vector<fr::coordinates::lat_long_index::neighbor> found = index.nearest(queries[q], 5);
+      for (size_t i = 0; i < found.size(); ++i) {
+	CPPUNIT_ASSERT(alive[found[i].id]);
+      }
+    }
+    // Removing most of them forces a rebuild, which has to keep ids
+    for (size_t i = 0; i < lat.size(); ++i) {
+      if (i % 10 != 0) {
+	index.remove(i);
+	alive[i] = false;
+      }
+    }
+    for (size_t q = 0; q < queries.size(); ++q) {
+      std::vector<size_t> got = ids(index.within(queries[q], 3000000.0));
+      std::vector<size_t> expected = scan(queries[q], 3000000.0 - 0.001, alive);
+      std::vector<size_t> loose = scan(queries[q], 3000000.0 + 0.001, alive);
+      CPPUNIT_ASSERT(std::includes(got.begin(), got.end(), expected.begin(), expected.end()));
+      CPPUNIT_ASSERT(std::includes(loose.begin(), loose.end(), got.begin(), got.end()));
+    }
+    // ECEF insert lands at the same spot
+    fr::coordinates::ecef_point p;
+    fr::coordinates::lat_long_to_xyz(fr::coordinates::lat_long(39.5, -105.0, 1600.0), fr::coordinates::WGS84_ELLIPSOID, p.x, p.y, p.z);
+    size_t id = index.insert(p);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(39.5, index.get(id).get_lat(), .0000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, index.nearest(fr::coordinates::lat_long(39.5, -105.0), 1)[0].distance, .001);
+  }
+
+  // Inserting in sorted order used to hang each point off the last one,
+  // making a chain as deep as the index was big
+  void test_sorted_inserts()
+  {
+    fr::coordinates::lat_long_index index;
+    const size_t count = 100000;
+    std::vector<double> sorted_lat(count), sorted_lon(count);
+    for (size_t i = 0; i < count; ++i) {
+      sorted_lat[i] = -80.0 + 160.0 * (double) i / (double) count;
+      sorted_lon[i] = -170.0 + 340.0 * (double) i / (double) count;
+      CPPUNIT_ASSERT_EQUAL(i, index.insert(fr::coordinates::lat_long(sorted_lat[i], sorted_lon[i])));
+    }
+    CPPUNIT_ASSERT(index.depth() <= 2 * 17 + 1);
+    fr::coordinates::haversine_distance haversine;
+    std::vector<double> dist(count);
+    for (size_t q = 0; q < queries.size(); ++q) {
+      haversine.distances(queries[q], sorted_lat.data(), sorted_lon.data(), dist.data(), count);
+      std::vector<size_t> expected, loose;
+      for (size_t i = 0; i < count; ++i) {
+	if (dist[i] <= 500000.0 - 0.001) {
+	  expected.push_back(i);
+	}
+	if (dist[i] <= 500000.0 + 0.001) {
+	  loose.push_back(i);
+	}
+      }
+      std::vector<size_t> got = ids(index.within(queries[q], 500000.0));
+      CPPUNIT_ASSERT(std::includes(got.begin(), got.end(), expected.begin(), expected.end()));
+      CPPUNIT_ASSERT(std::includes(loose.begin(), loose.end(), got.begin(), got.end()));
+      std::vector<fr::coordinates::lat_long_index::neighbor> found = index.nearest(queries[q], 3);
+      CPPUNIT_ASSERT_EQUAL((size_t) 3, found.size());
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(*std::min_element(dist.begin(), dist.end()), found[0].distance, .001);
+    }
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(spatial_index_test);
@@ -0,0 +1,152 @@
+/**
+ * Streams points through stream_converter and checks they come out
+ * the same, and in the same order, as converting them one at a time
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "batch_converts.hpp"
+#include "stream_converter.hpp"
+#include <stdexcept>
+#include <vector>
+
+class stream_converter_test : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(stream_converter_test);
+  CPPUNIT_TEST(test_each);
+  CPPUNIT_TEST(test_chunk_converter);
+  CPPUNIT_TEST(test_errors);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::vector<fr::coordinates::ecef_point> points;
+
+  // Hands out points in uneven chunks, never more than asked for
+  struct source {
+    const std::vector<fr::coordinates::ecef_point> *points;
+    size_t next;
+    size_t calls;
+
+    size_t operator()(fr::coordinates::ecef_point *buffer, size_t max)
+    {
+      size_t want = 1 + (calls++ * 37) % max;
+      size_t n = std::min(want, points->size() - next);
+      std::copy(points->begin() + next, points->begin() + next + n, buffer);
+      next += n;
+      return n;
+    }
+  };
+
+public:
+
+  void setUp()
+  {
+    points.clear();
+    for (size_t i = 0; i < 10007; ++i) {
+      double lat = -90.0 + 180.0 * (double) ((i * 7919) % 10007) / 10007.0;
+      double lon = -180.0 + 360.0 * (double) ((i * 104729) % 10007) / 10007.0;
+      points.push_back(fr::coordinates::converter<fr::coordinates::ecef_point>()(fr::coordinates::lat_long(lat, lon, (double) (i % 1000))));
+    }
+  }
+
+  void test_each()
+  {
+    fr::coordinates::stream_converter<fr::coordinates::ecef_point, fr::coordinates::lat_long> stream(256);
+    source from = { &points, 0, 0 };
+    std::vector<fr::coordinates::lat_long> out;
+    fr::coordinates::stream_counters counters = stream.run(std::ref(from), [&](const fr::coordinates::lat_long *chunk, size_t count) {
+	CPPUNIT_ASSERT(count <= 256);
+	out.insert(out.end(), chunk, chunk + count);
+      });
+    CPPUNIT_ASSERT_EQUAL(points.size(), out.size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t) points.size(), counters.points);
+    CPPUNIT_ASSERT_EQUAL((uint64_t) from.calls - 1, counters.chunks);
+    CPPUNIT_ASSERT(counters.elapsed > 0.0);
+    CPPUNIT_ASSERT(counters.points_per_second() > 0.0);
+    CPPUNIT_ASSERT_EQUAL(2 * 256 * (sizeof(fr::coordinates::ecef_point) + sizeof(fr::coordinates::lat_long)), stream.buffer_bytes());
+    fr::coordinates::converter<fr::coordinates::lat_long> convert;
+    for (size_t i = 0; i < points.size(); ++i) {
+      fr::coordinates::lat_long expected = convert(points[i]);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_lat(), out[i].get_lat(), 0.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_long(), out[i].get_long(), 0.0);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.get_alt(), out[i].get_alt(), 0.0);
+    }
+  }
+
+  // ECI to ECEF at one time, through the batch converter, with a
+  // bigger ring
+  void test_chunk_converter()
+  {
+    double t = 1381968000.0;
+    std::vector<fr::coordinates::tod_eci_point> eci(points.size());
+    fr::coordinates::batch_converter<fr::coordinates::tod_eci_point>()(points.data(), eci.data(), points.size(), t);
+    fr::coordinates::eci_ecef_rotation r(t);
+    fr::coordinates::stream_converter<fr::coordinates::tod_eci_point, fr::coordinates::ecef_point> stream(1000, [&](const fr::coordinates::tod_eci_point *in, fr::coordinates::ecef_point *out, size_t count) {
+	fr::coordinates::batch_converter<fr::coordinates::ecef_point>()(in, out, count, r);
+      }, 4);
+    size_t next = 0;
+    std::vector<fr::coordinates::ecef_point> out;
+    stream.run([&](fr::coordinates::tod_eci_point *buffer, size_t max) {
+	size_t n = std::min(max, eci.size() - next);
+	std::copy(eci.begin() + next, eci.begin() + next + n, buffer);
+	next += n;
+	return n;
+      }, [&](const fr::coordinates::ecef_point *chunk, size_t count) {
+	out.insert(out.end(), chunk, chunk + count);
+      });
+    CPPUNIT_ASSERT_EQUAL(points.size(), out.size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t) 11, stream.get_counters().chunks);
+    for (size_t i = 0; i < points.size(); ++i) {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(points[i].x, out[i].x, .0001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(points[i].y, out[i].y, .0001);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(points[i].z, out[i].z, .0001);
+    }
+  }
+
+  void test_errors()
+  {
+    fr::coordinates::stream_converter<fr::coordinates::ecef_point, fr::coordinates::lat_long> stream(100);
+    source from = { &points, 0, 0 };
+    size_t chunks = 0;
+    CPPUNIT_ASSERT_THROW(stream.run(std::ref(from), [&](const fr::coordinates::lat_long *, size_t) {
+	  if (++chunks == 3) {
+	    throw std::runtime_error("disk full");
+	  }
+	}), std::runtime_error);
+    CPPUNIT_ASSERT_EQUAL((size_t) 3, chunks);
+    // A source error stops it too, and the stream can be run again
+    CPPUNIT_ASSERT_THROW(stream.run([](fr::coordinates::ecef_point *, size_t) -> size_t {
+	  throw std::runtime_error("connection lost");
+	}, [](const fr::coordinates::lat_long *, size_t) { }), std::runtime_error);
+    from.next = 0;
+    size_t total = 0;
+    stream.run(std::ref(from), [&](const fr::coordinates::lat_long *, size_t count) { total += count; });
+    CPPUNIT_ASSERT_EQUAL(points.size(), total);
+    // So does a source claiming more points than it was given room for
+    size_t sunk = 0;
+    CPPUNIT_ASSERT_THROW(stream.run([](fr::coordinates::ecef_point *, size_t max) -> size_t {
+	  return max + 1;
+	}, [&](const fr::coordinates::lat_long *, size_t count) { sunk += count; }), std::length_error);
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, sunk);
+
+    // Nothing to stream through without room in the ring
+    typedef fr::coordinates::stream_converter<fr::coordinates::ecef_point, fr::coordinates::lat_long> stream_type;
+    CPPUNIT_ASSERT_THROW(stream_type no_room(0), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(stream_type no_buffers(100, fr::coordinates::each_converter<fr::coordinates::lat_long>(), 0), std::invalid_argument);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(stream_converter_test);
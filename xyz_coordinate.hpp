@@ -102,9 +102,14 @@ namespace fr {
 
       virtual Eigen::Vector3d get_xyz() const
       {
-	Eigen::Vector3d retval;
-	retval << x,y,z;
-	return retval;
+	return Eigen::Vector3d(x, y, z);
+      }
+
+      // Read only view of the position, without the copy or the virtual
+      // call. The converters use this.
+      Eigen::Map<const Eigen::Vector3d> map_xyz() const
+      {
+	return Eigen::Map<const Eigen::Vector3d>(&x);
       }
 
     };
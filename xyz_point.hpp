@@ -0,0 +1,177 @@
+/**
+ * Plain value versions of the xyz coordinate classes. These carry the
+ * same frame distinction as ecef, tod_eci, ecef_vel and tod_eci_vel
+ * through a tag type instead of a class hierarchy, so there's no vptr.
+ * They're trivially copyable and standard layout, so a position is 24
+ * bytes, a position plus velocity is 48, arrays of them pack densely
+ * and can be memcpy'd or written to the wire as-is.
+ *
+ * The converter<> templates in converts.hpp accept and produce them.
+ * The component type defaults to double; the _f typedefs are float
+ * versions that the batch and parallel converters take as well.
+ *
+ * Copyright 2013 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <Eigen/Core>
+#include <type_traits>
+
+#ifndef _HPP_XYZ_POINT
+#define _HPP_XYZ_POINT
+
+namespace fr {
+
+  namespace coordinates {
+
+    // Frame tags
+    struct ecef_frame {
+    };
+
+    struct tod_eci_frame {
+    };
+
+    template <typename frame, typename scalar = double>
+    struct xyz_point {
+      typedef frame frame_type;
+      typedef scalar scalar_type;
+      typedef Eigen::Matrix<scalar,3,1> vector_type;
+      scalar x, y, z;
+
+      xyz_point() = default;
+
+      xyz_point(scalar x, scalar y, scalar z) : x(x), y(y), z(z)
+      {
+      }
+
+      // Same accessors as xyz_coordinate, so the converters can take
+      // either one
+
+      scalar get_x() const { return x; }
+      scalar get_y() const { return y; }
+      scalar get_z() const { return z; }
+
+      vector_type get_xyz() const
+      {
+	return vector_type(x, y, z);
+      }
+
+      // The point's own storage as a vector, for Eigen expressions that
+      // read or write it in place
+      Eigen::Map<const vector_type> map_xyz() const
+      {
+	return Eigen::Map<const vector_type>(&x);
+      }
+
+      Eigen::Map<vector_type> map_xyz()
+      {
+	return Eigen::Map<vector_type>(&x);
+      }
+
+    };
+
+    template <typename frame, typename scalar = double>
+    struct xyz_state {
+      typedef frame frame_type;
+      typedef scalar scalar_type;
+      typedef Eigen::Matrix<scalar,3,1> vector_type;
+      scalar x, y, z;
+      scalar dx, dy, dz;
+
+      xyz_state() = default;
+
+      xyz_state(scalar x, scalar y, scalar z, scalar dx, scalar dy, scalar dz) : x(x), y(y), z(z), dx(dx), dy(dy), dz(dz)
+      {
+      }
+
+      scalar get_x() const { return x; }
+      scalar get_y() const { return y; }
+      scalar get_z() const { return z; }
+      scalar get_dx() const { return dx; }
+      scalar get_dy() const { return dy; }
+      scalar get_dz() const { return dz; }
+
+      vector_type get_xyz() const
+      {
+	return vector_type(x, y, z);
+      }
+
+      vector_type get_deltas() const
+      {
+	return vector_type(dx, dy, dz);
+      }
+
+      Eigen::Matrix<scalar,6,1> get_vector() const
+      {
+	return map_vector();
+      }
+
+      Eigen::Map<const vector_type> map_xyz() const
+      {
+	return Eigen::Map<const vector_type>(&x);
+      }
+
+      Eigen::Map<vector_type> map_xyz()
+      {
+	return Eigen::Map<vector_type>(&x);
+      }
+
+      Eigen::Map<const vector_type> map_deltas() const
+      {
+	return Eigen::Map<const vector_type>(&dx);
+      }
+
+      Eigen::Map<vector_type> map_deltas()
+      {
+	return Eigen::Map<vector_type>(&dx);
+      }
+
+      Eigen::Map<const Eigen::Matrix<scalar,6,1> > map_vector() const
+      {
+	return Eigen::Map<const Eigen::Matrix<scalar,6,1> >(&x);
+      }
+
+      Eigen::Map<Eigen::Matrix<scalar,6,1> > map_vector()
+      {
+	return Eigen::Map<Eigen::Matrix<scalar,6,1> >(&x);
+      }
+
+    };
+
+    typedef xyz_point<ecef_frame> ecef_point;
+    typedef xyz_point<tod_eci_frame> tod_eci_point;
+    typedef xyz_state<ecef_frame> ecef_vel_point;
+    typedef xyz_state<tod_eci_frame> tod_eci_vel_point;
+
+    // Single precision versions, for display and other work where
+    // meter level accuracy is plenty. Absolute ECEF and ECI positions
+    // in a float are only good to about half a meter; the local origin
+    // batch conversions in batch_converts.hpp do much better. The
+    // batch rotation kernels take these and rotate in double.
+    typedef xyz_point<ecef_frame, float> ecef_point_f;
+    typedef xyz_point<tod_eci_frame, float> tod_eci_point_f;
+    typedef xyz_state<ecef_frame, float> ecef_vel_point_f;
+    typedef xyz_state<tod_eci_frame, float> tod_eci_vel_point_f;
+
+    static_assert(sizeof(ecef_point) == 3 * sizeof(double), "xyz_point should be packed");
+    static_assert(sizeof(ecef_vel_point) == 6 * sizeof(double), "xyz_state should be packed");
+    static_assert(std::is_trivially_copyable<ecef_point>::value && std::is_standard_layout<ecef_point>::value, "xyz_point should be memcpy-able");
+    static_assert(std::is_trivially_copyable<ecef_vel_point>::value && std::is_standard_layout<ecef_vel_point>::value, "xyz_state should be memcpy-able");
+    static_assert(sizeof(ecef_point_f) == 3 * sizeof(float) && sizeof(ecef_vel_point_f) == 6 * sizeof(float), "float points should be packed");
+
+  }
+
+}
+
+#endif
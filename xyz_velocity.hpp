@@ -66,9 +66,12 @@ namespace fr {
 
       Eigen::Vector3d get_deltas() const
       {
-	Eigen::Vector3d retval;
-	retval << dx,dy,dz;
-	return retval;
+	return Eigen::Vector3d(dx, dy, dz);
+      }
+
+      Eigen::Map<const Eigen::Vector3d> map_deltas() const
+      {
+	return Eigen::Map<const Eigen::Vector3d>(&dx);
       }
 
       Eigen::Matrix<double,6,1> get_vector() const